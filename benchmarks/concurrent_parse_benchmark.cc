@@ -0,0 +1,105 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "yafaray_xml_c_api.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <clocale>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Parses the same file many times from an increasing number of threads, checking that every parse succeeds and that the process locale is left untouched, and reporting how the throughput scales with the threads
+
+namespace
+{
+
+struct RunResult
+{
+	double seconds_ = 0.0;
+	size_t failed_parses_ = 0;
+};
+
+RunResult runParses_global(const std::string &file_path, size_t parses, size_t threads)
+{
+	std::atomic<size_t> next_parse{0};
+	std::atomic<size_t> failed_parses{0};
+	const auto parse_files = [&]()
+	{
+		yafaray_Logger *logger = yafaray_createLogger("", nullptr, nullptr, YAFARAY_DISPLAY_CONSOLE_HIDDEN);
+		while(next_parse++ < parses)
+		{
+			yafaray_Container *container = yafaray_xml_ParseFileWithOptions(logger, file_path.c_str(), "LinearRGB", 1.f, nullptr);
+			if(container) yafaray_destroyContainerAndContainedPointers(container);
+			else ++failed_parses;
+		}
+		yafaray_destroyLogger(logger);
+	};
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for(size_t thread_index = 0; thread_index < threads; ++thread_index) workers.emplace_back(parse_files);
+	for(auto &worker : workers) worker.join();
+	RunResult run_result;
+	run_result.seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	run_result.failed_parses_ = failed_parses;
+	return run_result;
+}
+
+} //namespace
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		std::cout << "Usage: " << argv[0] << " <xml file> [parses per run, 16 by default] [maximum threads, the hardware threads by default]" << std::endl;
+		return 1;
+	}
+	const std::string file_path{argv[1]};
+	const size_t parses = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+	const size_t max_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : std::max(1U, std::thread::hardware_concurrency());
+	const std::string numeric_locale{std::setlocale(LC_NUMERIC, nullptr)};
+
+	bool success = true;
+	double single_thread_seconds = 0.0;
+	std::vector<size_t> thread_counts;
+	for(size_t threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+	thread_counts.push_back(max_threads);
+	for(const size_t threads : thread_counts)
+	{
+		const RunResult run_result = runParses_global(file_path, parses, threads);
+		if(threads == 1) single_thread_seconds = run_result.seconds_;
+		std::cout << threads << " thread(s): " << parses << " parses in " << run_result.seconds_ << " s, " << parses / run_result.seconds_ << " parses/s, speedup " << single_thread_seconds / run_result.seconds_;
+		if(run_result.failed_parses_ > 0)
+		{
+			std::cout << ", " << run_result.failed_parses_ << " FAILED";
+			success = false;
+		}
+		std::cout << std::endl;
+	}
+	if(numeric_locale != std::setlocale(LC_NUMERIC, nullptr))
+	{
+		std::cout << "The numeric locale was changed from '" << numeric_locale << "' to '" << std::setlocale(LC_NUMERIC, nullptr) << "' while parsing" << std::endl;
+		success = false;
+	}
+	return success ? 0 : 1;
+}
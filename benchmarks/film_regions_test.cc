@@ -0,0 +1,115 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "film_regions.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+// Renders an XML file with the loader in a single process and split into regions rendered by several local processes, and checks that the merged image matches the single render pixel by pixel
+
+namespace
+{
+
+bool runProcess_global(std::vector<std::string> arguments)
+{
+	std::vector<char *> process_argv;
+	for(auto &argument : arguments) process_argv.push_back(&argument[0]);
+	process_argv.push_back(nullptr);
+	pid_t process_id;
+	if(posix_spawnp(&process_id, process_argv[0], nullptr, nullptr, process_argv.data(), environ) != 0) return false;
+	int status = 0;
+	return waitpid(process_id, &status, 0) == process_id && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+//! Renders the XML file with the loader, with all its film outputs writing to the image path given and the extra loader arguments
+bool render_global(const std::string &loader_path, const std::string &xml_file_path, const std::string &image_path, const std::vector<std::string> &extra_arguments)
+{
+	std::vector<std::string> arguments{loader_path, "-p", "film.output.image_path=" + image_path};
+	arguments.insert(arguments.end(), extra_arguments.begin(), extra_arguments.end());
+	arguments.push_back(xml_file_path);
+	return runProcess_global(arguments);
+}
+
+} //namespace
+
+int main(int argc, char *argv[])
+{
+	if(argc < 4)
+	{
+		std::cout << "Usage: " << argv[0] << " <loader executable> <xml file with a TGA output> <output directory> [regions, 3 by default] [extra loader arguments...]" << std::endl;
+		return 1;
+	}
+	const std::string loader_path{argv[1]};
+	const std::string xml_file_path{argv[2]};
+	const std::string output_directory{argv[3]};
+	const unsigned long regions = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 3;
+	const std::vector<std::string> extra_arguments(argv + std::min(argc, 5), argv + argc);
+	const std::string single_image_path{output_directory + "/film_regions_single.tga"};
+	const std::string regions_image_path{output_directory + "/film_regions_merged.tga"};
+	std::remove(single_image_path.c_str());
+	std::remove(regions_image_path.c_str());
+
+	if(!render_global(loader_path, xml_file_path, single_image_path, extra_arguments))
+	{
+		std::cout << "FAILED: the single process render failed" << std::endl;
+		return 1;
+	}
+	std::vector<std::string> regions_arguments{extra_arguments};
+	regions_arguments.push_back("--regions");
+	regions_arguments.push_back(std::to_string(regions));
+	if(!render_global(loader_path, xml_file_path, regions_image_path, regions_arguments))
+	{
+		std::cout << "FAILED: the render in " << regions << " region processes failed" << std::endl;
+		return 1;
+	}
+	TgaImage single_image, regions_image;
+	if(!readTga_global(single_image_path, single_image) || !readTga_global(regions_image_path, regions_image))
+	{
+		std::cout << "FAILED: cannot read the rendered images" << std::endl;
+		return 1;
+	}
+	if(single_image.width_ != regions_image.width_ || single_image.height_ != regions_image.height_ || single_image.bytes_per_pixel_ != regions_image.bytes_per_pixel_ || single_image.gray_ != regions_image.gray_)
+	{
+		std::cout << "FAILED: the merged image is " << regions_image.width_ << "x" << regions_image.height_ << " with " << regions_image.bytes_per_pixel_ << " bytes per pixel, the single render " << single_image.width_ << "x" << single_image.height_ << " with " << single_image.bytes_per_pixel_ << std::endl;
+		return 1;
+	}
+	size_t different_bytes = 0;
+	for(size_t index = 0; index < single_image.pixels_.size(); ++index)
+	{
+		if(single_image.pixels_[index] != regions_image.pixels_[index]) ++different_bytes;
+	}
+	if(different_bytes > 0)
+	{
+		std::cout << "FAILED: " << different_bytes << " of " << single_image.pixels_.size() << " bytes of the merged image differ from the single render" << std::endl;
+		return 1;
+	}
+	std::cout << "The image merged from " << regions << " region processes matches the single process render (" << single_image.width_ << "x" << single_image.height_ << ")" << std::endl;
+	std::remove(single_image_path.c_str());
+	std::remove(regions_image_path.c_str());
+	return 0;
+}
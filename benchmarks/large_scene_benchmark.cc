@@ -0,0 +1,189 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "yafaray_xml_c_api.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Generates an XML scene of at least the given size and parses it from a memory mapping through yafaray_xml_ParseMemoryWithOptions, reporting the throughput and the peak resident memory
+
+namespace
+{
+
+constexpr size_t grid_side_global = 64; //!< Vertices per side of the grid mesh of each generated object
+constexpr size_t mebibyte_global = 1024 * 1024;
+
+size_t fileSize_global(const std::string &file_path)
+{
+	struct stat file_stat{};
+	if(stat(file_path.c_str(), &file_stat) != 0) return 0;
+	return static_cast<size_t>(file_stat.st_size);
+}
+
+void writeObject_global(std::ofstream &file, size_t object_index)
+{
+	const size_t num_faces = 2 * (grid_side_global - 1) * (grid_side_global - 1);
+	file << "\t\t<object>\n\t\t\t<parameters name=\"Grid" << object_index << "\">\n";
+	file << "\t\t\t\t<num_faces ival=\"" << num_faces << "\"/>\n";
+	file << "\t\t\t\t<num_vertices ival=\"" << grid_side_global * grid_side_global << "\"/>\n";
+	file << "\t\t\t\t<type sval=\"mesh\"/>\n\t\t\t</parameters>\n";
+	const float offset = static_cast<float>(object_index % 1000) * 2.5f;
+	for(size_t y = 0; y < grid_side_global; ++y)
+	{
+		for(size_t x = 0; x < grid_side_global; ++x) file << "\t\t\t<p x=\"" << offset + static_cast<float>(x) * 0.03125f << "\" y=\"" << static_cast<float>(y) * 0.03125f << "\" z=\"" << static_cast<float>((x * y) % 7) * 0.015625f << "\"/>\n";
+	}
+	file << "\t\t\t<material_ref sval=\"GridMaterial\"/>\n";
+	for(size_t y = 0; y + 1 < grid_side_global; ++y)
+	{
+		for(size_t x = 0; x + 1 < grid_side_global; ++x)
+		{
+			const size_t vertex = y * grid_side_global + x;
+			file << "\t\t\t<f a=\"" << vertex << "\" b=\"" << vertex + 1 << "\" c=\"" << vertex + grid_side_global << "\"/>\n";
+			file << "\t\t\t<f a=\"" << vertex + 1 << "\" b=\"" << vertex + grid_side_global + 1 << "\" c=\"" << vertex + grid_side_global << "\"/>\n";
+		}
+	}
+	file << "\t\t</object>\n";
+}
+
+bool generateScene_global(const std::string &file_path, size_t minimum_size)
+{
+	std::ofstream file(file_path, std::ios::binary);
+	if(!file) return false;
+	file << "<?xml version=\"1.0\"?>\n<yafaray_container format_version=\"4.0.0\">\n\t<scene>\n\t\t<parameters name=\"scene\">\n\t\t</parameters>\n";
+	file << "\t\t<material name=\"GridMaterial\">\n\t\t\t<type sval=\"shinydiffusemat\"/>\n\t\t</material>\n";
+	for(size_t object_index = 0; static_cast<size_t>(file.tellp()) < minimum_size; ++object_index) writeObject_global(file, object_index);
+	file << "\t</scene>\n</yafaray_container>\n";
+	return static_cast<bool>(file);
+}
+
+struct MappedScene
+{
+	const char *data_ = nullptr;
+	size_t size_ = 0;
+	size_t released_ = 0; //!< Bytes at the start of the mapping already given back to the OS
+};
+
+//! Drops the pages of the mapping the parser has already read, so the peak resident memory reflects the parser and not the mapped input
+void releaseParsedPages_global(size_t bytes_parsed, size_t /*bytes_total*/, const char * /*scene_name*/, const char * /*object_name*/, void *callback_data)
+{
+	auto *mapped_scene = static_cast<MappedScene *>(callback_data);
+	const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	constexpr size_t margin = 64 * mebibyte_global;
+	if(bytes_parsed < margin) return;
+	const size_t release_end = (bytes_parsed - margin) / page_size * page_size;
+	if(release_end <= mapped_scene->released_) return;
+	madvise(const_cast<char *>(mapped_scene->data_) + mapped_scene->released_, release_end - mapped_scene->released_, MADV_DONTNEED);
+	mapped_scene->released_ = release_end;
+}
+
+size_t peakRssKib_global()
+{
+	rusage usage{};
+	if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+	return static_cast<size_t>(usage.ru_maxrss) / 1024;
+#else
+	return static_cast<size_t>(usage.ru_maxrss);
+#endif
+}
+
+double secondsSince_global(const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} //namespace
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		std::cout << "Usage: " << argv[0] << " <scene file> [minimum size in MiB, 4608 by default]" << std::endl;
+		std::cout << "Generates the scene file if it does not exist or is smaller than the size given, and parses it from memory" << std::endl;
+		return 1;
+	}
+	const std::string file_path{argv[1]};
+	const size_t minimum_size = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4608) * mebibyte_global;
+
+	if(fileSize_global(file_path) < minimum_size)
+	{
+		const auto generation_start = std::chrono::steady_clock::now();
+		if(!generateScene_global(file_path, minimum_size))
+		{
+			std::cerr << "Could not write the scene file '" << file_path << "'" << std::endl;
+			return 1;
+		}
+		std::cout << "Generated '" << file_path << "' in " << secondsSince_global(generation_start) << " s" << std::endl;
+	}
+
+	MappedScene mapped_scene;
+	mapped_scene.size_ = fileSize_global(file_path);
+	const int file_descriptor = open(file_path.c_str(), O_RDONLY);
+	if(file_descriptor < 0)
+	{
+		std::cerr << "Could not open the scene file '" << file_path << "'" << std::endl;
+		return 1;
+	}
+	void *mapping = mmap(nullptr, mapped_scene.size_, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+	if(mapping == MAP_FAILED)
+	{
+		std::cerr << "Could not map the scene file '" << file_path << "'" << std::endl;
+		return 1;
+	}
+	mapped_scene.data_ = static_cast<const char *>(mapping);
+	madvise(mapping, mapped_scene.size_, MADV_SEQUENTIAL);
+
+	yafaray_Logger *logger = yafaray_createLogger("", nullptr, nullptr, YAFARAY_DISPLAY_CONSOLE_NORMAL);
+	yafaray_setConsoleVerbosityLevel(logger, YAFARAY_LOG_LEVEL_WARNING);
+	yafaray_xml_ParseOptions *parse_options = yafaray_xml_createParseOptions();
+	yafaray_xml_setParseOptionProgressCallback(parse_options, releaseParsedPages_global, &mapped_scene);
+
+	const size_t peak_rss_before_kib = peakRssKib_global();
+	const auto parse_start = std::chrono::steady_clock::now();
+	yafaray_Container *container = yafaray_xml_ParseMemoryWithOptions(logger, mapped_scene.data_, mapped_scene.size_, "LinearRGB", 1.f, parse_options);
+	const double parse_seconds = secondsSince_global(parse_start);
+	const size_t peak_rss_kib = peakRssKib_global();
+
+	std::cout << "Parsed " << mapped_scene.size_ << " bytes (" << mapped_scene.size_ / mebibyte_global << " MiB) in " << parse_seconds << " s: " << static_cast<double>(mapped_scene.size_) / mebibyte_global / parse_seconds << " MiB/s" << std::endl;
+	std::cout << "Peak resident memory: " << peak_rss_kib / 1024 << " MiB (" << peak_rss_before_kib / 1024 << " MiB before parsing)" << std::endl;
+
+	yafaray_xml_destroyParseOptions(parse_options);
+	munmap(mapping, mapped_scene.size_);
+	const bool parsed = (container != nullptr);
+	if(container) yafaray_destroyContainerAndContainedPointers(container);
+	yafaray_destroyLogger(logger);
+	if(!parsed)
+	{
+		std::cerr << "The scene could not be parsed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
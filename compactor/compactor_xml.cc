@@ -0,0 +1,161 @@
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "yafaray_xml_c_api.h"
+#include "command_line_parser.h"
+#include "scene_compactor.h"
+#include "scene_fingerprint.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+
+//! Sends the elements read to two handlers, so the original scene is compacted and fingerprinted reading it only once
+class ElementHandlerPair final : public XmlElementHandler
+{
+	public:
+		ElementHandlerPair(XmlElementHandler &first, XmlElementHandler &second) : first_{first}, second_{second} { }
+		void startElement(const char *element, const char **attrs) override { first_.startElement(element, attrs); second_.startElement(element, attrs); }
+		void endElement(const char *element) override { first_.endElement(element); second_.endElement(element); }
+
+	private:
+		XmlElementHandler &first_;
+		XmlElementHandler &second_;
+};
+
+std::string directoryOf(const std::string &file_path)
+{
+	return std::filesystem::path{file_path}.parent_path().string();
+}
+
+uintmax_t fileSize(const std::string &file_path)
+{
+	std::error_code file_size_error;
+	const uintmax_t file_size = std::filesystem::file_size(file_path, file_size_error);
+	return file_size_error ? 0 : file_size;
+}
+
+void removeOutputFiles(const std::string &xml_file_path, const std::string &sidecar_file_path)
+{
+	std::error_code remove_error;
+	std::filesystem::remove(xml_file_path, remove_error);
+	if(!sidecar_file_path.empty()) std::filesystem::remove(sidecar_file_path, remove_error);
+}
+
+} //namespace
+
+int main(int argc, char *argv[])
+{
+	CliParser parse(argc, argv, 2, 0, "You need to set the input and the output XML files.");
+
+	char *version_string = yafaray_xml_getVersionString();
+	const std::string version{version_string};
+	yafaray_xml_destroyCharString(version_string);
+	parse.setAppName("YafaRay XML compactor v" + version,
+					 std::string{"[OPTIONS]... <input xml file> <output xml file>\n"}
+					 + "<input xml file> : A valid yafaray XML file\n"
+					 + "<output xml file> : The XML file to write, with the points, normals, uvs, faces and instances packed in compact blocks and without duplicated materials, images and textures\n"
+					 + "*Note: comments in the input XML file are not kept.");
+
+	parse.setOption("v", "version", true, "Displays this program's version.");
+	parse.setOption("h", "help", true, "Displays this help text.");
+	parse.setOption("b", "binary", true, "If specified, the packed values are written to a binary sidecar file named as the output XML file plus \".bin\" instead of as text in the XML file");
+	parse.setOption("q", "quantize", true, "If specified, points and uvs are written as 16 bit integers within the range of each block, normals with 32 bit octahedral encoding and, in the binary sidecar file, faces with 16 bit indices when possible. The largest errors are reported");
+	parse.setOption("nc", "no-check", true, "If specified, the compacted scene is not read back to check it loads exactly the same as the input scene (except for the values quantized, if quantizing)");
+
+	const bool parse_ok = parse.parseCommandLine();
+	if(!parse_ok)
+	{
+		parse.printError();
+		parse.printUsage();
+		return 0;
+	}
+	else if(parse.isFlagSet("h"))
+	{
+		parse.printUsage();
+		return 0;
+	}
+	else if(parse.isFlagSet("v"))
+	{
+		std::cout << "YafaRay XML compactor (LibYafaRay-Xml v" << version << ")" << std::endl;
+		return 0;
+	}
+
+	const std::vector<std::string> files = parse.getCleanArgs();
+	if(files.size() < 2) return 0;
+	const std::string &input_file_path{files.at(0)};
+	const std::string &output_file_path{files.at(1)};
+	std::error_code equivalent_error;
+	if(std::filesystem::equivalent(input_file_path, output_file_path, equivalent_error))
+	{
+		std::cerr << "Error: the output XML file cannot be the input XML file" << std::endl;
+		return 1;
+	}
+	const bool binary = parse.isFlagSet("b");
+	const bool quantize = parse.isFlagSet("q");
+	const std::string sidecar_file_path{binary ? output_file_path + ".bin" : ""};
+
+	std::ofstream xml_output{output_file_path};
+	std::ofstream sidecar_output;
+	if(binary) sidecar_output.open(sidecar_file_path, std::ios::binary);
+	if(!xml_output || (binary && !sidecar_output))
+	{
+		std::cerr << "Error: cannot create the output file '" << (xml_output ? sidecar_file_path : output_file_path) << "'" << std::endl;
+		return 1;
+	}
+
+	//The sidecar is referenced by its file name only, as it is always next to the XML file
+	SceneCompactor scene_compactor{xml_output, binary ? &sidecar_output : nullptr, std::filesystem::path{sidecar_file_path}.filename().string(), directoryOf(input_file_path), quantize};
+	SceneFingerprint input_fingerprint{directoryOf(input_file_path), !quantize};
+	ElementHandlerPair input_handlers{scene_compactor, input_fingerprint};
+	std::string error_message;
+	const bool read_ok = readXmlFile_global(input_file_path, input_handlers, error_message);
+	const bool input_blocks_ok = read_ok && scene_compactor.finish();
+	xml_output.close();
+	if(binary) sidecar_output.close();
+	if(!read_ok || !input_blocks_ok || !xml_output || (binary && !sidecar_output))
+	{
+		if(!read_ok) std::cerr << "Error reading the input XML file '" << input_file_path << "': " << error_message << std::endl;
+		else if(!input_blocks_ok) std::cerr << "Error: the input XML file '" << input_file_path << "' has malformed compact blocks or their binary files cannot be read" << std::endl;
+		else std::cerr << "Error writing the output files" << std::endl;
+		removeOutputFiles(output_file_path, sidecar_file_path);
+		return 1;
+	}
+
+	const CompactorStatistics &statistics = scene_compactor.getStatistics();
+	std::cout << "Packed " << statistics.items_packed_ << " points, normals, uvs, faces and instances in " << statistics.blocks_written_ << " blocks, removed " << statistics.elements_removed_ << " duplicated materials, images and textures" << std::endl;
+	if(quantize) std::cout << "Quantization largest errors: points " << statistics.max_point_error_ << ", normals " << statistics.max_normal_error_degrees_ << " degrees, uvs " << statistics.max_uv_error_ << std::endl;
+
+	if(!parse.isFlagSet("nc"))
+	{
+		SceneFingerprint output_fingerprint{directoryOf(output_file_path), !quantize};
+		const bool output_read_ok = readXmlFile_global(output_file_path, output_fingerprint, error_message);
+		if(!output_read_ok || !output_fingerprint.blocksOk() || output_fingerprint.getHash() != input_fingerprint.getHash() || output_fingerprint.getNumberOfEntries() != input_fingerprint.getNumberOfEntries())
+		{
+			std::cerr << "Error: the compacted scene does not load the same as the input scene" << (output_read_ok ? "" : " (" + error_message + ")") << ", removing the output files" << std::endl;
+			removeOutputFiles(output_file_path, sidecar_file_path);
+			return 1;
+		}
+		std::cout << "Round-trip check passed, " << output_fingerprint.getNumberOfEntries() << " elements and items load the same" << std::endl;
+	}
+
+	const uintmax_t output_size = fileSize(output_file_path) + (binary ? fileSize(sidecar_file_path) : 0);
+	std::cout << "Size: " << fileSize(input_file_path) << " bytes -> " << output_size << " bytes" << std::endl;
+	return 0;
+}
@@ -0,0 +1,434 @@
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scene_compactor.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+using namespace yafaray_xml;
+
+namespace
+{
+
+constexpr double degrees_per_radian = 57.29577951308232;
+
+//! Appends the shortest text that reads back as exactly the same value
+template<typename T>
+void appendNumber(std::string &text, T value)
+{
+	char buffer[64];
+#if defined(__cpp_lib_to_chars)
+	const auto [number_end, error_code]{std::to_chars(buffer, buffer + sizeof(buffer), value)};
+	text.append(buffer, number_end);
+#else //Standard libraries without floating point std::to_chars support
+	if constexpr(std::is_integral_v<T>)
+	{
+		const auto [number_end, error_code]{std::to_chars(buffer, buffer + sizeof(buffer), value)};
+		text.append(buffer, number_end);
+	}
+	else
+	{
+		const int length = std::snprintf(buffer, sizeof(buffer), "%.*g", std::numeric_limits<T>::max_digits10, static_cast<double>(value));
+		text.append(buffer, static_cast<size_t>(length));
+	}
+#endif
+}
+
+template<typename T>
+void appendNumbers(std::string &text, const std::vector<T> &values)
+{
+	for(const T &value : values)
+	{
+		if(!text.empty()) text += ' ';
+		appendNumber(text, value);
+	}
+}
+
+std::string escapeAttributeValue(const std::string &value)
+{
+	std::string escaped_value;
+	escaped_value.reserve(value.size());
+	for(const char character : value)
+	{
+		switch(character)
+		{
+			case '&': escaped_value += "&amp;"; break;
+			case '<': escaped_value += "&lt;"; break;
+			case '>': escaped_value += "&gt;"; break;
+			case '"': escaped_value += "&quot;"; break;
+			case '\t': escaped_value += "&#9;"; break;
+			case '\n': escaped_value += "&#10;"; break;
+			case '\r': escaped_value += "&#13;"; break;
+			default: escaped_value += character;
+		}
+	}
+	return escaped_value;
+}
+
+const char *blockElement(SceneItem::Type type)
+{
+	switch(type)
+	{
+		case SceneItem::Type::Point: return "points";
+		case SceneItem::Type::Normal: return "normals";
+		case SceneItem::Type::Uv: return "uvs";
+		case SceneItem::Type::Face: return "faces";
+		case SceneItem::Type::Instance:
+		default: return "instances";
+	}
+}
+
+} //namespace
+
+SceneCompactor::SceneCompactor(std::ostream &xml_output, std::ostream *sidecar_output, std::string sidecar_file_name, const std::string &input_directory, bool quantize) : xml_output_{xml_output}, sidecar_output_{sidecar_output}, sidecar_file_name_{std::move(sidecar_file_name)}, input_directory_{input_directory}, quantize_{quantize}
+{
+	xml_output_ << "<?xml version=\"1.0\"?>\n";
+}
+
+void SceneCompactor::startElement(const char *element, const char **attrs)
+{
+	if(capture_ != Capture::None)
+	{
+		captured_events_.push_back(XmlEvent::start(element, attrs));
+		open_elements_.push_back({element, false});
+		return;
+	}
+	const std::string parent_element = open_elements_.empty() ? std::string{} : open_elements_.back().element_;
+	if(parent_element == "object" && readObjectItem_global(element, attrs, item_))
+	{
+		addItem(item_);
+		open_elements_.push_back({element, false});
+		return;
+	}
+	else if(isCompactBlock_global(element) && parent_element == (strcmp(element, "instances") ? "object" : "scene"))
+	{
+		//Blocks already present are unpacked and packed again, so their items can be merged with the surrounding ones and sidecar files are rewritten
+		if(!expandBlock_global(element, attrs, input_directory_, [this](const SceneItem &item) { addItem(item); })) input_blocks_ok_ = false;
+		open_elements_.push_back({element, false});
+		return;
+	}
+	else if(parent_element == "scene" && (!strcmp(element, "instance") || ElementDeduplicator::isDeduplicable(element)))
+	{
+		capture_ = strcmp(element, "instance") ? Capture::Deduplicable : Capture::Instance;
+		capture_level_ = open_elements_.size();
+		captured_events_.clear();
+		captured_events_.push_back(XmlEvent::start(element, attrs));
+		open_elements_.push_back({element, false});
+		return;
+	}
+	flushBlock();
+	if(!strcmp(element, "scene")) deduplicator_.clear();
+	XmlEvent event{XmlEvent::start(element, attrs)};
+	writeEvent(event);
+	open_elements_.push_back({element, true});
+}
+
+void SceneCompactor::endElement(const char *element)
+{
+	const bool written = open_elements_.back().written_;
+	open_elements_.pop_back();
+	if(capture_ != Capture::None)
+	{
+		captured_events_.push_back(XmlEvent::end(element));
+		if(open_elements_.size() == capture_level_) processCapturedElement();
+	}
+	else if(written)
+	{
+		flushBlock();
+		writeEndTag(element);
+	}
+}
+
+bool SceneCompactor::finish()
+{
+	flushBlock();
+	xml_output_.flush();
+	if(sidecar_output_) sidecar_output_->flush();
+	return input_blocks_ok_;
+}
+
+void SceneCompactor::processCapturedElement()
+{
+	const Capture capture = capture_;
+	capture_ = Capture::None;
+	if(capture == Capture::Instance && readInstanceItem_global(captured_events_, item_))
+	{
+		addItem(item_);
+		return;
+	}
+	flushBlock();
+	if(capture == Capture::Deduplicable && !deduplicator_.deduplicate(captured_events_).empty())
+	{
+		++statistics_.elements_removed_;
+		return;
+	}
+	for(auto &event : captured_events_) writeEvent(event);
+}
+
+bool SceneCompactor::blockAccepts(const SceneItem &item) const
+{
+	if(item.type_ != block_key_.type_) return false;
+	switch(item.type_)
+	{
+		case SceneItem::Type::Point: return item.orco_ == block_key_.orco_ && item.time_step_ == block_key_.time_step_;
+		case SceneItem::Type::Normal: return item.time_step_ == block_key_.time_step_;
+		case SceneItem::Type::Face: return item.uvs_.empty() == block_key_.uvs_.empty();
+		case SceneItem::Type::Instance: return item.object_ == block_key_.object_ && item.time_ == block_key_.time_;
+		case SceneItem::Type::Uv:
+		default: return true;
+	}
+}
+
+void SceneCompactor::addItem(const SceneItem &item)
+{
+	if(block_count_ > 0 && !blockAccepts(item)) flushBlock();
+	if(block_count_ == 0) block_key_ = item;
+	switch(item.type_)
+	{
+		case SceneItem::Type::Point: appendValues(item.values_, item.orco_ ? 6 : 3); break;
+		case SceneItem::Type::Normal: appendValues(item.values_, 3); break;
+		case SceneItem::Type::Uv: appendValues(item.values_, 2); break;
+		case SceneItem::Type::Face:
+		{
+			const auto number_of_vertices = static_cast<int>(item.vertices_.size());
+			appendValues(&number_of_vertices, 1);
+			appendValues(item.vertices_.data(), item.vertices_.size());
+			appendValues(item.uvs_.data(), item.uvs_.size());
+			break;
+		}
+		case SceneItem::Type::Instance: appendValues(item.matrix_, SceneItem::matrix_size); break;
+	}
+	++block_count_;
+	++statistics_.items_packed_;
+	if(block_count_ == block_items_max_) flushBlock();
+}
+
+template<typename T>
+void SceneCompactor::appendValues(const T *values, size_t number_of_values)
+{
+	if(sidecar_output_ || quantize_) //Quantization needs all the block values first
+	{
+		if constexpr(std::is_same_v<T, float>) block_float_values_.insert(block_float_values_.end(), values, values + number_of_values);
+		else if constexpr(std::is_same_v<T, int>) block_int_values_.insert(block_int_values_.end(), values, values + number_of_values);
+		else block_double_values_.insert(block_double_values_.end(), values, values + number_of_values);
+		return;
+	}
+	for(size_t index = 0; index < number_of_values; ++index)
+	{
+		if(!block_text_values_.empty()) block_text_values_ += ' ';
+		appendNumber(block_text_values_, values[index]);
+	}
+}
+
+void SceneCompactor::flushBlock()
+{
+	if(block_count_ == 0) return;
+	if(quantize_) quantizeBlock();
+	closePendingStartTag();
+	writeIndentation();
+	xml_output_ << '<' << blockElement(block_key_.type_) << " count=\"" << block_count_ << '"';
+	switch(block_key_.type_)
+	{
+		case SceneItem::Type::Point:
+			if(block_key_.orco_) xml_output_ << " orco=\"true\"";
+			if(block_key_.time_step_ != 0) xml_output_ << " time_step=\"" << block_key_.time_step_ << '"';
+			break;
+		case SceneItem::Type::Normal:
+			if(block_key_.time_step_ != 0) xml_output_ << " time_step=\"" << block_key_.time_step_ << '"';
+			break;
+		case SceneItem::Type::Face:
+			if(!block_key_.uvs_.empty()) xml_output_ << " uv=\"true\"";
+			break;
+		case SceneItem::Type::Instance:
+		{
+			xml_output_ << " object=\"" << escapeAttributeValue(block_key_.object_) << '"';
+			if(block_key_.time_ != 0.f)
+			{
+				std::string time;
+				appendNumber(time, block_key_.time_);
+				xml_output_ << " time=\"" << time << '"';
+			}
+			break;
+		}
+		case SceneItem::Type::Uv:
+		default: break;
+	}
+	if(block_encoding_ != compact_geometry::Encoding::None) xml_output_ << " encoding=\"" << compact_geometry::encodingName(block_encoding_) << '"';
+	if(block_encoding_ == compact_geometry::Encoding::Unorm16) xml_output_ << " min=\"" << block_range_min_ << "\" max=\"" << block_range_max_ << '"';
+	if(sidecar_output_)
+	{
+		size_t number_of_values, value_size;
+		if(!block_float_values_.empty()) { compact_geometry::writeBinaryValues(*sidecar_output_, block_float_values_); number_of_values = block_float_values_.size(); value_size = sizeof(float); }
+		else if(!block_int_values_.empty())
+		{
+			number_of_values = block_int_values_.size();
+			switch(block_encoding_)
+			{
+				case compact_geometry::Encoding::Unorm16:
+				case compact_geometry::Encoding::Index16: compact_geometry::writeBinaryValuesAs<uint16_t>(*sidecar_output_, block_int_values_); value_size = sizeof(uint16_t); break;
+				case compact_geometry::Encoding::Octahedral16: compact_geometry::writeBinaryValuesAs<int8_t>(*sidecar_output_, block_int_values_); value_size = sizeof(int8_t); break;
+				case compact_geometry::Encoding::Octahedral32: compact_geometry::writeBinaryValuesAs<int16_t>(*sidecar_output_, block_int_values_); value_size = sizeof(int16_t); break;
+				default: compact_geometry::writeBinaryValues(*sidecar_output_, block_int_values_); value_size = sizeof(int32_t); break;
+			}
+		}
+		else { compact_geometry::writeBinaryValues(*sidecar_output_, block_double_values_); number_of_values = block_double_values_.size(); value_size = sizeof(double); }
+		xml_output_ << " file=\"" << escapeAttributeValue(sidecar_file_name_) << "\" offset=\"" << sidecar_offset_ << "\" size=\"" << number_of_values << '"';
+		sidecar_offset_ += number_of_values * value_size;
+		block_float_values_.clear();
+		block_int_values_.clear();
+		block_double_values_.clear();
+	}
+	else
+	{
+		if(quantize_)
+		{
+			appendNumbers(block_text_values_, block_float_values_);
+			appendNumbers(block_text_values_, block_int_values_);
+			appendNumbers(block_text_values_, block_double_values_);
+			block_float_values_.clear();
+			block_int_values_.clear();
+			block_double_values_.clear();
+		}
+		xml_output_ << " v=\"" << block_text_values_ << '"';
+		block_text_values_.clear();
+	}
+	xml_output_ << "/>\n";
+	block_count_ = 0;
+	++statistics_.blocks_written_;
+}
+
+void SceneCompactor::quantizeBlock()
+{
+	//The quantized values are decoded with the same functions libYafaRay-Xml uses, to measure the exact error of the values it will load
+	block_encoding_ = compact_geometry::Encoding::None;
+	const bool all_finite = std::all_of(block_float_values_.begin(), block_float_values_.end(), [](float value) { return std::isfinite(value); });
+	if(block_key_.type_ == SceneItem::Type::Point || block_key_.type_ == SceneItem::Type::Uv)
+	{
+		if(!all_finite) return;
+		const size_t number_of_components = block_key_.type_ == SceneItem::Type::Point ? (block_key_.orco_ ? 6 : 3) : 2;
+		float range_min[6], range_max[6];
+		std::copy_n(block_float_values_.begin(), number_of_components, range_min);
+		std::copy_n(block_float_values_.begin(), number_of_components, range_max);
+		for(size_t index = 0; index < block_float_values_.size(); ++index)
+		{
+			const size_t component = index % number_of_components;
+			range_min[component] = std::min(range_min[component], block_float_values_[index]);
+			range_max[component] = std::max(range_max[component], block_float_values_[index]);
+		}
+		float &max_error = block_key_.type_ == SceneItem::Type::Point ? statistics_.max_point_error_ : statistics_.max_uv_error_;
+		block_int_values_.clear();
+		for(size_t index = 0; index < block_float_values_.size(); ++index)
+		{
+			const size_t component = index % number_of_components;
+			const int quantized_value = compact_geometry::quantizeUnorm16(block_float_values_[index], range_min[component], range_max[component]);
+			max_error = std::max(max_error, std::abs(compact_geometry::dequantizeUnorm16(quantized_value, range_min[component], range_max[component]) - block_float_values_[index]));
+			block_int_values_.push_back(quantized_value);
+		}
+		block_range_min_.clear();
+		block_range_max_.clear();
+		for(size_t component = 0; component < number_of_components; ++component)
+		{
+			if(component > 0) { block_range_min_ += ' '; block_range_max_ += ' '; }
+			appendNumber(block_range_min_, range_min[component]);
+			appendNumber(block_range_max_, range_max[component]);
+		}
+		block_encoding_ = compact_geometry::Encoding::Unorm16;
+		block_float_values_.clear();
+	}
+	else if(block_key_.type_ == SceneItem::Type::Normal)
+	{
+		if(!all_finite) return;
+		block_int_values_.clear();
+		for(size_t index = 0; index < block_float_values_.size(); index += 3)
+		{
+			const float *normal = &block_float_values_[index];
+			int quantized_values[2];
+			float decoded_normal[3];
+			compact_geometry::encodeOctahedral(normal, compact_geometry::octahedral32_max, quantized_values);
+			compact_geometry::decodeOctahedral(quantized_values, compact_geometry::octahedral32_max, decoded_normal);
+			if(normal[0] != 0.f || normal[1] != 0.f || normal[2] != 0.f) //Zero normals cannot keep their direction anyway
+			{
+				//Angle from the cross and dot products, as acos is too imprecise for the tiny angles expected
+				const double cross[3] = {
+					static_cast<double>(normal[1]) * decoded_normal[2] - static_cast<double>(normal[2]) * decoded_normal[1],
+					static_cast<double>(normal[2]) * decoded_normal[0] - static_cast<double>(normal[0]) * decoded_normal[2],
+					static_cast<double>(normal[0]) * decoded_normal[1] - static_cast<double>(normal[1]) * decoded_normal[0]};
+				const double dot = static_cast<double>(normal[0]) * decoded_normal[0] + static_cast<double>(normal[1]) * decoded_normal[1] + static_cast<double>(normal[2]) * decoded_normal[2];
+				const double angle = std::atan2(std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot);
+				statistics_.max_normal_error_degrees_ = std::max(statistics_.max_normal_error_degrees_, static_cast<float>(angle * degrees_per_radian));
+			}
+			block_int_values_.insert(block_int_values_.end(), quantized_values, quantized_values + 2);
+		}
+		block_encoding_ = compact_geometry::Encoding::Octahedral32;
+		block_float_values_.clear();
+	}
+	else if(block_key_.type_ == SceneItem::Type::Face && sidecar_output_)
+	{
+		//Only the sidecar file gets smaller with 16 bit indices, in text they are written the same
+		if(std::all_of(block_int_values_.begin(), block_int_values_.end(), [](int value) { return value >= 0 && value <= compact_geometry::unorm16_max; })) block_encoding_ = compact_geometry::Encoding::Index16;
+	}
+}
+
+void SceneCompactor::writeEvent(XmlEvent &event)
+{
+	deduplicator_.resolveNameAliases(event);
+	if(event.start_) writeStartTag(event.element_, event.attributes_);
+	else writeEndTag(event.element_);
+}
+
+void SceneCompactor::writeStartTag(const std::string &element, const XmlAttributes_t &attributes)
+{
+	closePendingStartTag();
+	writeIndentation();
+	xml_output_ << '<' << element;
+	for(const auto &[name, value] : attributes) xml_output_ << ' ' << name << "=\"" << escapeAttributeValue(value) << '"';
+	start_tag_pending_ = true;
+	++output_level_;
+}
+
+void SceneCompactor::writeEndTag(const std::string &element)
+{
+	--output_level_;
+	if(start_tag_pending_)
+	{
+		xml_output_ << "/>\n";
+		start_tag_pending_ = false;
+	}
+	else
+	{
+		writeIndentation();
+		xml_output_ << "</" << element << ">\n";
+	}
+}
+
+void SceneCompactor::closePendingStartTag()
+{
+	if(!start_tag_pending_) return;
+	xml_output_ << ">\n";
+	start_tag_pending_ = false;
+}
+
+void SceneCompactor::writeIndentation()
+{
+	for(int level = 0; level < output_level_; ++level) xml_output_ << '\t';
+}
@@ -0,0 +1,96 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_XML_COMPACTOR_SCENE_COMPACTOR_H
+#define LIBYAFARAY_XML_COMPACTOR_SCENE_COMPACTOR_H
+
+#include "scene_items.h"
+#include "common/compact_geometry.h"
+#include <ostream>
+
+//! Statistics about the changes made by the scene compactor
+struct CompactorStatistics
+{
+	size_t items_packed_ = 0; //!< Points, normals, uvs, faces and instances written in compact blocks
+	size_t blocks_written_ = 0;
+	size_t elements_removed_ = 0; //!< Duplicated materials, images and textures removed
+	float max_point_error_ = 0.f; //!< Largest difference between a quantized point coordinate (or orco) and the original one
+	float max_normal_error_degrees_ = 0.f; //!< Largest angle between a quantized normal and the original one
+	float max_uv_error_ = 0.f;
+};
+
+//! Rewrites the XML scene read with packed geometry and instance blocks and without duplicated materials, images and textures. Other elements are written unchanged (comments are not kept)
+class SceneCompactor final : public XmlElementHandler
+{
+	public:
+		//! If the sidecar stream is not null, the packed values are written to it in binary form instead of as text in the XML file. If quantize is true, points, normals and uvs (and faces in the sidecar file) are written with quantized encodings
+		SceneCompactor(std::ostream &xml_output, std::ostream *sidecar_output, std::string sidecar_file_name, const std::string &input_directory, bool quantize);
+		void startElement(const char *element, const char **attrs) override;
+		void endElement(const char *element) override;
+		//! Writes the last pending block, to be called once the whole file has been read. Returns false if a compact block in the input file could not be expanded
+		[[nodiscard]] bool finish();
+		[[nodiscard]] const CompactorStatistics &getStatistics() const { return statistics_; }
+
+	private:
+		struct OpenElement
+		{
+			std::string element_;
+			bool written_ = true;
+		};
+		enum class Capture : unsigned char { None, Instance, Deduplicable };
+		static constexpr size_t block_items_max_ = 65536; //!< Limit so blocks (and the memory needed to decode them) stay reasonably small
+		void addItem(const SceneItem &item);
+		[[nodiscard]] bool blockAccepts(const SceneItem &item) const;
+		void flushBlock();
+		void quantizeBlock();
+		void processCapturedElement();
+		void writeEvent(XmlEvent &event);
+		void writeStartTag(const std::string &element, const XmlAttributes_t &attributes);
+		void writeEndTag(const std::string &element);
+		void closePendingStartTag();
+		void writeIndentation();
+		template<typename T> void appendValues(const T *values, size_t number_of_values);
+		std::ostream &xml_output_;
+		std::ostream *sidecar_output_ = nullptr;
+		const std::string sidecar_file_name_;
+		const std::string input_directory_;
+		const bool quantize_ = false;
+		size_t sidecar_offset_ = 0;
+		std::vector<OpenElement> open_elements_;
+		int output_level_ = 0;
+		bool start_tag_pending_ = false; //!< Whether the last start tag written is still open, to be written as an empty element if it has no children
+		Capture capture_ = Capture::None;
+		size_t capture_level_ = 0;
+		std::vector<XmlEvent> captured_events_;
+		SceneItem item_;
+		SceneItem block_key_; //!< First item in the block being built, which has the attributes shared by the whole block
+		size_t block_count_ = 0;
+		std::string block_text_values_;
+		std::vector<float> block_float_values_;
+		std::vector<int> block_int_values_;
+		std::vector<double> block_double_values_;
+		yafaray_xml::compact_geometry::Encoding block_encoding_ = yafaray_xml::compact_geometry::Encoding::None;
+		std::string block_range_min_;
+		std::string block_range_max_;
+		ElementDeduplicator deduplicator_;
+		bool input_blocks_ok_ = true;
+		CompactorStatistics statistics_;
+};
+
+#endif //LIBYAFARAY_XML_COMPACTOR_SCENE_COMPACTOR_H
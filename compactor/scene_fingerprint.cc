@@ -0,0 +1,143 @@
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scene_fingerprint.h"
+#include <cstring>
+
+void SceneFingerprint::startElement(const char *element, const char **attrs)
+{
+	if(capture_ != Capture::None)
+	{
+		captured_events_.push_back(XmlEvent::start(element, attrs));
+		open_elements_.push_back({element, false});
+		return;
+	}
+	const std::string parent_element = open_elements_.empty() ? std::string{} : open_elements_.back().element_;
+	open_elements_.push_back({element, false});
+	if(parent_element == "object" && readObjectItem_global(element, attrs, item_)) addItem(item_);
+	else if(isCompactBlock_global(element) && parent_element == (strcmp(element, "instances") ? "object" : "scene"))
+	{
+		if(!expandBlock_global(element, attrs, document_directory_, [this](const SceneItem &item) { addItem(item); })) blocks_ok_ = false;
+	}
+	else if(parent_element == "scene" && (!strcmp(element, "instance") || ElementDeduplicator::isDeduplicable(element)))
+	{
+		capture_ = strcmp(element, "instance") ? Capture::Deduplicable : Capture::Instance;
+		capture_level_ = open_elements_.size() - 1;
+		captured_events_.clear();
+		captured_events_.push_back(XmlEvent::start(element, attrs));
+	}
+	else
+	{
+		if(!strcmp(element, "scene")) deduplicator_.clear();
+		XmlEvent event{XmlEvent::start(element, attrs)};
+		addEvent(event);
+		open_elements_.back().hashed_ = true;
+	}
+}
+
+void SceneFingerprint::endElement(const char *element)
+{
+	const bool hashed = open_elements_.back().hashed_;
+	open_elements_.pop_back();
+	if(capture_ != Capture::None)
+	{
+		captured_events_.push_back(XmlEvent::end(element));
+		if(open_elements_.size() == capture_level_) processCapturedElement();
+	}
+	else if(hashed)
+	{
+		XmlEvent event{XmlEvent::end(element)};
+		addEvent(event);
+	}
+}
+
+void SceneFingerprint::processCapturedElement()
+{
+	const Capture capture = capture_;
+	capture_ = Capture::None;
+	if(capture == Capture::Instance && readInstanceItem_global(captured_events_, item_)) addItem(item_);
+	else if(capture == Capture::Deduplicable && !deduplicator_.deduplicate(captured_events_).empty()) return;
+	else for(auto &event : captured_events_) addEvent(event);
+}
+
+void SceneFingerprint::addEvent(XmlEvent &event)
+{
+	deduplicator_.resolveNameAliases(event);
+	addString(event.start_ ? "<" : ">");
+	addString(event.element_);
+	for(const auto &[name, value] : event.attributes_)
+	{
+		addString(name);
+		addString(value);
+	}
+	++number_of_entries_;
+}
+
+void SceneFingerprint::addItem(const SceneItem &item)
+{
+	//Values are hashed as the numbers libYafaRay-Xml would pass to libYafaRay, not as the text written in the file
+	addBytes(&item.type_, sizeof(item.type_));
+	switch(item.type_)
+	{
+		case SceneItem::Type::Point:
+			addBytes(&item.orco_, sizeof(item.orco_));
+			addBytes(&item.time_step_, sizeof(item.time_step_));
+			if(hash_quantized_values_) addBytes(item.values_, (item.orco_ ? 6 : 3) * sizeof(float));
+			break;
+		case SceneItem::Type::Normal:
+			addBytes(&item.time_step_, sizeof(item.time_step_));
+			if(hash_quantized_values_) addBytes(item.values_, 3 * sizeof(float));
+			break;
+		case SceneItem::Type::Uv:
+			if(hash_quantized_values_) addBytes(item.values_, 2 * sizeof(float));
+			break;
+		case SceneItem::Type::Face:
+		{
+			const size_t number_of_vertices = item.vertices_.size();
+			const size_t number_of_uvs = item.uvs_.size();
+			addBytes(&number_of_vertices, sizeof(number_of_vertices));
+			addBytes(&number_of_uvs, sizeof(number_of_uvs));
+			addBytes(item.vertices_.data(), number_of_vertices * sizeof(int));
+			addBytes(item.uvs_.data(), number_of_uvs * sizeof(int));
+			break;
+		}
+		case SceneItem::Type::Instance:
+			addString(item.object_);
+			addBytes(&item.time_, sizeof(item.time_));
+			addBytes(item.matrix_, sizeof(item.matrix_));
+			break;
+	}
+	++number_of_entries_;
+}
+
+void SceneFingerprint::addString(const std::string &string)
+{
+	const size_t size = string.size();
+	addBytes(&size, sizeof(size)); //So the boundaries between strings are part of the hash
+	addBytes(string.data(), size);
+}
+
+void SceneFingerprint::addBytes(const void *bytes, size_t size)
+{
+	const auto *byte = static_cast<const unsigned char *>(bytes);
+	for(size_t index = 0; index < size; ++index)
+	{
+		hash_ ^= byte[index];
+		hash_ *= 1099511628211ull;
+	}
+}
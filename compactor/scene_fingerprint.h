@@ -0,0 +1,63 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_XML_COMPACTOR_SCENE_FINGERPRINT_H
+#define LIBYAFARAY_XML_COMPACTOR_SCENE_FINGERPRINT_H
+
+#include "scene_items.h"
+#include <cstdint>
+
+//! Hashes what libYafaRay-Xml would load from a XML scene, regardless of whether its items are written one per element or packed in compact blocks and of its duplicated materials, images and textures, so a compacted scene can be checked against the original one
+class SceneFingerprint final : public XmlElementHandler
+{
+	public:
+		//! If hash_quantized_values is false, the values of points, normals and uvs are not hashed, to check scenes compacted with quantized values (whose error is measured when quantizing them)
+		explicit SceneFingerprint(std::string document_directory, bool hash_quantized_values = true) : document_directory_{std::move(document_directory)}, hash_quantized_values_{hash_quantized_values} { }
+		void startElement(const char *element, const char **attrs) override;
+		void endElement(const char *element) override;
+		[[nodiscard]] uint64_t getHash() const { return hash_; }
+		[[nodiscard]] size_t getNumberOfEntries() const { return number_of_entries_; }
+		[[nodiscard]] bool blocksOk() const { return blocks_ok_; }
+
+	private:
+		struct OpenElement
+		{
+			std::string element_;
+			bool hashed_ = false;
+		};
+		enum class Capture : unsigned char { None, Instance, Deduplicable };
+		void addEvent(XmlEvent &event);
+		void addItem(const SceneItem &item);
+		void addBytes(const void *bytes, size_t size);
+		void addString(const std::string &string);
+		void processCapturedElement();
+		const std::string document_directory_;
+		const bool hash_quantized_values_ = true;
+		std::vector<OpenElement> open_elements_;
+		Capture capture_ = Capture::None;
+		size_t capture_level_ = 0;
+		std::vector<XmlEvent> captured_events_;
+		SceneItem item_;
+		ElementDeduplicator deduplicator_;
+		uint64_t hash_ = 14695981039346656037ull; //!< 64 bit FNV-1a hash
+		size_t number_of_entries_ = 0;
+		bool blocks_ok_ = true;
+};
+
+#endif //LIBYAFARAY_XML_COMPACTOR_SCENE_FINGERPRINT_H
@@ -0,0 +1,282 @@
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scene_items.h"
+#include "common/compact_geometry.h"
+#include "common/string_to_number.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+using namespace yafaray_xml;
+
+namespace
+{
+
+void clearItem(SceneItem &item, SceneItem::Type type)
+{
+	item.type_ = type;
+	item.orco_ = false;
+	item.time_step_ = 0;
+	std::fill(std::begin(item.values_), std::end(item.values_), 0.f);
+	item.vertices_.clear();
+	item.uvs_.clear();
+}
+
+bool readPoint(const char **attrs, SceneItem &item)
+{
+	clearItem(item, SceneItem::Type::Point);
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		const char *name = attrs[0];
+		if(name[0] == 'o' && name[1] >= 'x' && name[1] <= 'z' && name[2] == '\0')
+		{
+			item.orco_ = true;
+			item.values_[3 + name[1] - 'x'] = string_to_number::toFloat(attrs[1]);
+		}
+		else if(name[0] >= 'x' && name[0] <= 'z' && name[1] == '\0') item.values_[name[0] - 'x'] = string_to_number::toFloat(attrs[1]);
+		else if(name[0] == 's' && name[1] == '\0') item.time_step_ = string_to_number::toInt(attrs[1]);
+		else return false;
+	}
+	return true;
+}
+
+bool readNormal(const char **attrs, SceneItem &item)
+{
+	clearItem(item, SceneItem::Type::Normal);
+	int number_of_components_read = 0;
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		const char *name = attrs[0];
+		if(name[0] >= 'x' && name[0] <= 'z' && name[1] == '\0') item.values_[name[0] - 'x'] = string_to_number::toFloat(attrs[1]);
+		else if(name[0] == 's' && name[1] == '\0') item.time_step_ = string_to_number::toInt(attrs[1]);
+		else return false;
+		++number_of_components_read;
+	}
+	return number_of_components_read == 3 || number_of_components_read == 4; //Otherwise libYafaRay-Xml skips the normal
+}
+
+bool readUv(const char **attrs, SceneItem &item)
+{
+	clearItem(item, SceneItem::Type::Uv);
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		const char *name = attrs[0];
+		if(name[0] >= 'u' && name[0] <= 'v' && name[1] == '\0') item.values_[name[0] - 'u'] = string_to_number::toFloat(attrs[1]);
+		else return false;
+	}
+	return true;
+}
+
+bool readIndexedFace(const char **attrs, SceneItem &item)
+{
+	const char *indices = nullptr;
+	const char *uv_indices = nullptr;
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		if(!strcmp(attrs[0], "indices")) indices = attrs[1];
+		else if(!strcmp(attrs[0], "uv_indices")) uv_indices = attrs[1];
+		else return false;
+	}
+	if(!string_to_number::readAll(indices, item.vertices_)) return false;
+	if(uv_indices && (!string_to_number::readAll(uv_indices, item.uvs_) || item.uvs_.size() != item.vertices_.size())) return false; //libYafaRay-Xml skips the face, keep it as it is
+	return item.vertices_.size() >= 3;
+}
+
+bool readFace(const char **attrs, SceneItem &item)
+{
+	clearItem(item, SceneItem::Type::Face);
+	for(const char **attribute = attrs; attribute && attribute[0]; attribute += 2)
+	{
+		if(!strcmp(attribute[0], "indices")) return readIndexedFace(attrs, item);
+	}
+	constexpr int number_of_corner_letters = 'z' - 'a' + 1;
+	int corner_vertices[number_of_corner_letters];
+	int corner_uvs[number_of_corner_letters];
+	uint32_t vertices_read = 0, uvs_read = 0;
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		const bool is_uv = !strncmp(attrs[0], "uv_", 3);
+		const char *corner_name = is_uv ? attrs[0] + 3 : attrs[0];
+		if(corner_name[0] < 'a' || corner_name[0] > 'z' || corner_name[1] != '\0') return false;
+		const int corner = corner_name[0] - 'a';
+		if(is_uv) { corner_uvs[corner] = string_to_number::toInt(attrs[1]); uvs_read |= 1u << corner; }
+		else { corner_vertices[corner] = string_to_number::toInt(attrs[1]); vertices_read |= 1u << corner; }
+	}
+	if(uvs_read != 0 && uvs_read != vertices_read) return false; //libYafaRay-Xml ignores the uvs of the face, keep it as it is
+	//Corners in letter order, as libYafaRay-Xml reads them
+	for(int corner = 0; corner < number_of_corner_letters; ++corner)
+	{
+		if(!(vertices_read & (1u << corner))) continue;
+		item.vertices_.push_back(corner_vertices[corner]);
+		if(uvs_read) item.uvs_.push_back(corner_uvs[corner]);
+	}
+	return item.vertices_.size() >= 3;
+}
+
+template<typename T>
+bool decodeBlockValues(const compact_geometry::Block &block, const std::string &base_directory, size_t values_per_item, std::vector<T> &values)
+{
+	bool values_ok;
+	if constexpr(std::is_same_v<T, float>) values_ok = compact_geometry::decodeFloatValues(block, base_directory, values_per_item, values);
+	else values_ok = compact_geometry::decodeValues(block, base_directory, values);
+	return values_ok && values.size() == block.count_ * values_per_item;
+}
+
+} //namespace
+
+bool readObjectItem_global(const char *element, const char **attrs, SceneItem &item)
+{
+	if(!strcmp(element, "p")) return readPoint(attrs, item);
+	else if(!strcmp(element, "n")) return readNormal(attrs, item);
+	else if(!strcmp(element, "uv")) return readUv(attrs, item);
+	else if(!strcmp(element, "f")) return readFace(attrs, item);
+	else return false;
+}
+
+bool readInstanceItem_global(const std::vector<XmlEvent> &events, SceneItem &item)
+{
+	if(events.size() != 6 || !events[0].attributes_.empty()) return false;
+	const XmlEvent &object_ref = events[1];
+	const XmlEvent &matrix = events[3];
+	if(object_ref.element_ != "object_ref" || object_ref.attributes_.size() != 1 || object_ref.attributes_[0].first != "name" || events[2].start_) return false;
+	if(matrix.element_ != "matrix" || !matrix.start_ || events[4].start_) return false;
+	clearItem(item, SceneItem::Type::Instance);
+	item.object_ = object_ref.attributes_[0].second;
+	item.time_ = 0.f;
+	unsigned int matrix_elements_read = 0;
+	for(const auto &[name, value] : matrix.attributes_)
+	{
+		if(name == "time") item.time_ = string_to_number::toFloat(value.c_str());
+		else if(name.size() == 3 && name[0] == 'm' && name[1] >= '0' && name[1] <= '3' && name[2] >= '0' && name[2] <= '3')
+		{
+			const int index = (name[1] - '0') * 4 + (name[2] - '0');
+			item.matrix_[index] = string_to_number::toDouble(value.c_str());
+			matrix_elements_read |= 1u << index;
+		}
+		else return false;
+	}
+	return matrix_elements_read == 0xFFFFu;
+}
+
+bool isCompactBlock_global(const char *element)
+{
+	return !strcmp(element, "points") || !strcmp(element, "normals") || !strcmp(element, "uvs") || !strcmp(element, "faces") || !strcmp(element, "instances");
+}
+
+bool expandBlock_global(const char *element, const char **attrs, const std::string &base_directory, const std::function<void(const SceneItem &item)> &item_callback)
+{
+	const compact_geometry::Block block{compact_geometry::parseBlock(attrs)};
+	SceneItem item;
+	if(!strcmp(element, "faces"))
+	{
+		std::vector<int> values;
+		if(!compact_geometry::decodeValues(block, base_directory, values) || !compact_geometry::checkFaces(block, values)) return false;
+		clearItem(item, SceneItem::Type::Face);
+		for(size_t position = 0; position < values.size();)
+		{
+			const auto number_of_vertices = static_cast<size_t>(values[position]);
+			const auto vertices_begin = values.begin() + static_cast<std::ptrdiff_t>(position + 1);
+			item.vertices_.assign(vertices_begin, vertices_begin + static_cast<std::ptrdiff_t>(number_of_vertices));
+			if(block.uv_) item.uvs_.assign(vertices_begin + static_cast<std::ptrdiff_t>(number_of_vertices), vertices_begin + static_cast<std::ptrdiff_t>(2 * number_of_vertices));
+			item_callback(item);
+			position += 1 + number_of_vertices * (block.uv_ ? 2 : 1);
+		}
+	}
+	else if(!strcmp(element, "instances"))
+	{
+		std::vector<double> values;
+		if(!block.object_ || !decodeBlockValues(block, base_directory, compact_geometry::values_per_instance, values)) return false;
+		clearItem(item, SceneItem::Type::Instance);
+		item.object_ = block.object_;
+		item.time_ = block.time_;
+		for(size_t position = 0; position < values.size(); position += compact_geometry::values_per_instance)
+		{
+			std::copy_n(values.begin() + static_cast<std::ptrdiff_t>(position), SceneItem::matrix_size, item.matrix_);
+			item_callback(item);
+		}
+	}
+	else
+	{
+		SceneItem::Type type;
+		size_t values_per_item;
+		if(!strcmp(element, "points")) { type = SceneItem::Type::Point; values_per_item = compact_geometry::valuesPerPoint(block); }
+		else if(!strcmp(element, "normals")) { type = SceneItem::Type::Normal; values_per_item = 3; }
+		else if(!strcmp(element, "uvs")) { type = SceneItem::Type::Uv; values_per_item = 2; }
+		else return false;
+		std::vector<float> values;
+		if(!decodeBlockValues(block, base_directory, values_per_item, values)) return false;
+		clearItem(item, type);
+		item.orco_ = type == SceneItem::Type::Point && block.orco_;
+		item.time_step_ = type == SceneItem::Type::Uv ? 0 : block.time_step_;
+		for(size_t position = 0; position < values.size(); position += values_per_item)
+		{
+			std::copy_n(values.begin() + static_cast<std::ptrdiff_t>(position), values_per_item, item.values_);
+			item_callback(item);
+		}
+	}
+	return true;
+}
+
+bool ElementDeduplicator::isDeduplicable(const std::string &element)
+{
+	return element == "material" || element == "image" || element == "texture";
+}
+
+std::string ElementDeduplicator::deduplicate(const std::vector<XmlEvent> &events)
+{
+	const XmlEvent &element_event = events.front();
+	if(element_event.attributes_.empty() || element_event.attributes_[0].first != "name") return {}; //Elements without name are kept as they are
+	std::string fingerprint = element_event.element_ + '\x1d';
+	for(auto event = events.begin() + 1; event != events.end(); ++event)
+	{
+		if(!event->start_) continue;
+		fingerprint += event->element_;
+		for(const auto &[name, value] : event->attributes_)
+		{
+			fingerprint += '\x1f';
+			fingerprint += name;
+			fingerprint += '=';
+			fingerprint += resolveNameAlias(value);
+		}
+		fingerprint += '\x1e';
+	}
+	const std::string &element_name = element_event.attributes_[0].second;
+	const auto [element_fingerprint, inserted]{element_fingerprints_.emplace(std::move(fingerprint), element_name)};
+	if(inserted) return {};
+	name_aliases_[element_name] = element_fingerprint->second;
+	return element_fingerprint->second;
+}
+
+void ElementDeduplicator::resolveNameAliases(XmlEvent &event) const
+{
+	if(name_aliases_.empty() || !event.start_ || event.attributes_.empty()) return;
+	//Same references resolved by libYafaRay-Xml: string parameters and material references
+	if(event.element_ == "material_ref" || (event.attributes_.size() == 1 && event.attributes_[0].first == "sval"))
+	{
+		event.attributes_[0].second = resolveNameAlias(event.attributes_[0].second);
+	}
+}
+
+const std::string &ElementDeduplicator::resolveNameAlias(const std::string &name) const
+{
+	const auto name_alias{name_aliases_.find(name)};
+	if(name_alias == name_aliases_.end()) return name;
+	else return name_alias->second;
+}
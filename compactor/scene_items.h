@@ -0,0 +1,71 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_XML_COMPACTOR_SCENE_ITEMS_H
+#define LIBYAFARAY_XML_COMPACTOR_SCENE_ITEMS_H
+
+#include "xml_file_reader.h"
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! A single point, normal, uv, face or instance, whether it was written as its own element or packed in a compact block
+struct SceneItem
+{
+	enum class Type : unsigned char { Point, Normal, Uv, Face, Instance };
+	static constexpr int matrix_size = 16;
+	Type type_ = Type::Point;
+	bool orco_ = false;
+	int time_step_ = 0;
+	float values_[6] = {}; //!< x, y, z and orco x, y, z for points, x, y, z for normals and u, v for uvs
+	std::vector<int> vertices_;
+	std::vector<int> uvs_;
+	std::string object_;
+	float time_ = 0.f;
+	double matrix_[matrix_size] = {};
+};
+
+//! Reads a <p>, <n>, <uv> or <f> element of an object as libYafaRay-Xml does. Returns false if it is not one of them or it has attributes that must be kept as they are
+bool readObjectItem_global(const char *element, const char **attrs, SceneItem &item);
+//! Reads an <instance> element made just of an <object_ref> and a single <matrix>, which can be packed in an <instances> block. Returns false for any other instance
+bool readInstanceItem_global(const std::vector<XmlEvent> &events, SceneItem &item);
+//! Whether the element is a compact block that can be expanded with expandBlock_global
+bool isCompactBlock_global(const char *element);
+//! Sends each item packed in a compact block to the callback. Returns false if the block is malformed or its binary sidecar file cannot be read
+bool expandBlock_global(const char *element, const char **attrs, const std::string &base_directory, const std::function<void(const SceneItem &item)> &item_callback);
+
+//! Removes the materials, images and textures with the same parameters as another one in the same scene, with the same rules libYafaRay-Xml uses when loading a scene
+class ElementDeduplicator final
+{
+	public:
+		[[nodiscard]] static bool isDeduplicable(const std::string &element);
+		void clear() { element_fingerprints_.clear(); name_aliases_.clear(); }
+		//! Receives all the events of an element. Returns the name of an element with the same parameters seen before, to be used instead, or an empty string if it is the first one
+		[[nodiscard]] std::string deduplicate(const std::vector<XmlEvent> &events);
+		//! Replaces in the event the names of removed elements by the names of the elements used instead
+		void resolveNameAliases(XmlEvent &event) const;
+
+	private:
+		[[nodiscard]] const std::string &resolveNameAlias(const std::string &name) const;
+		std::unordered_map<std::string, std::string> element_fingerprints_;
+		std::unordered_map<std::string, std::string> name_aliases_;
+};
+
+#endif //LIBYAFARAY_XML_COMPACTOR_SCENE_ITEMS_H
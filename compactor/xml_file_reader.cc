@@ -0,0 +1,107 @@
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "xml_file_reader.h"
+#include <libxml/parser.h>
+
+namespace
+{
+
+void startElement(void *user_data, const xmlChar *name, const xmlChar **attrs)
+{
+	static_cast<XmlElementHandler *>(user_data)->startElement(reinterpret_cast<const char *>(name), reinterpret_cast<const char **>(attrs));
+}
+
+void endElement(void *user_data, const xmlChar *name)
+{
+	static_cast<XmlElementHandler *>(user_data)->endElement(reinterpret_cast<const char *>(name));
+}
+
+//! Errors are taken from the parser context once parsing stops, instead of being printed by libxml2 as they happen
+void ignoreMessage(void * /*user_data*/, const char * /*msg*/, ...) { }
+
+std::string lastErrorMessage(xmlParserCtxtPtr xml_parser_context)
+{
+	const xmlError *error = xmlCtxtGetLastError(xml_parser_context);
+	if(!error) return "unknown error";
+	std::string message = "line " + std::to_string(error->line) + ": " + (error->message ? error->message : "unknown error");
+	while(!message.empty() && message.back() == '\n') message.pop_back();
+	return message;
+}
+
+} //namespace
+
+XmlEvent XmlEvent::start(const char *element, const char **attrs)
+{
+	XmlEvent event;
+	event.element_ = element;
+	for(; attrs && attrs[0]; attrs += 2) event.attributes_.emplace_back(attrs[0], attrs[1] ? attrs[1] : "");
+	return event;
+}
+
+XmlEvent XmlEvent::end(const char *element)
+{
+	XmlEvent event;
+	event.start_ = false;
+	event.element_ = element;
+	return event;
+}
+
+bool readXmlFile_global(const std::string &xml_file_path, XmlElementHandler &handler, std::string &error_message)
+{
+	xmlInitParser();
+	xmlParserInputBufferPtr xml_input_buffer{xmlParserInputBufferCreateFilename(xml_file_path.c_str(), XML_CHAR_ENCODING_NONE)};
+	if(!xml_input_buffer || !xml_input_buffer->readcallback)
+	{
+		if(xml_input_buffer) xmlFreeParserInputBuffer(xml_input_buffer);
+		error_message = "cannot open the file";
+		return false;
+	}
+	xmlSAXHandler sax_handler{};
+	sax_handler.startElement = startElement;
+	sax_handler.endElement = endElement;
+	sax_handler.warning = ignoreMessage;
+	sax_handler.error = ignoreMessage;
+	sax_handler.fatalError = ignoreMessage;
+	xmlParserCtxtPtr xml_parser_context = xmlCreatePushParserCtxt(&sax_handler, &handler, nullptr, 0, xml_file_path.c_str());
+	if(!xml_parser_context)
+	{
+		xmlFreeParserInputBuffer(xml_input_buffer);
+		error_message = "cannot create the XML parser";
+		return false;
+	}
+	xmlCtxtUseOptions(xml_parser_context, XML_PARSE_HUGE);
+	constexpr int chunk_size_max = 4 * 1024 * 1024;
+	std::vector<char> chunk(chunk_size_max);
+	bool parse_ok = true;
+	int chunk_size;
+	while(parse_ok && (chunk_size = xml_input_buffer->readcallback(xml_input_buffer->context, chunk.data(), chunk_size_max)) > 0)
+	{
+		parse_ok = xmlParseChunk(xml_parser_context, chunk.data(), chunk_size, 0) == 0;
+	}
+	if(parse_ok && chunk_size < 0)
+	{
+		parse_ok = false;
+		error_message = "error reading the file";
+	}
+	else if(parse_ok) parse_ok = xmlParseChunk(xml_parser_context, nullptr, 0, 1) == 0 && xml_parser_context->wellFormed;
+	if(!parse_ok && error_message.empty()) error_message = lastErrorMessage(xml_parser_context);
+	xmlFreeParserCtxt(xml_parser_context);
+	xmlFreeParserInputBuffer(xml_input_buffer);
+	return parse_ok;
+}
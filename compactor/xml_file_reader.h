@@ -0,0 +1,51 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_XML_COMPACTOR_XML_FILE_READER_H
+#define LIBYAFARAY_XML_COMPACTOR_XML_FILE_READER_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::vector<std::pair<std::string, std::string>> XmlAttributes_t;
+
+//! Receives the elements read from a XML file, in document order
+class XmlElementHandler
+{
+	public:
+		virtual ~XmlElementHandler() = default;
+		virtual void startElement(const char *element, const char **attrs) = 0;
+		virtual void endElement(const char *element) = 0;
+};
+
+//! A start or end tag stored to be processed later, for example once the whole element it belongs to has been read
+struct XmlEvent
+{
+	static XmlEvent start(const char *element, const char **attrs);
+	static XmlEvent end(const char *element);
+	bool start_ = true;
+	std::string element_;
+	XmlAttributes_t attributes_;
+};
+
+//! Reads a XML file in chunks with the libxml2 SAX front end, like libYafaRay-Xml does, sending its elements to the handler. Returns false and sets the error message if the file cannot be read or is not well formed
+bool readXmlFile_global(const std::string &xml_file_path, XmlElementHandler &handler, std::string &error_message);
+
+#endif //LIBYAFARAY_XML_COMPACTOR_XML_FILE_READER_H
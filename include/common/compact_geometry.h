@@ -0,0 +1,344 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_COMPACT_GEOMETRY_H
+#define LIBYAFARAY_XML_COMPACT_GEOMETRY_H
+
+#include "common/string_to_number.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace yafaray_xml::compact_geometry
+{
+
+//! Quantized encodings of the block values
+enum class Encoding : unsigned char
+{
+	None,
+	Unorm16, //!< Points and uvs as 16 bit unsigned integers in the range given by the min="..." max="..." attributes, one value per component
+	Octahedral16, //!< Normals as two 8 bit signed integers (octahedral mapping)
+	Octahedral32, //!< Normals as two 16 bit signed integers (octahedral mapping)
+	Index16, //!< Faces as 16 bit unsigned integers, for meshes with less than 65536 vertices and uvs
+	Unknown
+};
+
+/*! Compact elements pack many points, normals, uvs, faces or instances in a single element, instead of one element per item:
+ *   <points count="N" [orco="true"] [time_step="T"] v="x y z [ox oy oz] ..."/>
+ *   <normals count="N" [time_step="T"] v="x y z ..."/>
+ *   <uvs count="N" v="u v ..."/>
+ *   <faces count="N" [uv="true"] v="3 a b c [ua ub uc] 4 a b c d [ua ub uc ud] ..."/>
+ *   <instances count="N" object="name" [time="t"] v="m00 m01 ... m33 ..."/>
+ * Instead of the "v" attribute, the values can be stored in a binary sidecar file with file="path" offset="bytes" size="number of values",
+ * as little-endian 32 bit floats for points, normals and uvs, 32 bit integers for faces and 64 bit floats for instances.
+ * Relative sidecar paths are relative to the XML file directory.
+ * The values can be quantized with encoding="unorm16|oct16|oct32|index16" (see Encoding), stored as integers both in the "v" attribute and in the sidecar file */
+struct Block
+{
+	size_t count_ = 0;
+	bool orco_ = false;
+	bool uv_ = false;
+	int time_step_ = 0;
+	float time_ = 0.f;
+	const char *object_ = nullptr;
+	const char *values_ = nullptr;
+	const char *file_ = nullptr;
+	size_t offset_ = 0;
+	size_t size_ = 0;
+	Encoding encoding_ = Encoding::None;
+	const char *range_min_ = nullptr;
+	const char *range_max_ = nullptr;
+};
+
+//! Largest integers used by the quantized encodings
+inline constexpr int unorm16_max = 65535;
+inline constexpr int octahedral16_max = 127;
+inline constexpr int octahedral32_max = 32767;
+
+inline Encoding parseEncoding(const char *name)
+{
+	if(!strcmp(name, "unorm16")) return Encoding::Unorm16;
+	else if(!strcmp(name, "oct16")) return Encoding::Octahedral16;
+	else if(!strcmp(name, "oct32")) return Encoding::Octahedral32;
+	else if(!strcmp(name, "index16")) return Encoding::Index16;
+	else return Encoding::Unknown;
+}
+
+inline const char *encodingName(Encoding encoding)
+{
+	switch(encoding)
+	{
+		case Encoding::Unorm16: return "unorm16";
+		case Encoding::Octahedral16: return "oct16";
+		case Encoding::Octahedral32: return "oct32";
+		case Encoding::Index16: return "index16";
+		default: return "";
+	}
+}
+
+//! Values stored for each matrix in an instances block
+inline constexpr size_t values_per_instance = 16;
+
+inline size_t valuesPerPoint(const Block &block) { return block.orco_ ? 6 : 3; }
+
+inline Block parseBlock(const char **attrs)
+{
+	Block block;
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		const char *value = attrs[1] ? attrs[1] : "";
+		if(!strcmp(attrs[0], "v")) block.values_ = value;
+		else if(!strcmp(attrs[0], "count")) block.count_ = static_cast<size_t>(std::strtoull(value, nullptr, 10));
+		else if(!strcmp(attrs[0], "orco")) block.orco_ = !strcmp(value, "true");
+		else if(!strcmp(attrs[0], "uv")) block.uv_ = !strcmp(value, "true");
+		else if(!strcmp(attrs[0], "time_step")) block.time_step_ = string_to_number::toInt(value);
+		else if(!strcmp(attrs[0], "time")) block.time_ = string_to_number::toFloat(value);
+		else if(!strcmp(attrs[0], "object")) block.object_ = value;
+		else if(!strcmp(attrs[0], "file")) block.file_ = value;
+		else if(!strcmp(attrs[0], "offset")) block.offset_ = static_cast<size_t>(std::strtoull(value, nullptr, 10));
+		else if(!strcmp(attrs[0], "size")) block.size_ = static_cast<size_t>(std::strtoull(value, nullptr, 10));
+		else if(!strcmp(attrs[0], "encoding")) block.encoding_ = parseEncoding(value);
+		else if(!strcmp(attrs[0], "min")) block.range_min_ = value;
+		else if(!strcmp(attrs[0], "max")) block.range_max_ = value;
+	}
+	return block;
+}
+
+inline bool isLittleEndianHost()
+{
+	const uint16_t probe = 1;
+	uint8_t first_byte;
+	std::memcpy(&first_byte, &probe, 1);
+	return first_byte == 1;
+}
+
+//! Binary type stored in sidecar files for each value type
+template<typename T> struct BinaryType { using Type_t = T; };
+template<> struct BinaryType<int> { using Type_t = int32_t; };
+
+//! Path of a sidecar file, with relative paths resolved against the XML file directory
+inline std::filesystem::path sidecarFilePath(const char *file, const std::string &base_directory)
+{
+	std::filesystem::path file_path{file};
+	if(file_path.is_relative() && !base_directory.empty()) file_path = std::filesystem::path{base_directory} / file_path;
+	return file_path;
+}
+
+//! Reads the block values from its binary sidecar file, stored as Binary_t values
+template<typename Binary_t, typename T, typename Allocator_t>
+inline bool readBinaryValues(const Block &block, const std::string &base_directory, std::vector<T, Allocator_t> &values)
+{
+	const std::filesystem::path file_path{sidecarFilePath(block.file_, base_directory)};
+	std::error_code error_code;
+	const uintmax_t file_size{std::filesystem::file_size(file_path, error_code)};
+	if(error_code || block.offset_ > file_size || block.size_ > (file_size - block.offset_) / sizeof(Binary_t)) return false; //Checked before allocating, as the size comes from the XML document
+	std::ifstream file{file_path, std::ios::binary};
+	if(!file.seekg(static_cast<std::streamoff>(block.offset_))) return false;
+	std::vector<Binary_t, typename std::allocator_traits<Allocator_t>::template rebind_alloc<Binary_t>> binary_values(block.size_, values.get_allocator());
+	if(!file.read(reinterpret_cast<char *>(binary_values.data()), static_cast<std::streamsize>(block.size_ * sizeof(Binary_t)))) return false;
+	const bool swap_bytes = !isLittleEndianHost();
+	values.reserve(block.size_);
+	for(Binary_t binary_value : binary_values)
+	{
+		if(swap_bytes)
+		{
+			auto *bytes = reinterpret_cast<uint8_t *>(&binary_value);
+			for(size_t byte = 0; byte < sizeof(Binary_t) / 2; ++byte) std::swap(bytes[byte], bytes[sizeof(Binary_t) - 1 - byte]);
+		}
+		values.push_back(static_cast<T>(binary_value));
+	}
+	return true;
+}
+
+//! Decodes all the values in the block, from its "v" attribute or from its binary sidecar file. Returns false if they cannot be decoded. Quantized values are returned as they are stored, use decodeFloatValues to dequantize them
+template<typename T, typename Allocator_t>
+inline bool decodeValues(const Block &block, const std::string &base_directory, std::vector<T, Allocator_t> &values)
+{
+	values.clear();
+	if constexpr(!std::is_same_v<T, int>)
+	{
+		if(block.encoding_ != Encoding::None) return false; //Quantized values are always integers
+	}
+	if(block.values_) return string_to_number::readAll(block.values_, values);
+	else if(block.file_)
+	{
+		if constexpr(std::is_same_v<T, int>)
+		{
+			switch(block.encoding_)
+			{
+				case Encoding::Unorm16:
+				case Encoding::Index16: return readBinaryValues<uint16_t>(block, base_directory, values);
+				case Encoding::Octahedral16: return readBinaryValues<int8_t>(block, base_directory, values);
+				case Encoding::Octahedral32: return readBinaryValues<int16_t>(block, base_directory, values);
+				default: break;
+			}
+		}
+		return readBinaryValues<typename BinaryType<T>::Type_t>(block, base_directory, values);
+	}
+	else return block.count_ == 0;
+}
+
+//! Reads the values of a min="..." or max="..." range attribute, which must have one value per component
+inline bool parseRange(const char *range, size_t number_of_components, float *values)
+{
+	if(!range) return false;
+	const char *range_end = range + std::strlen(range);
+	for(size_t component = 0; component < number_of_components; ++component)
+	{
+		range = string_to_number::readNext(range, range_end, values[component]);
+		if(!range) return false;
+	}
+	return !string_to_number::readNext(range, range_end, values[0]);
+}
+
+inline float dequantizeUnorm16(int quantized_value, float range_min, float range_max)
+{
+	return range_min + (range_max - range_min) * (static_cast<float>(quantized_value) / static_cast<float>(unorm16_max));
+}
+
+inline int quantizeUnorm16(float value, float range_min, float range_max)
+{
+	if(range_max <= range_min) return 0;
+	const float normalized = (value - range_min) / (range_max - range_min);
+	return std::clamp(static_cast<int>(std::lround(normalized * static_cast<float>(unorm16_max))), 0, unorm16_max);
+}
+
+//! Octahedral mapping of an unit vector into two values between -max_value and max_value
+inline void encodeOctahedral(const float *normal, int max_value, int *quantized_values)
+{
+	const float sum = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+	float u = sum > 0.f ? normal[0] / sum : 0.f;
+	float v = sum > 0.f ? normal[1] / sum : 0.f;
+	if(normal[2] < 0.f)
+	{
+		const float folded_u = (1.f - std::abs(v)) * (u >= 0.f ? 1.f : -1.f);
+		v = (1.f - std::abs(u)) * (v >= 0.f ? 1.f : -1.f);
+		u = folded_u;
+	}
+	quantized_values[0] = static_cast<int>(std::lround(u * static_cast<float>(max_value)));
+	quantized_values[1] = static_cast<int>(std::lround(v * static_cast<float>(max_value)));
+}
+
+inline void decodeOctahedral(const int *quantized_values, int max_value, float *normal)
+{
+	const float u = static_cast<float>(quantized_values[0]) / static_cast<float>(max_value);
+	const float v = static_cast<float>(quantized_values[1]) / static_cast<float>(max_value);
+	normal[0] = u;
+	normal[1] = v;
+	normal[2] = 1.f - std::abs(u) - std::abs(v);
+	if(normal[2] < 0.f)
+	{
+		normal[0] = (1.f - std::abs(v)) * (u >= 0.f ? 1.f : -1.f);
+		normal[1] = (1.f - std::abs(u)) * (v >= 0.f ? 1.f : -1.f);
+	}
+	const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+	for(int axis = 0; axis < 3; ++axis) normal[axis] /= length;
+}
+
+//! Decodes the values of a points, normals or uvs block, dequantizing them if needed. Values per item are the decoded ones (3 for normals, even if they are stored as 2)
+template<typename Allocator_t>
+inline bool decodeFloatValues(const Block &block, const std::string &base_directory, size_t values_per_item, std::vector<float, Allocator_t> &values)
+{
+	if(block.encoding_ == Encoding::None) return decodeValues(block, base_directory, values);
+	values.clear();
+	std::vector<int, typename std::allocator_traits<Allocator_t>::template rebind_alloc<int>> quantized_values{values.get_allocator()};
+	if(!decodeValues(block, base_directory, quantized_values)) return false;
+	if(block.encoding_ == Encoding::Unorm16)
+	{
+		float range_min[6], range_max[6];
+		if(values_per_item > 6 || !parseRange(block.range_min_, values_per_item, range_min) || !parseRange(block.range_max_, values_per_item, range_max)) return false;
+		if(quantized_values.size() % values_per_item != 0) return false;
+		values.resize(quantized_values.size());
+		for(size_t index = 0; index < quantized_values.size(); ++index)
+		{
+			if(quantized_values[index] < 0 || quantized_values[index] > unorm16_max) return false;
+			const size_t component = index % values_per_item;
+			values[index] = dequantizeUnorm16(quantized_values[index], range_min[component], range_max[component]);
+		}
+		return true;
+	}
+	else if((block.encoding_ == Encoding::Octahedral16 || block.encoding_ == Encoding::Octahedral32) && values_per_item == 3)
+	{
+		const int max_value = block.encoding_ == Encoding::Octahedral16 ? octahedral16_max : octahedral32_max;
+		if(quantized_values.size() % 2 != 0) return false;
+		values.resize(quantized_values.size() / 2 * 3);
+		for(size_t index = 0; index < quantized_values.size(); index += 2)
+		{
+			if(std::abs(quantized_values[index]) > max_value || std::abs(quantized_values[index + 1]) > max_value) return false;
+			decodeOctahedral(&quantized_values[index], max_value, &values[index / 2 * 3]);
+		}
+		return true;
+	}
+	else return false;
+}
+
+//! Checks that the count-prefixed faces values hold exactly the number of faces of the block, with valid vertex counts
+template<typename Allocator_t>
+inline bool checkFaces(const Block &block, const std::vector<int, Allocator_t> &values)
+{
+	if(block.encoding_ != Encoding::None && block.encoding_ != Encoding::Index16) return false;
+	size_t number_of_faces = 0;
+	size_t position = 0;
+	while(position < values.size())
+	{
+		if(values[position] < 0) return false;
+		const auto number_of_vertices = static_cast<size_t>(values[position]);
+		position += 1 + number_of_vertices * (block.uv_ ? 2 : 1);
+		++number_of_faces;
+	}
+	return position == values.size() && number_of_faces == block.count_;
+}
+
+//! Appends values to a binary sidecar file in the layout expected by decodeValues, stored as Binary_t values
+template<typename Binary_t, typename T>
+inline void writeBinaryValuesAs(std::ostream &stream, const std::vector<T> &values)
+{
+	const bool swap_bytes = !isLittleEndianHost();
+	for(const T &value : values)
+	{
+		auto binary_value = static_cast<Binary_t>(value);
+		if(swap_bytes)
+		{
+			auto *bytes = reinterpret_cast<uint8_t *>(&binary_value);
+			for(size_t byte = 0; byte < sizeof(Binary_t) / 2; ++byte) std::swap(bytes[byte], bytes[sizeof(Binary_t) - 1 - byte]);
+		}
+		stream.write(reinterpret_cast<const char *>(&binary_value), sizeof(Binary_t));
+	}
+}
+
+template<typename T>
+inline void writeBinaryValues(std::ostream &stream, const std::vector<T> &values)
+{
+	writeBinaryValuesAs<typename BinaryType<T>::Type_t>(stream, values);
+}
+
+} //namespace yafaray_xml::compact_geometry
+
+#endif //LIBYAFARAY_XML_COMPACT_GEOMETRY_H
@@ -0,0 +1,58 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_JSON_STRING_H
+#define LIBYAFARAY_XML_JSON_STRING_H
+
+#include <ostream>
+#include <string>
+
+namespace yafaray_xml
+{
+
+//! Writes the string quoted and escaped as a JSON string value
+inline void writeJsonString(std::ostream &stream, const std::string &string)
+{
+	stream << '"';
+	for(const char character : string)
+	{
+		switch(character)
+		{
+			case '"': stream << "\\\""; break;
+			case '\\': stream << "\\\\"; break;
+			case '\n': stream << "\\n"; break;
+			case '\r': stream << "\\r"; break;
+			case '\t': stream << "\\t"; break;
+			default:
+				if(static_cast<unsigned char>(character) < 0x20)
+				{
+					const char *hex_digits = "0123456789abcdef";
+					stream << "\\u00" << hex_digits[character >> 4] << hex_digits[character & 0xF];
+				}
+				else stream << character;
+		}
+	}
+	stream << '"';
+}
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_JSON_STRING_H
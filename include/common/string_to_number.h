@@ -0,0 +1,113 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_STRING_TO_NUMBER_H
+#define LIBYAFARAY_XML_STRING_TO_NUMBER_H
+
+#include <charconv>
+#include <cstring>
+#include <locale>
+#include <sstream>
+#include <type_traits>
+
+namespace yafaray_xml::string_to_number
+{
+
+//! Skips the leading blanks and '+' sign that std::from_chars does not accept but atof/atoi did
+inline const char *skipLeadingSignAndBlanks(const char *string)
+{
+	while(*string == ' ' || *string == '\t' || *string == '\n' || *string == '\r') ++string;
+	if(*string == '+') ++string;
+	return string;
+}
+
+//! Converts a decimal string to an integer independently of the current locale, returning 0 if it cannot be converted (like atoi did)
+inline int toInt(const char *string)
+{
+	if(!string) return 0;
+	string = skipLeadingSignAndBlanks(string);
+	int result = 0;
+	std::from_chars(string, string + std::strlen(string), result);
+	return result;
+}
+
+//! Converts a decimal or scientific notation string to a double independently of the current locale, returning 0 if it cannot be converted (like atof did)
+inline double toDouble(const char *string)
+{
+	if(!string) return 0.0;
+	string = skipLeadingSignAndBlanks(string);
+	double result = 0.0;
+#if defined(__cpp_lib_to_chars)
+	std::from_chars(string, string + std::strlen(string), result);
+#else //Standard libraries without floating point std::from_chars support
+	std::istringstream string_stream{string};
+	string_stream.imbue(std::locale::classic());
+	if(!(string_stream >> result)) result = 0.0;
+#endif
+	return result;
+}
+
+inline float toFloat(const char *string) { return static_cast<float>(toDouble(string)); }
+
+//! Reads the next whitespace separated number from a list of numbers, independently of the current locale. Returns the position right after the number, or nullptr if there are no more numbers or the next one cannot be converted
+template<typename T>
+inline const char *readNext(const char *string, const char *string_end, T &value)
+{
+	while(string < string_end && (*string == ' ' || *string == '\t' || *string == '\n' || *string == '\r')) ++string;
+	if(string < string_end && *string == '+') ++string;
+	if(string >= string_end) return nullptr;
+#if !defined(__cpp_lib_to_chars)
+	if constexpr(std::is_floating_point_v<T>) //Standard libraries without floating point std::from_chars support
+	{
+		const char *number_end = string;
+		while(number_end < string_end && *number_end != ' ' && *number_end != '\t' && *number_end != '\n' && *number_end != '\r') ++number_end;
+		std::istringstream string_stream{std::string{string, number_end}};
+		string_stream.imbue(std::locale::classic());
+		if(!(string_stream >> value)) return nullptr;
+		return number_end;
+	}
+	else
+#endif
+	{
+		const auto [number_end, error_code]{std::from_chars(string, string_end, value)};
+		if(error_code != std::errc{}) return nullptr;
+		return number_end;
+	}
+}
+
+//! Appends all the whitespace separated numbers of a list to the values. Returns false if anything in the list is not a valid number
+template<typename Values_t>
+inline bool readAll(const char *string, Values_t &values)
+{
+	const char *string_end = string + std::strlen(string);
+	typename Values_t::value_type value;
+	while(const char *number_end = readNext(string, string_end, value))
+	{
+		values.push_back(value);
+		string = number_end;
+	}
+	while(string < string_end && (*string == ' ' || *string == '\t' || *string == '\n' || *string == '\r')) ++string;
+	return string == string_end;
+}
+
+} //namespace yafaray_xml::string_to_number
+
+#endif //LIBYAFARAY_XML_STRING_TO_NUMBER_H
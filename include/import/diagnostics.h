@@ -0,0 +1,56 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_DIAGNOSTICS_H
+#define LIBYAFARAY_XML_DIAGNOSTICS_H
+
+#include <yafaray_c_api.h>
+#include <map>
+#include <string>
+
+namespace yafaray_xml
+{
+
+//! Aggregates the warnings found while parsing, so broken documents repeating the same mistake millions of times do not spend more time logging than parsing
+/*! Only the first occurrences of each warning kind and element are formatted and printed, the rest are just counted and reported in a summary at the end of the parsing */
+class Diagnostics final
+{
+	public:
+		enum class Kind : char { UnrecognizedElement, WrongAttribute };
+		explicit Diagnostics(yafaray_Logger *yafaray_logger) : yafaray_logger_{yafaray_logger} { }
+		//! Counts an occurrence of the warning, returning true when it has to be printed
+		[[nodiscard]] bool countWarning(Kind kind, const char *element);
+		//! Prints a warning. The detail is the unrecognized parent element or the wrong attribute name, depending on the warning kind. Line number 0 means unknown
+		void printWarning(Kind kind, const char *element, const char *detail, int line_number) const;
+		//! Prints how many times each warning was repeated beyond the ones already printed, if any
+		void printSummary() const;
+		void clear() { warning_counts_.clear(); }
+
+	private:
+		static constexpr size_t max_printed_warnings_per_element_ = 5;
+		yafaray_Logger *yafaray_logger_ = nullptr;
+		std::map<std::string, size_t> warning_counts_; //!< Warning kind + element -> number of occurrences
+		std::string warning_key_; //!< Reused to avoid allocating a new key for every warning
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_DIAGNOSTICS_H
@@ -0,0 +1,88 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_ELEMENT_EVENT_LIST_H
+#define LIBYAFARAY_XML_ELEMENT_EVENT_LIST_H
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+namespace yafaray_xml
+{
+
+class XmlParser;
+
+//! Compact recording of start/end element events (names and attributes included) that can be replayed later into an XmlParser
+class ElementEventList final
+{
+	public:
+		void addStartElement(const char *element, const char **attrs);
+		void addEndElement(const char *element);
+		void replay(XmlParser &parser) const { replay(parser, 0, events_.size()); }
+		//! Replays only the events from first_event up to, but not including, end_event
+		void replay(XmlParser &parser, size_t first_event, size_t end_event) const;
+		//! Calls start_element(element, attrs) and end_element(element) for the events from first_event up to, but not including, end_event
+		template <typename StartElement, typename EndElement> void visit(size_t first_event, size_t end_event, StartElement &&start_element, EndElement &&end_element) const;
+		[[nodiscard]] size_t size() const { return events_.size(); }
+		[[nodiscard]] bool empty() const { return events_.empty(); }
+		void clear() { events_.clear(); strings_.clear(); }
+
+	private:
+		struct Event
+		{
+			size_t strings_offset_;
+			size_t number_of_attributes_;
+			bool is_start_;
+		};
+		void appendString(const char *string);
+		std::vector<Event> events_;
+		std::vector<char> strings_; //!< Element names, attribute names and attribute values, all null-terminated and stored consecutively
+};
+
+template <typename StartElement, typename EndElement>
+void ElementEventList::visit(size_t first_event, size_t end_event, StartElement &&start_element, EndElement &&end_element) const
+{
+	std::vector<const char *> attrs;
+	for(size_t event_index = first_event; event_index < end_event && event_index < events_.size(); ++event_index)
+	{
+		const Event &event{events_[event_index]};
+		const char *element = &strings_[event.strings_offset_];
+		if(!event.is_start_)
+		{
+			end_element(element);
+			continue;
+		}
+		attrs.clear();
+		const char *string = element + std::strlen(element) + 1;
+		for(size_t attribute = 0; attribute < 2 * event.number_of_attributes_; ++attribute)
+		{
+			attrs.push_back(string);
+			string += std::strlen(string) + 1;
+		}
+		attrs.push_back(nullptr);
+		start_element(element, event.number_of_attributes_ > 0 ? attrs.data() : nullptr);
+	}
+}
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_ELEMENT_EVENT_LIST_H
@@ -0,0 +1,94 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_FILE_PREFETCHER_H
+#define LIBYAFARAY_XML_FILE_PREFETCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+//! Reads image files in background threads so their contents are already in the OS page cache when libYafaRay loads them
+class FilePrefetcher final
+{
+	public:
+		explicit FilePrefetcher(size_t number_of_threads);
+		~FilePrefetcher();
+		void prefetchFile(const std::string &file_path);
+		void prefetchImageFilesInXmlFile(const std::string &xml_file_path);
+		void prefetchImageFilesInXmlMemory(const char *xml_buffer, size_t xml_buffer_size);
+		//! Drops the XML scans not started yet and waits for the running ones to stop, so the XML buffers they read can be freed by the caller
+		void cancelScans();
+		//! Forgets the files already prefetched, so they are prefetched again when they appear in the next document
+		void clearRequestedFiles();
+
+	private:
+		struct Task
+		{
+			std::function<void()> function_;
+			bool scan_ = false;
+		};
+		//! Incremental search of the <filename sval="..."/> parameters of <image> elements in XML text received in arbitrary pieces
+		class ImageFileNameScanner final
+		{
+			public:
+				explicit ImageFileNameScanner(FilePrefetcher &file_prefetcher) : file_prefetcher_(file_prefetcher) { }
+				void scan(const char *data, size_t size);
+
+			private:
+				enum class State : unsigned char { OutsideImage, ImageTagName, InsideImage, FileNameTag, FileNameValueQuote, FileNameValue };
+				static bool matchPattern(char character, const char *pattern, size_t &pattern_position);
+				FilePrefetcher &file_prefetcher_;
+				State state_ = State::OutsideImage;
+				size_t pattern_position_ = 0;
+				size_t closing_pattern_position_ = 0;
+				char quote_ = '"';
+				std::string file_name_;
+		};
+		void addTask(std::function<void()> &&function, bool scan);
+		[[nodiscard]] bool isScanStopped() const { return stop_ || scans_cancelled_; }
+		void run();
+		void readFile(const std::string &file_path) const;
+		static std::string decodeXmlEntities(const std::string &text);
+		static constexpr size_t read_block_size_ = 1024 * 1024;
+		std::deque<Task> tasks_;
+		std::unordered_set<std::string> requested_files_;
+		std::atomic<bool> stop_{false};
+		std::atomic<bool> scans_cancelled_{false};
+		size_t running_scans_ = 0;
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		std::condition_variable scans_finished_condition_;
+		std::vector<std::thread> threads_;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_FILE_PREFETCHER_H
@@ -0,0 +1,61 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_FILE_STAGER_H
+#define LIBYAFARAY_XML_FILE_STAGER_H
+
+#include "import/element_event_list.h"
+#include <yafaray_c_api.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+class IncludeCache;
+class ParseControl;
+class TraceRecorder;
+
+//! Parses several XML files at the same time into element event lists, to be replayed afterwards into a single parser in the order of the files
+/*! Each file is parsed by one of a few threads, so the parsing scales with the cores and with the storage parallelism. Only the XML text is parsed here, the scene is still built by a single parser, in the same order regardless of which files were parsed first */
+class FileStager final
+{
+	public:
+		struct StagedFile
+		{
+			std::string file_path_;
+			std::string canonical_file_path_;
+			std::shared_ptr<const ElementEventList> element_events_; //!< Elements inside the root element, null if the file could not be parsed
+			std::string error_message_;
+		};
+		//! Parses the files, through the include cache if not null
+		void stageFiles(const std::vector<std::string> &file_paths, IncludeCache *include_cache, const ParseControl *parse_control, TraceRecorder *trace_recorder);
+		[[nodiscard]] const std::vector<StagedFile> &getStagedFiles() const { return staged_files_; }
+		//! Prints a warning for each element named like an element of the same kind in a previous file, as they would conflict once in the same container. Elements in files included by the staged files are not checked. Returns the number of collisions found
+		size_t reportNameCollisions(yafaray_Logger *yafaray_logger) const;
+
+	private:
+		std::vector<StagedFile> staged_files_;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_FILE_STAGER_H
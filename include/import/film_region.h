@@ -0,0 +1,62 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_FILM_REGION_H
+#define LIBYAFARAY_XML_FILM_REGION_H
+
+#include <yafaray_c_api.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+//! Restricts the films to one of several horizontal strips of the image, so a frame can be rendered by several processes and merged afterwards
+/*! The strip is set through the "height" and "ystart" film parameters, keeping the camera resolution of the whole frame. The outputs write TGA partial images next to their image paths, listed in a manifest file with their final image paths so they can be merged.
+ * Only TGA outputs are supported, as the merge reads and writes 8 bit TGA images. The badges and denoising of the outputs are disabled, as they would be applied to each strip instead of the whole image */
+class FilmRegion final
+{
+	public:
+		FilmRegion(size_t region_index, size_t regions) : region_index_{region_index}, regions_{regions} { }
+		//! Takes the film height and vertical start from the film parameters of the document
+		void readFilmParameter(const char *param_name, const char **attrs);
+		//! Sets the strip height and vertical start in the film parameters before creating the film. Returns false if the film height is not known
+		bool applyToFilm(yafaray_ParamMap *param_map);
+		//! Returns the path of the partial image written by the output instead of its image path, or an empty string if the image path is not a TGA image
+		[[nodiscard]] std::string addOutput(const std::string &image_path);
+		//! False if any output image path is not a TGA image, so the region cannot be merged
+		[[nodiscard]] bool outputsSupported() const { return unsupported_outputs_ == 0; }
+		//! Writes the final and partial image paths of the outputs, one output per line separated by a tab
+		[[nodiscard]] bool writeManifest(const std::string &file_path) const;
+		void clear() { film_height_ = 0; film_start_y_ = 0; outputs_.clear(); unsupported_outputs_ = 0; }
+
+	private:
+		const size_t region_index_ = 0;
+		const size_t regions_ = 1;
+		int film_height_ = 0;
+		int film_start_y_ = 0;
+		std::vector<std::pair<std::string, std::string>> outputs_; //!< Final image path, partial image path
+		size_t unsupported_outputs_ = 0;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_FILM_REGION_H
@@ -0,0 +1,83 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_GEOMETRY_DEDUPLICATOR_H
+#define LIBYAFARAY_XML_GEOMETRY_DEDUPLICATOR_H
+
+#include "import/element_event_list.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+//! Finds objects with the same geometry and parameters as a previous object in the scene, so they can be replaced by translated instances of it
+/*! The elements of each object are recorded while they are parsed, hashing everything but the object name and the vertex positions. Objects with the same hash are then compared vertex by vertex, allowing for a translation and for float rounding. Compact blocks are hashed as written, with their sidecar file paths resolved, so they only match blocks with the same values and no translation.
+ *  Base objects and objects linked to lights are never replaced, as instances and lights refer to them by name */
+class GeometryDeduplicator final
+{
+	public:
+		struct Duplicate
+		{
+			std::string object_name_; //!< Name of the first object with the same geometry
+			double translation_[3]; //!< From the first object to the recorded one
+		};
+		void startObject();
+		//! Records an element of the object. The document directory is used to resolve the relative sidecar file paths of compact blocks
+		void recordStartElement(const char *element, const char **attrs, const std::string &document_directory);
+		void recordEndElement(const char *element);
+		//! Looks for a previous object with the same geometry as the recorded one. If there is none, the recorded object is registered so later copies of it are found
+		[[nodiscard]] bool findDuplicate(Duplicate &duplicate);
+		[[nodiscard]] const ElementEventList &getRecordedElements() const { return recorded_elements_; }
+		[[nodiscard]] const std::string &getRecordedObjectName() const { return object_name_; }
+		//! Registers the instance created instead of a duplicated object, to be used when other instances refer to that object
+		void setObjectInstance(const std::string &object_name, size_t instance_id) { object_instances_[object_name] = instance_id; }
+		[[nodiscard]] bool findObjectInstance(const std::string &object_name, size_t &instance_id) const;
+		//! Registers an object a light refers to, so it is not replaced by an instance. Returns false if it was already replaced
+		[[nodiscard]] bool addLightObject(const std::string &object_name);
+		void clear();
+
+	private:
+		struct UniqueObject
+		{
+			std::string object_name_;
+			std::vector<float> positions_;
+		};
+		void hashString(const char *string);
+		[[nodiscard]] static bool isTranslatedCopy(const std::vector<float> &original_positions, const std::vector<float> &positions, double translation[3]);
+		ElementEventList recorded_elements_;
+		std::string object_name_;
+		std::vector<float> positions_; //!< Vertex positions of the recorded object, x, y, z for each vertex
+		uint64_t hash_ = 0;
+		int level_ = 0;
+		bool base_object_ = false;
+		bool light_object_ = false; //!< The recorded object is a mesh light, with a light_name parameter
+		std::unordered_map<uint64_t, std::vector<UniqueObject>> unique_objects_; //!< Objects created in the current scene, by hash
+		std::unordered_map<std::string, size_t> object_instances_; //!< Names of the objects replaced by instances -> instance id
+		std::unordered_set<std::string> light_objects_; //!< Names of the objects lights of the current scene refer to
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_GEOMETRY_DEDUPLICATOR_H
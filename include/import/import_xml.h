@@ -20,16 +20,33 @@
 #ifndef LIBYAFARAY_XML_IMPORT_XML_H
 #define LIBYAFARAY_XML_IMPORT_XML_H
 
+#include "import/parse_options.h"
+#include "import/diagnostics.h"
+#include "import/parse_arena.h"
+#include "import/polygon_triangulator.h"
 #include <yafaray_c_api.h>
+#include <chrono>
+#include <functional>
 #include <list>
 #include <vector>
 #include <string>
 #include <memory>
+#include <unordered_map>
+
+struct _xmlParserCtxt;
 
 namespace yafaray_xml
 {
 
 class XmlParser;
+class SceneWorker;
+class FilePrefetcher;
+class GeometryDeduplicator;
+class TraceRecorder;
+class ParamOverrides;
+class FilmRegion;
+class ProgressiveLoader;
+class XmlTokenizer;
 enum ColorSpace : int;
 
 typedef void (*StartElementCb_t)(XmlParser &parser, const char *element, const char **attrs);
@@ -44,34 +61,71 @@ struct ParserState
 	std::string element_name_;
 	std::string element_attributes_;
 	int level_;
+	int64_t trace_start_time_;
 };
 
 class XmlParser final
 {
 	public:
-		XmlParser(yafaray_Logger *yafaray_logger, const char *input_color_space, float input_gamma);
+		XmlParser(yafaray_Logger *yafaray_logger, const char *input_color_space, float input_gamma, const ParseOptions &parse_options);
 		~XmlParser();
 		void pushState(StartElementCb_t start, EndElementCb_t end, const char *element, const char **element_attrs);
 		void popState();
 		[[nodiscard]] std::string printStateStack() const;
-		void startElement(const char *element, const char **attrs) { ++level_; if(current_) current_->start_(*this, element, attrs); }
-		void endElement(const char *element) { if(current_) current_->end_(*this, element); --level_; }
-		[[nodiscard]] std::string stateElementName() const { return current_->element_name_; }
+		[[nodiscard]] const std::vector<ParserState> &getStateStack() const { return state_stack_; }
+		void startElement(const char *element, const char **attrs);
+		void endElement(const char *element);
+		[[nodiscard]] const std::string &stateElementName() const { return current_->element_name_; }
+		//! For elements named in their <parameters> child element, like scenes and objects
+		void setStateElementName(const std::string &element_name) { current_->element_name_ = element_name; }
+		[[nodiscard]] const std::string &stateElement() const { return current_->element_; }
 		[[nodiscard]] int currLevel() const { return level_; }
 		[[nodiscard]] int stateLevel() const { return current_ ? current_->level_ : -1; }
 		[[nodiscard]] yafaray_Logger *getLogger() { return yafaray_logger_; }
 		[[nodiscard]] yafaray_Container *getContainer() { return yafaray_container_; }
+		void createContainer() { yafaray_container_ = yafaray_createContainer(); }
+		[[nodiscard]] const ParseOptions &getParseOptions() const { return parse_options_; }
+		[[nodiscard]] const std::string &getDocumentDirectory() const { return document_directory_; }
+		void setDocumentDirectory(const std::string &document_directory) { document_directory_ = document_directory; }
+		void startSceneWorker(const char *element, const char **attrs);
+		void joinSceneWorkers();
+		void prefetchImageFile(const char **attrs);
+		void addLightObject(const char **attrs);
+		void includeFile(const char **attrs);
+		[[nodiscard]] PolygonTriangulator &getPolygonTriangulator() { return polygon_triangulator_; }
+		[[nodiscard]] TraceRecorder *getTraceRecorder() { return trace_recorder_; }
+		[[nodiscard]] ParamOverrides *getParamOverrides() { return param_overrides_; }
+		[[nodiscard]] FilmRegion *getFilmRegion() { return film_region_.get(); }
+		[[nodiscard]] GeometryDeduplicator *getGeometryDeduplicator() { return geometry_deduplicator_.get(); }
+		[[nodiscard]] ProgressiveLoader *getProgressiveLoader() { return progressive_loader_.get(); }
+		//! Memory resource for the temporaries of the importer, which must not outlive the parse
+		[[nodiscard]] std::pmr::memory_resource *getMemoryResource() { return parse_arena_.getResource(); }
+		void addObjectToInstance(size_t instance_id, const char *object_name);
 		void createScene(const char *name);
 		[[nodiscard]] yafaray_Scene *getScene() { return yafaray_scene_; }
+		//! When parsing several files into one container, the scenes after the first one are merged into it instead of created
+		[[nodiscard]] bool isMergingScenes() const { return merging_scenes_; }
 		void createSurfaceIntegrator(const char *name);
 		[[nodiscard]] yafaray_SurfaceIntegrator *getSurfaceIntegrator() { return yafaray_surface_integrator_; }
 		void createFilm(const char *name);
 		[[nodiscard]] yafaray_Film *getFilm() { return yafaray_film_; }
+		//! Film for the previews of the progressive loading, only with the camera of the film. Null when not loading progressively
+		[[nodiscard]] yafaray_Film *getPreviewFilm() { return yafaray_preview_film_; }
 		[[nodiscard]] yafaray_ParamMap *getParamMap() { return yafaray_param_map_; }
 		void clearParamMap() { yafaray_clearParamMap(yafaray_param_map_); }
-		void clearParamMapList() { yafaray_clearParamMapList(yafaray_param_map_list_); }
+		void clearParamMapList() { yafaray_clearParamMapList(yafaray_param_map_list_); param_map_fingerprint_.clear(); fingerprinting_element_ = false; }
 		[[nodiscard]] yafaray_ParamMapList *getParamMapList() { return yafaray_param_map_list_; }
 		void addParamMapToList() { yafaray_addParamMapToList(yafaray_param_map_list_, yafaray_param_map_); }
+		//! Starts accumulating the parameters fingerprint of the element, if it is a material, texture or image and their deduplication is enabled
+		void startElementFingerprint(const char *element);
+		[[nodiscard]] bool isFingerprintingElement() const { return fingerprinting_element_; }
+		void appendParamMapFingerprint(const char *param_name, const char **attrs);
+		[[nodiscard]] std::string findDuplicateElement(const std::string &element) const;
+		void registerElementFingerprint(const std::string &element, const std::string &element_name);
+		void addNameAlias(const std::string &alias_name, const std::string &name) { name_aliases_[alias_name] = name; }
+		[[nodiscard]] const char *resolveNameAlias(const char *name) const;
+		//! Whether the string parameter holds the name of a material, texture or image, which may have been replaced by a duplicated one
+		[[nodiscard]] static bool isNameReference(const char *param_name);
 		[[nodiscard]] size_t getInstanceIdCurrent() const { return instance_id_current_; }
 		void setInstanceIdCurrent(size_t instance_id_current) { instance_id_current_ = instance_id_current; }
 		[[nodiscard]] size_t getObjectIdCurrent() const { return object_id_current_; }
@@ -80,27 +134,94 @@ class XmlParser final
 		void setMaterialIdCurrent(size_t material_id_current) { material_id_current_ = material_id_current; }
 		[[nodiscard]] float getTimeCurrent() const { return time_current_; }
 		void setTimeCurrent(float time_current) { time_current_ = time_current; }
-		[[nodiscard]] static std::tuple<bool, yafaray_Container *> parseXmlFile(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma) noexcept;
-		[[nodiscard]] static std::tuple<bool, yafaray_Container *> parseXmlMemory(yafaray_Logger *yafaray_logger, const char *xml_buffer, int xml_buffer_size, const char *input_color_space, float input_gamma) noexcept;
+		[[nodiscard]] static std::tuple<bool, yafaray_Container *> parseXmlFile(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma, const ParseOptions &parse_options) noexcept;
+		[[nodiscard]] static std::tuple<bool, yafaray_Container *> parseXmlMemory(yafaray_Logger *yafaray_logger, const char *xml_buffer, size_t xml_buffer_size, const char *input_color_space, float input_gamma, const ParseOptions &parse_options) noexcept;
+		//! Parses the files concurrently and then builds them in order into a single container, where the scenes of all the files are merged into the scene of the first one. See FileStager
+		[[nodiscard]] static std::tuple<bool, yafaray_Container *> parseXmlFiles(yafaray_Logger *yafaray_logger, const std::vector<std::string> &xml_file_paths, const char *input_color_space, float input_gamma, const ParseOptions &parse_options) noexcept;
+		//! Parses a document with this parser, which can be used for many documents one after another, keeping the libxml2 parser context (with its dictionary of names) and the parsing buffers between them
+		[[nodiscard]] std::tuple<bool, yafaray_Container *> parseDocumentFile(const char *xml_file_path) noexcept;
+		[[nodiscard]] std::tuple<bool, yafaray_Container *> parseDocumentMemory(const char *xml_buffer, size_t xml_buffer_size) noexcept;
+
+		[[nodiscard]] _xmlParserCtxt *getXmlParserContext() { return xml_parser_context_; }
+		void addWarning(Diagnostics::Kind kind, const char *element, const char *detail);
+		void printDiagnosticsSummary() const { diagnostics_.printSummary(); }
+		[[nodiscard]] bool isParsingCancelled() const;
 
 	private:
+		void resetDocument();
+		[[nodiscard]] bool parseFile(const char *xml_file_path);
+		[[nodiscard]] bool parseMemory(const char *xml_buffer, size_t xml_buffer_size);
+		[[nodiscard]] bool beginPushParsing(const char *document_name);
+		[[nodiscard]] bool parseChunk(const char *chunk, size_t chunk_size);
+		[[nodiscard]] bool endPushParsing();
+		//! Reads up to size bytes of the document into the buffer, returning the number of bytes read, 0 at the end of the document or a negative value on errors
+		typedef std::function<int(char *buffer, int size)> ReadInput_t;
+		//! Parses the input with libxml2, starting with the data_size bytes already read into the read buffer
+		[[nodiscard]] bool pushParseInput(const char *document_name, const ReadInput_t &read_input, size_t data_size);
+		//! Parses the input with the built-in XmlTokenizer, falling back to libxml2 for the encodings it does not read
+		[[nodiscard]] bool tokenizeInput(const char *document_name, const ReadInput_t &read_input);
+		[[nodiscard]] int getLineNumber() const;
+		[[nodiscard]] std::tuple<bool, yafaray_Container *> finishParsing(bool parse_ok, const std::string &input_description);
+		void updateProgress(const char *element, const char **attrs);
+		void reportProgress(bool parsing_finished);
+		void reportTemporaryAllocations() const;
+		static constexpr size_t parse_chunk_size_ = 4 * 1024 * 1024; //!< Maximum amount of XML text given to libxml2 at once, so huge documents never need huge libxml2 buffers nor sizes over INT_MAX
+		_xmlParserCtxt *xml_parser_context_ = nullptr; //!< Only while parsing
+		_xmlParserCtxt *idle_xml_parser_context_ = nullptr; //!< Kept after parsing, to be reset and used again by the next document
+		XmlTokenizer *xml_tokenizer_ = nullptr; //!< Only while parsing with the built-in tokenizer
+		std::vector<char> read_buffer_; //!< Chunk of the file being parsed, kept for the next documents
+		bool document_parsed_ = false;
+		bool merging_scenes_ = false;
 		std::vector<ParserState> state_stack_;
 		ParserState *current_ = nullptr;
 		int level_ = 0;
 		yafaray_Logger *yafaray_logger_ = nullptr;
-		yafaray_Container *yafaray_container_{yafaray_createContainer()};
+		const std::string input_color_space_;
+		const float input_gamma_ = 1.f;
+		const ParseOptions parse_options_;
+		ParseArena parse_arena_{parse_options_.arena_allocation_};
+		std::string document_directory_; //!< Directory of the XML file being parsed, empty when parsing from memory. Used to find files referenced with relative paths in the XML file
+		std::vector<std::string> include_stack_; //!< Canonical paths of the document and the files being included, to detect circular includes
+		std::vector<std::unique_ptr<SceneWorker>> scene_workers_; //!< Scenes being built concurrently, in document order
+		SceneWorker *scene_worker_receiving_ = nullptr; //!< Scene worker the elements currently parsed are forwarded to
+		int scene_worker_level_ = 0;
+		size_t input_size_ = 0; //!< Size of the XML document being parsed, 0 if unknown
+		size_t elements_since_progress_check_ = 0;
+		std::chrono::steady_clock::time_point last_progress_report_time_;
+		std::string progress_scene_name_;
+		std::string progress_object_name_;
+		std::string *progress_name_pending_ = nullptr; //!< Progress name to be set from the next <parameters> element
+		static constexpr size_t progress_check_elements_interval_ = 1024; //!< Number of elements parsed between checks of the clock, to keep progress reporting overhead negligible
+		static constexpr std::chrono::milliseconds progress_report_interval_{250};
+		std::unique_ptr<FilePrefetcher> file_prefetcher_;
+		std::unique_ptr<TraceRecorder> trace_recorder_owned_; //!< Only in the parser reading the document, the scene workers record to it too
+		TraceRecorder *trace_recorder_ = nullptr;
+		std::unique_ptr<ParamOverrides> param_overrides_owned_; //!< Only in the parser reading the document, the scene workers use it too
+		ParamOverrides *param_overrides_ = nullptr; //!< Null when there are no overrides
+		std::unique_ptr<FilmRegion> film_region_;
+		std::unique_ptr<GeometryDeduplicator> geometry_deduplicator_;
+		std::unique_ptr<ProgressiveLoader> progressive_loader_;
+		PolygonTriangulator polygon_triangulator_;
+		Diagnostics diagnostics_{yafaray_logger_};
+		yafaray_Container *yafaray_container_ = nullptr;
 		yafaray_Scene *yafaray_scene_ = nullptr;
 		yafaray_SurfaceIntegrator *yafaray_surface_integrator_ = nullptr;
 		yafaray_Film *yafaray_film_ = nullptr;
+		yafaray_Film *yafaray_preview_film_ = nullptr;
 		yafaray_ParamMap *yafaray_param_map_ = nullptr;
 		yafaray_ParamMapList *yafaray_param_map_list_ = nullptr;
+		bool fingerprinting_element_ = false;
+		std::string param_map_fingerprint_; //!< Serialized parameters (including shader nodes) accumulated for the element being parsed, used to detect duplicated elements
+		std::unordered_map<std::string, std::string> element_fingerprints_; //!< Element type + parameters fingerprint -> name of the first element created with them in the current scene
+		std::unordered_map<std::string, std::string> name_aliases_; //!< Names of duplicated elements -> name of the element actually created in their place
 		size_t instance_id_current_ = 0;
 		size_t object_id_current_ = 0;
 		size_t material_id_current_ = 0;
 		float time_current_ = 0.f;
 };
 
-void parseParam(yafaray_ParamMap *yafaray_param_map, const char **attrs, const char *param_name);
+void parseParam(XmlParser &parser, const char **attrs, const char *param_name, bool apply_overrides = true);
+void addInstancesBlock(XmlParser &parser, const char **attrs);
 
 // state callbacks:
 void startElDocument(XmlParser &parser, const char *element, const char **attrs);
@@ -123,6 +244,10 @@ void startElObject(XmlParser &parser, const char *element, const char **attrs);
 void endElObject(XmlParser &parser, const char *element);
 void startElObjectParameters(XmlParser &parser, const char *element, const char **attrs);
 void endElObjectParameters(XmlParser &parser, const char *element);
+void startElObjectRecording(XmlParser &parser, const char *element, const char **attrs);
+void endElObjectRecording(XmlParser &parser, const char *element);
+void startElDeferredObject(XmlParser &parser, const char *element, const char **attrs);
+void endElDeferredObject(XmlParser &parser, const char *element);
 void startElInstance(XmlParser &parser, const char *element, const char **attrs);
 void endElInstance(XmlParser &parser, const char *element);
 void startElParamMap(XmlParser &parser, const char *element, const char **attrs);
@@ -0,0 +1,60 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef LIBYAFARAY_XML_INCLUDE_CACHE_H
+#define LIBYAFARAY_XML_INCLUDE_CACHE_H
+
+#include "import/element_event_list.h"
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace yafaray_xml
+{
+
+class ParseControl;
+
+//! Element events of the files included with <include file="..."/>, kept between parses so files shared by many scenes are read and parsed only once, set through the yafaray_xml_IncludeCache handle of the C API
+/*! Files are cached by their canonical path and checked for changes through their modification time and size, so an edited file is parsed again. It can be used by several parsers at the same time */
+class IncludeCache final
+{
+	public:
+		//! Returns the element events of the file, parsing it if it is not in the cache or it changed since it was cached. Returns nullptr and sets the error message if the file cannot be read or is not well formed
+		[[nodiscard]] std::shared_ptr<const ElementEventList> getElementEvents(const std::string &file_path, const ParseControl *parse_control, std::string &error_message);
+		void clear();
+		//! Parses the file, keeping the element events inside its root element. Returns nullptr and sets the error message if the file cannot be read, is not well formed or the parse control is cancelled
+		[[nodiscard]] static std::shared_ptr<const ElementEventList> parseFile(const std::string &file_path, const ParseControl *parse_control, std::string &error_message);
+
+	private:
+		struct Entry
+		{
+			std::filesystem::file_time_type modification_time_;
+			uintmax_t size_ = 0;
+			std::shared_ptr<const ElementEventList> element_events_;
+		};
+		std::mutex mutex_;
+		std::unordered_map<std::string, Entry> entries_;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_INCLUDE_CACHE_H
@@ -0,0 +1,81 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_PARAM_OVERRIDES_H
+#define LIBYAFARAY_XML_PARAM_OVERRIDES_H
+
+#include <yafaray_c_api.h>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+class XmlParser;
+struct ParserState;
+
+//! Parameter values given in the parse options as "path=value", replacing the values of the matching parameters of the document as its elements are built
+/*! The path is the chain of elements from <yafaray_container> to the parameter separated by dots, like "scene.accelerator.threads" or "film.parameters.width".
+ * Each element can be followed by a name between brackets to match only the elements with that "name" attribute, like "scene.material[Glass].IOR", and "*" matches any element.
+ * The values keep the type of the parameter in the document, vectors, colors and matrices given as lists of numbers separated by commas. It can be used by several parsers at the same time */
+class ParamOverrides final
+{
+	public:
+		static constexpr size_t npos = std::numeric_limits<size_t>::max();
+		//! Adds an override, returning false if it is not in the "path=value" form
+		bool add(const std::string &param_override);
+		[[nodiscard]] static bool isWellFormed(const std::string &param_override);
+		[[nodiscard]] bool empty() const { return overrides_.empty(); }
+		//! Returns the index of the last override matching the parameter in the element being parsed, or npos if none matches. The earlier overrides also matching it are counted as overridden by that one
+		[[nodiscard]] size_t find(const XmlParser &parser, const char *param_name);
+		[[nodiscard]] const std::string &getValue(size_t index) const { return overrides_[index].value_; }
+		//! Counts the parameters an override was applied to, or could not be applied because its value does not fit their type
+		void countApplied(size_t index, bool applied);
+		//! Prints the overrides that did not match any parameter, were overridden by later ones or could not be applied
+		void printSummary(yafaray_Logger *yafaray_logger) const;
+		void clearCounts();
+
+	private:
+		struct PathElement
+		{
+			std::string element_;
+			std::string name_;
+		};
+		struct Override
+		{
+			std::string text_;
+			std::vector<PathElement> path_;
+			std::string param_name_;
+			std::string value_;
+			size_t applied_count_ = 0;
+			size_t rejected_count_ = 0;
+			size_t overridden_count_ = 0; //!< Parameters also matched by a later override, which was applied instead
+		};
+		[[nodiscard]] static bool parse(const std::string &param_override, Override &result);
+		[[nodiscard]] static bool matches(const Override &param_override, const std::vector<ParserState> &state_stack, const char *param_name);
+		std::vector<Override> overrides_;
+		mutable std::mutex mutex_; //!< Only for the counters, the overrides are not modified while parsing
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_PARAM_OVERRIDES_H
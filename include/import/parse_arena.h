@@ -0,0 +1,77 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_PARSE_ARENA_H
+#define LIBYAFARAY_XML_PARSE_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+
+namespace yafaray_xml
+{
+
+//! Memory resource passing the allocations to its upstream resource and counting them
+class CountingMemoryResource final : public std::pmr::memory_resource
+{
+	public:
+		explicit CountingMemoryResource(std::pmr::memory_resource *upstream) : upstream_{upstream} { }
+		[[nodiscard]] size_t getAllocations() const { return allocations_; }
+		[[nodiscard]] size_t getAllocatedBytes() const { return allocated_bytes_; }
+		void clearCounts() { allocations_ = 0; allocated_bytes_ = 0; }
+
+	private:
+		void *do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+		[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+		std::pmr::memory_resource *upstream_ = nullptr;
+		size_t allocations_ = 0;
+		size_t allocated_bytes_ = 0;
+};
+
+//! Memory for the temporaries of the importer, like the values of compact geometry blocks, during one parse
+/*! When enabled, the temporaries are taken from pools, where the memory freed is reused for the next ones, and the pools are released all at once when the parse ends. When disabled, they are taken from the system allocator as usual. The allocations are counted in both cases, so the two can be compared. Not thread safe, each parser has its own.
+ * The parser states are left out: a state is pushed only for container elements like objects and materials, and its strings are almost always short enough to avoid any allocation.
+ * The element event lists are left out too: those of the include cache outlive the parse, those of the scene workers and file stager are filled and read from different threads, and the rest grow geometrically into a few large blocks */
+class ParseArena final
+{
+	public:
+		explicit ParseArena(bool enabled);
+		[[nodiscard]] std::pmr::memory_resource *getResource() { return &requested_; }
+		[[nodiscard]] bool isEnabled() const { return pools_.has_value(); }
+		//! Allocations asked for by the importer
+		[[nodiscard]] const CountingMemoryResource &getRequested() const { return requested_; }
+		//! Allocations that actually reached the system allocator
+		[[nodiscard]] const CountingMemoryResource &getSystem() const { return system_; }
+		//! Frees all the memory of the pools at once. No temporary can be alive when called
+		void release();
+		void clear();
+
+	private:
+		static constexpr size_t largest_pooled_block_ = 16 * 1024 * 1024; //!< Compact blocks of millions of values are common, and reusing their memory is where most of the gain is
+		CountingMemoryResource system_{std::pmr::new_delete_resource()};
+		std::optional<std::pmr::unsynchronized_pool_resource> pools_;
+		CountingMemoryResource requested_;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_PARSE_ARENA_H
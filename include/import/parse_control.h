@@ -0,0 +1,49 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_PARSE_CONTROL_H
+#define LIBYAFARAY_XML_PARSE_CONTROL_H
+
+#include <atomic>
+
+namespace yafaray_xml
+{
+
+//! Allows cancelling a parse in progress, set through the yafaray_xml_ParseControl handle of the C API
+/*! Cancelling only sets a lock-free atomic flag, so it can be done from another thread or from a signal handler. The parser checks it for every element and stops libxml2 when set.
+ * A control can be chained to a parent one, so it is also cancelled when the parent is, but cancelling or resetting it does not affect the parent */
+class ParseControl final
+{
+	public:
+		ParseControl() = default;
+		explicit ParseControl(const ParseControl *parent) : parent_{parent} { }
+		void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+		void reset() { cancelled_.store(false, std::memory_order_relaxed); }
+		[[nodiscard]] bool isCancelled() const { return cancelled_.load(std::memory_order_relaxed) || (parent_ && parent_->isCancelled()); }
+
+	private:
+		std::atomic<bool> cancelled_{false};
+		const ParseControl *const parent_ = nullptr; //!< Not owned
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_PARSE_CONTROL_H
@@ -0,0 +1,79 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_PARSE_JOB_H
+#define LIBYAFARAY_XML_PARSE_JOB_H
+
+#include "import/parse_control.h"
+#include "import/parse_options.h"
+#include <yafaray_c_api.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace yafaray_xml
+{
+
+//! Parse running in its own thread, set through the yafaray_xml_ParseJob handle of the C API, so the caller can keep working and poll it, wait for it or cancel it
+/*! The progress is taken from the progress callback, still calling the one in the parse options if any. The parse options are copied, so they can be destroyed once the job is started */
+class ParseJob final
+{
+	public:
+		enum class Status : int { Running, Succeeded, Failed, Cancelled };
+		//! Parses the file, or the memory buffer if not null. The memory buffer is not copied and must be kept until the job finishes
+		ParseJob(yafaray_Logger *yafaray_logger, std::string xml_file_path, const char *xml_buffer, size_t xml_buffer_size, const char *input_color_space, float input_gamma, const ParseOptions &parse_options);
+		//! Cancels the parse if still running, without cancelling the parse control of the caller, and destroys the container if it was not taken
+		~ParseJob();
+		ParseJob(const ParseJob &) = delete;
+		ParseJob &operator=(const ParseJob &) = delete;
+		[[nodiscard]] Status getStatus() const { return status_.load(std::memory_order_acquire); }
+		//! Waits until the job finishes or the timeout expires, returning true if it finished. A negative timeout waits without limit
+		bool wait(std::chrono::milliseconds timeout);
+		void getProgress(size_t &bytes_parsed, size_t &bytes_total) const;
+		//! Cancels only this job, the parse control of the caller is not modified
+		void cancel() { parse_control_.cancel(); }
+		//! Waits until the job finishes and returns the container, only once as its ownership is passed to the caller. Null if the parse did not succeed
+		[[nodiscard]] yafaray_Container *takeContainer();
+
+	private:
+		void run(yafaray_Logger *yafaray_logger, const std::string &input_color_space, float input_gamma);
+		static void progressCallback(size_t bytes_parsed, size_t bytes_total, const char *scene_name, const char *object_name, void *callback_data);
+		const std::string xml_file_path_;
+		const char *const xml_buffer_;
+		const size_t xml_buffer_size_;
+		ParseOptions parse_options_;
+		ParseControl parse_control_; //!< Chained to the one in the parse options if any, so cancelling that one also cancels the job
+		ParseProgressCallback_t caller_progress_callback_ = nullptr;
+		void *caller_progress_callback_data_ = nullptr;
+		std::atomic<Status> status_{Status::Running};
+		std::atomic<size_t> bytes_parsed_{0};
+		std::atomic<size_t> bytes_total_{0};
+		std::mutex mutex_;
+		std::condition_variable finished_condition_;
+		yafaray_Container *yafaray_container_ = nullptr;
+		std::thread thread_;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_PARSE_JOB_H
@@ -0,0 +1,71 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_PARSE_OPTIONS_H
+#define LIBYAFARAY_XML_PARSE_OPTIONS_H
+
+#include <yafaray_c_api.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+class ParseControl;
+class IncludeCache;
+class TraceRecorder;
+class ParamOverrides;
+typedef void (*ParseProgressCallback_t)(size_t bytes_parsed, size_t bytes_total, const char *scene_name, const char *object_name, void *callback_data);
+typedef void (*ProgressiveLoadCallback_t)(yafaray_Container *container, size_t objects_built, size_t objects_total, void *callback_data);
+typedef void (*FilmCallback_t)(yafaray_Film *film, yafaray_SurfaceIntegrator *surface_integrator, yafaray_Film *preview_film, void *callback_data);
+
+//! Optional import behaviors, set through the yafaray_xml_ParseOptions handle of the C API
+struct ParseOptions
+{
+	bool concurrent_scenes_ = false; //!< Build each top-level <scene> in its own worker thread
+	bool prefetch_image_files_ = false; //!< Read the image files referenced by <image> elements in background threads ahead of their creation
+	ParseProgressCallback_t progress_callback_ = nullptr; //!< Called from the parsing thread at most every few tenths of second, and once more when the parsing ends
+	void *progress_callback_data_ = nullptr;
+	ParseControl *parse_control_ = nullptr; //!< Not owned. When set, the parsing can be cancelled through it
+	IncludeCache *include_cache_ = nullptr; //!< Not owned. When set, the files included with <include> are kept parsed in it for later parses
+	std::string trace_file_path_; //!< When not empty, a Chrome trace event JSON file with the timing of the import is written to it
+	TraceRecorder *trace_recorder_ = nullptr; //!< Not owned. Set by the parser for its scene workers, so all the threads record to the same trace
+	bool deduplicate_geometry_ = false; //!< Replace objects with the same geometry as a previous object, except for a translation, by instances of that object
+	bool deduplicate_resources_ = false; //!< Reuse the first material, texture or image created with the same parameters instead of creating another one with a different name
+	std::vector<std::string> param_overrides_; //!< Parameter values replacing those in the document, as "path=value". See ParamOverrides
+	size_t film_region_index_ = 0; //!< Horizontal strip of the films to render, when film_regions_ is greater than 1. See FilmRegion
+	size_t film_regions_ = 1;
+	std::string film_region_manifest_path_; //!< When not empty and rendering a film region, the final and partial image paths of the outputs are written to it
+	ProgressiveLoadCallback_t progressive_load_callback_ = nullptr; //!< When set, the scene geometry is built after the rest of the document, calling it between steps. See ProgressiveLoader
+	void *progressive_load_callback_data_ = nullptr;
+	size_t progressive_load_objects_per_step_ = 0; //!< Number of objects built in each step of the progressive loading, 0 for no limit
+	int progressive_load_step_time_ms_ = 0; //!< Time budget of each step of the progressive loading, 0 for no limit
+	FilmCallback_t film_callback_ = nullptr; //!< Called for each film created, with the surface integrator it was created with and its preview film when loading progressively
+	void *film_callback_data_ = nullptr;
+	bool builtin_tokenizer_ = false; //!< Parse the document with the built-in XmlTokenizer instead of libxml2, if the library was built with it
+	bool arena_allocation_ = false; //!< Take the importer temporaries from pools released all at once when the parse ends, instead of from the system allocator. See ParseArena
+	ParamOverrides *shared_param_overrides_ = nullptr; //!< Not owned. Set by the parser for its scene workers, so the overrides matched by all the threads are reported together
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_PARSE_OPTIONS_H
@@ -0,0 +1,67 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_POLYGON_TRIANGULATOR_H
+#define LIBYAFARAY_XML_POLYGON_TRIANGULATOR_H
+
+#include "common/vec3f.h"
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+//! Splits the faces with more than four vertices into triangles, using the vertex positions of the object being parsed
+/*! Polygons are triangulated by ear clipping on the plane their normal is closest to, so concave polygons are handled. If the polygon is degenerate, self-intersecting or uses vertices with unknown positions, the remaining part is split as a fan instead.
+ *  Positions are only recorded from the first polygon of the object on, so objects with triangles and quads only do not keep a second copy of their points. The polygons using points added before it are split as a fan */
+class PolygonTriangulator final
+{
+	public:
+		typedef std::array<size_t, 3> Triangle_t; //!< Positions of the triangle corners in the polygon
+
+		void clearPoints() { points_.clear(); number_of_points_ = 0; first_recorded_point_ = 0; recording_points_ = false; }
+		void addPoint(const Vec3f &point) { if(recording_points_) points_.push_back(point); ++number_of_points_; }
+		//! Triangulates the polygon. The triangles returned are valid until the next call
+		[[nodiscard]] const std::vector<Triangle_t> &triangulate(const int *vertices_indices, size_t number_of_vertices);
+		//! Empty scratch storage for the vertex indices of a face given as an index list, reused for all faces
+		[[nodiscard]] std::vector<int> &getFaceVerticesIndices() { face_vertices_indices_.clear(); return face_vertices_indices_; }
+		//! Empty scratch storage for the uv indices of a face given as an index list, reused for all faces
+		[[nodiscard]] std::vector<int> &getFaceUvIndices() { face_uv_indices_.clear(); return face_uv_indices_; }
+
+	private:
+		[[nodiscard]] bool clipEars(const int *vertices_indices);
+		void addFan();
+		[[nodiscard]] const Vec3f *findPoint(int vertex_index) const;
+		std::vector<Vec3f> points_; //!< Positions of the points of the object in time step 0, by vertex index starting at first_recorded_point_
+		size_t number_of_points_ = 0;
+		size_t first_recorded_point_ = 0;
+		bool recording_points_ = false;
+		std::vector<Triangle_t> triangles_; //!< Scratch storage reused for all polygons, so no memory is allocated for each one
+		std::vector<size_t> remaining_corners_;
+		std::vector<float> projected_coordinates_;
+		std::vector<int> face_vertices_indices_;
+		std::vector<int> face_uv_indices_;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_POLYGON_TRIANGULATOR_H
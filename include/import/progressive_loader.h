@@ -0,0 +1,65 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_PROGRESSIVE_LOADER_H
+#define LIBYAFARAY_XML_PROGRESSIVE_LOADER_H
+
+#include "import/parse_options.h"
+#include "import/element_event_list.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+class XmlParser;
+
+//! Defers the geometry of the scene (objects and instances) until the rest of the document, including the surface integrators and films, has been built
+/*! The deferred elements are kept recorded in memory, and built at the end of the document in steps of a number of objects or of a time budget, calling the progressive load callback before the first step and after each one, so the caller can render previews of the partial scene.
+ *  Only the geometry of the last scene of the document is loaded progressively, the geometry of the previous scenes is built when the next scene starts */
+class ProgressiveLoader final
+{
+	public:
+		ProgressiveLoader(ProgressiveLoadCallback_t callback, void *callback_data, size_t objects_per_step, int step_time_ms);
+		[[nodiscard]] bool isDeferringObjects() const { return !building_objects_; }
+		void startObject(const std::string &scene_name);
+		void recordStartElement(const char *element, const char **attrs) { deferred_elements_.addStartElement(element, attrs); }
+		void recordEndElement(const char *element) { deferred_elements_.addEndElement(element); }
+		//! Builds the deferred objects in the current scene of the parser. When reporting the steps, the callback is called before building them and after each step
+		void buildObjects(XmlParser &parser, bool report_steps);
+		//! Discards the deferred objects, for example those left by a parse that failed
+		void clear() { deferred_elements_.clear(); object_first_events_.clear(); building_objects_ = false; }
+
+	private:
+		void reportStep(XmlParser &parser, size_t objects_built) const;
+		ProgressiveLoadCallback_t callback_ = nullptr;
+		void *callback_data_ = nullptr;
+		const size_t objects_per_step_ = 0;
+		const std::chrono::milliseconds step_time_budget_{0};
+		ElementEventList deferred_elements_;
+		std::vector<size_t> object_first_events_; //!< Index of the first deferred element event of each object, instance or instances block
+		std::string scene_name_;
+		bool building_objects_ = false;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_PROGRESSIVE_LOADER_H
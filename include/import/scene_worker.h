@@ -0,0 +1,61 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_SCENE_WORKER_H
+#define LIBYAFARAY_XML_SCENE_WORKER_H
+
+#include "import/import_xml.h"
+#include "import/element_event_list.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace yafaray_xml
+{
+
+//! Builds one top-level <scene> in its own thread and parser state, from the element events forwarded to it by the main parser
+class SceneWorker final
+{
+	public:
+		SceneWorker(yafaray_Logger *yafaray_logger, const std::string &input_color_space, float input_gamma, const ParseOptions &parse_options, const std::string &document_directory);
+		~SceneWorker();
+		void startElement(const char *element, const char **attrs);
+		void endElement(const char *element);
+		void finish();
+		[[nodiscard]] yafaray_Scene *join();
+
+	private:
+		void run();
+		void pushBatch();
+		static constexpr size_t max_batch_size_ = 4096;
+		XmlParser parser_;
+		ElementEventList batch_;
+		std::deque<ElementEventList> batch_queue_;
+		bool finished_ = false;
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		std::thread thread_;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_SCENE_WORKER_H
@@ -0,0 +1,92 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_TRACE_RECORDER_H
+#define LIBYAFARAY_XML_TRACE_RECORDER_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+//! Records timed events of the import from any thread, to be written as a Chrome trace event JSON file that can be opened in about:tracing or Perfetto
+class TraceRecorder final
+{
+	public:
+		[[nodiscard]] int64_t getTimeMicroseconds() const { return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time_).count(); }
+		//! Adds an event started at start_time and finishing now, in the calling thread. If the detail is not empty, it is added to the name between quotes
+		void addEvent(const char *category, const char *name, const std::string &detail, int64_t start_time);
+		void setThreadName(const std::string &thread_name);
+		[[nodiscard]] bool writeFile(const std::string &file_path) const;
+
+	private:
+		struct Event
+		{
+			const char *category_;
+			std::string name_;
+			int64_t start_time_;
+			int64_t duration_;
+			size_t thread_;
+		};
+		[[nodiscard]] size_t getThreadIndex(); //!< Must be called with the mutex locked
+		const std::chrono::steady_clock::time_point start_time_{std::chrono::steady_clock::now()};
+		mutable std::mutex mutex_;
+		std::vector<Event> events_;
+		std::map<std::thread::id, size_t> thread_indices_;
+		std::map<size_t, std::string> thread_names_;
+};
+
+//! Adds an event for its lifetime to the trace recorder, if there is one. Without recorder it only costs a branch, so it can be left in the hot paths
+class TraceScope final
+{
+	public:
+		//! The detail is only copied when recording, so disabled traces do not build strings
+		TraceScope(TraceRecorder *trace_recorder, const char *category, const char *name, std::string_view detail) : trace_recorder_{trace_recorder}, category_{category}, name_{name}
+		{
+			if(!trace_recorder_) return;
+			detail_ = detail;
+			start_time_ = trace_recorder_->getTimeMicroseconds();
+		}
+		~TraceScope()
+		{
+			if(trace_recorder_) trace_recorder_->addEvent(category_, name_, detail_, start_time_);
+		}
+		TraceScope(const TraceScope &) = delete;
+		TraceScope &operator=(const TraceScope &) = delete;
+
+	private:
+		TraceRecorder *trace_recorder_;
+		const char *category_;
+		const char *name_;
+		std::string detail_;
+		int64_t start_time_ = 0;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_TRACE_RECORDER_H
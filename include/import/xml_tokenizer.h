@@ -0,0 +1,88 @@
+#pragma once
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_XML_TOKENIZER_H
+#define LIBYAFARAY_XML_XML_TOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+//! Built-in tokenizer for the subset of XML used by YafaRay scenes, faster than libxml2 and used instead of it when selected in the parse options
+/*! It works in place: element and attribute names and values are terminated, and their entities and white space decoded, inside the buffer given, so they are passed to the callbacks without copying them. Text, comments, processing instructions and CDATA sections are skipped, and DTDs are not read (a DOCTYPE with an internal subset is an error). The document must be in UTF-8 or ASCII, see isSupportedEncoding. Namespaces are not processed, so prefixed names are passed as they are, as libxml2 does for its SAX1 callbacks. Well-formedness is checked for the element nesting and the tags syntax, but not for duplicated attributes nor for the characters allowed in names */
+class XmlTokenizer final
+{
+	public:
+		typedef void (*StartElementCb_t)(void *user_data, const char *element, const char **attrs);
+		typedef void (*EndElementCb_t)(void *user_data, const char *element);
+		enum class Result : unsigned char { NeedMoreData, Finished, Stopped, Error };
+
+		XmlTokenizer(StartElementCb_t start_element, EndElementCb_t end_element, void *user_data);
+		//! Tokenizes the markup in the data, which is the continuation of the data given in the previous call. Markup cut at the end of the data is left untouched for the next call, which must start with it, unless this is the last data of the document. The byte right after the data must be writable, it is used as sentinel
+		[[nodiscard]] Result tokenize(char *data, size_t data_size, bool is_last_data, size_t &bytes_tokenized);
+		//! Stops the tokenizing after the current callback
+		void stop() { stopped_ = true; }
+		[[nodiscard]] size_t getBytesConsumed() const { return bytes_consumed_; }
+		//! Line of the end of the last tag given to the callbacks, or of the error
+		[[nodiscard]] int getLineNumber() const { return line_number_; }
+		[[nodiscard]] const std::string &getErrorMessage() const { return error_message_; }
+		//! Checks the byte order mark and the encoding declared at the start of the document, which must be UTF-8 or ASCII (which is also the default) for the tokenizer to read it
+		[[nodiscard]] static bool isSupportedEncoding(const char *data, size_t data_size);
+
+	private:
+		struct Attribute
+		{
+			char *name_;
+			char *name_end_;
+			char *value_;
+			char *value_end_;
+			bool value_needs_decoding_;
+		};
+		enum class Markup : unsigned char { Complete, Incomplete, Invalid };
+		[[nodiscard]] Markup tokenizeStartTag(char *&position, const char *data_end);
+		[[nodiscard]] Markup tokenizeEndTag(char *&position, const char *data_end);
+		[[nodiscard]] Markup skipUntil(char *&position, const char *data_end, const char *terminator);
+		[[nodiscard]] Markup skipDoctype(char *&position, const char *data_end);
+		[[nodiscard]] bool decodeValue(Attribute &attribute);
+		[[nodiscard]] bool checkText(const char *text, const char *text_end);
+		void setError(const std::string &error_message) { error_message_ = error_message; }
+		StartElementCb_t start_element_ = nullptr;
+		EndElementCb_t end_element_ = nullptr;
+		void *user_data_ = nullptr;
+		std::vector<Attribute> attributes_; //!< Attributes of the tag being tokenized, reused for all the tags
+		std::vector<const char *> attrs_; //!< Null-terminated name, value pairs given to the start element callback
+		std::string open_elements_; //!< Names of the elements not closed yet, stored consecutively, as they do not stay in the buffer between calls
+		std::vector<size_t> open_element_offsets_;
+		bool root_element_found_ = false;
+		bool stopped_ = false;
+		size_t data_offset_ = 0; //!< Bytes of the document tokenized in the previous calls
+		size_t bytes_consumed_ = 0;
+		int line_number_ = 1;
+		std::string error_message_;
+};
+
+} //namespace yafaray_xml
+
+#endif //LIBYAFARAY_XML_XML_TOKENIZER_H
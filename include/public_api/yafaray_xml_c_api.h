@@ -28,8 +28,92 @@
 extern "C" {
 #endif
 
+	/* Opaque handle with optional import behaviors, to be used with the "WithOptions" parse functions. A null options pointer means default behavior */
+	typedef struct yafaray_xml_ParseOptions yafaray_xml_ParseOptions;
+	/* Opaque handle to cancel a parse in progress from another thread or from a signal handler */
+	typedef struct yafaray_xml_ParseControl yafaray_xml_ParseControl;
+	/* Opaque handle keeping the files included with <include file="..."/> already parsed, so parses sharing it read and parse each included file only once while it does not change */
+	typedef struct yafaray_xml_IncludeCache yafaray_xml_IncludeCache;
+	/* Parse progress callback. The total bytes are 0 when unknown (for example for compressed files). Scene and object names are those of the last ones found, empty if none */
+	typedef void (*yafaray_xml_ParseProgressCallback)(size_t bytes_parsed, size_t bytes_total, const char *scene_name, const char *object_name, void *callback_data);
+	/* Opaque handle to a parser to be used for many parses one after another, keeping the libxml2 parser context, its dictionary of names and the parsing buffers between them, which are reset for each document */
+	typedef struct yafaray_xml_Parser yafaray_xml_Parser;
+	/* Progressive loading callback, called from the parsing thread with the container once everything but the scene geometry has been built, and then after each step of objects built. The container can be used inside the callback (for example to preprocess the scene and render a preview), but not from other threads until the parsing finishes */
+	typedef void (*yafaray_xml_ProgressiveLoadCallback)(yafaray_Container *container, size_t objects_built, size_t objects_total, void *callback_data);
+	/* Film callback, called from the parsing thread for each film created, with the surface integrator it was created with (the last one defined before the film in the document) and its preview film when loading progressively, null otherwise */
+	typedef void (*yafaray_xml_FilmCallback)(yafaray_Film *film, yafaray_SurfaceIntegrator *surface_integrator, yafaray_Film *preview_film, void *callback_data);
+	/* Opaque handle to a parse running in a library thread, started with the "startParse" functions */
+	typedef struct yafaray_xml_ParseJob yafaray_xml_ParseJob;
+	typedef enum { YAFARAY_XML_PARSE_JOB_RUNNING, YAFARAY_XML_PARSE_JOB_SUCCEEDED, YAFARAY_XML_PARSE_JOB_FAILED, YAFARAY_XML_PARSE_JOB_CANCELLED } yafaray_xml_ParseJobStatus;
+
 	YAFARAY_XML_C_API_EXPORT yafaray_Container *yafaray_xml_ParseFile(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma);
 	YAFARAY_XML_C_API_EXPORT yafaray_Container *yafaray_xml_ParseMemory(yafaray_Logger *yafaray_logger, const char *xml_buffer, int xml_buffer_size, const char *input_color_space, float input_gamma);
+	YAFARAY_XML_C_API_EXPORT yafaray_Container *yafaray_xml_ParseFileWithOptions(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options);
+	/* Accepts buffers of any size, including over 2 GiB, which are given to the XML parser in bounded chunks */
+	YAFARAY_XML_C_API_EXPORT yafaray_Container *yafaray_xml_ParseMemoryWithOptions(yafaray_Logger *yafaray_logger, const char *xml_buffer, size_t xml_buffer_size, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options);
+	/* Creates a parser for many parses with the same input color space, gamma and options, which are copied. The objects the options point to (parse control, include cache) must outlive the parser */
+	YAFARAY_XML_C_API_EXPORT yafaray_xml_Parser *yafaray_xml_createParser(yafaray_Logger *yafaray_logger, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options);
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_destroyParser(yafaray_xml_Parser *parser);
+	/* Same as yafaray_xml_ParseFileWithOptions, using the parser created before. A parser can only parse one document at a time, but different parsers can be used from different threads */
+	YAFARAY_XML_C_API_EXPORT yafaray_Container *yafaray_xml_ParseFileWithParser(yafaray_xml_Parser *parser, const char *xml_file_path);
+	YAFARAY_XML_C_API_EXPORT yafaray_Container *yafaray_xml_ParseMemoryWithParser(yafaray_xml_Parser *parser, const char *xml_buffer, size_t xml_buffer_size);
+	/* Parses several XML files into a single container. The files are parsed concurrently and then built in the order given, the scenes of all of them merged into the scene of the first file, whose scene parameters are the ones used. Elements with the same kind and name in different files are reported as warnings. Returns null if any of the files cannot be parsed */
+	YAFARAY_XML_C_API_EXPORT yafaray_Container *yafaray_xml_ParseFiles(yafaray_Logger *yafaray_logger, const char *const *xml_file_paths, size_t number_of_files, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options);
+	YAFARAY_XML_C_API_EXPORT yafaray_xml_ParseOptions *yafaray_xml_createParseOptions();
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_destroyParseOptions(yafaray_xml_ParseOptions *parse_options);
+	/* Builds each top-level <scene> in its own worker thread. Scenes are still added to the container in document order. Disabled by default */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionConcurrentScenes(yafaray_xml_ParseOptions *parse_options, yafaray_Bool concurrent_scenes);
+	/* Reads the files referenced by <image> elements in background threads while the document is parsed, so they are already cached by the OS when the images are created. Disabled by default */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionPrefetchImageFiles(yafaray_xml_ParseOptions *parse_options, yafaray_Bool prefetch_image_files);
+	/* Sets a callback called from the parsing thread a few times per second at most, and once more when the parsing finishes successfully */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionProgressCallback(yafaray_xml_ParseOptions *parse_options, yafaray_xml_ParseProgressCallback progress_callback, void *callback_data);
+	/* Sets the control used to cancel the parsing. It is not owned by the options and must outlive the parsing. A cancelled parsing returns a null container */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionParseControl(yafaray_xml_ParseOptions *parse_options, yafaray_xml_ParseControl *parse_control);
+	YAFARAY_XML_C_API_EXPORT yafaray_xml_ParseControl *yafaray_xml_createParseControl();
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_destroyParseControl(yafaray_xml_ParseControl *parse_control);
+	/* Safe to call from other threads and from signal handlers */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_cancelParsing(yafaray_xml_ParseControl *parse_control);
+	/* Clears the cancellation, so the control can be used again for later parses, for example with a parser created with yafaray_xml_createParser. Must not be called while a parse using it is running */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_resetParseControl(yafaray_xml_ParseControl *parse_control);
+	/* Sets the cache of included files. It is not owned by the options and must outlive the parsing. It can be shared by parses running at the same time */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionIncludeCache(yafaray_xml_ParseOptions *parse_options, yafaray_xml_IncludeCache *include_cache);
+	YAFARAY_XML_C_API_EXPORT yafaray_xml_IncludeCache *yafaray_xml_createIncludeCache();
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_destroyIncludeCache(yafaray_xml_IncludeCache *include_cache);
+	/* Frees all the included files kept in the cache */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_clearIncludeCache(yafaray_xml_IncludeCache *include_cache);
+	/* Adds the objects with the same parameters and geometry as a previous object, except for a translation, as instances of that object instead of creating them again. Base objects are not affected. Disabled by default */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionDeduplicateGeometry(yafaray_xml_ParseOptions *parse_options, yafaray_Bool deduplicate_geometry);
+	/* Reuses the first material, texture or image of each scene created with the same parameters instead of creating another one, making the parameters that refer to the duplicated one by name refer to the reused one. The duplicated names are not added to the scene. Disabled by default */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionDeduplicateResources(yafaray_xml_ParseOptions *parse_options, yafaray_Bool deduplicate_resources);
+	/* Records the time spent in each XML element and libYafaRay call during the parsing, and writes it at the end in the Chrome trace event JSON format (to be opened with chrome://tracing or Perfetto) to the file path given. Disabled if the path is null or empty */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionTraceFile(yafaray_xml_ParseOptions *parse_options, const char *trace_file_path);
+	/* Adds a parameter override as "path=value", replacing the value of the matching parameters of the document while parsing it. The path is the chain of elements from <yafaray_container> to the parameter separated by dots, like "scene.accelerator.threads=32" or "film.parameters.width=960". Elements can be followed by a name between brackets to match only the elements with that name, like "scene.material[Glass].IOR=1.5", and "*" matches any element. Vectors, colors and matrices are given as numbers separated by commas. Overrides that did not match any parameter or whose value does not fit the parameter type are reported at the end of the parsing. Returns false if the override is not in the "path=value" form */
+	YAFARAY_XML_C_API_EXPORT yafaray_Bool yafaray_xml_setParseOptionParamOverride(yafaray_xml_ParseOptions *parse_options, const char *param_override);
+	/* Renders only the horizontal strip region_index (starting from 0) of the films split into the given number of regions, through their "height" and "ystart" parameters. The outputs write partial TGA images instead of their images, and if the manifest path is not null, their final and partial image paths are written to it, one output per line separated by a tab, so the regions can be merged afterwards. Disabled with 1 region */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionFilmRegion(yafaray_xml_ParseOptions *parse_options, size_t region_index, size_t regions, const char *manifest_path);
+	/* Builds the objects and instances of the scene after the rest of the document, including the surface integrators and films, so a first preview can be rendered early. They are then built in steps of the given number of objects or of the given time in milliseconds, whichever comes first (0 for no limit), calling the callback before the first step and after each one. The deferred elements are kept in memory until built. Only the last scene of the document is loaded progressively, and concurrent scenes are not used. Each film also gets a preview film in the container, named after it with a " (preview)" suffix, with the same camera and parameters but a single anti-aliasing pass of one sample and no layers nor outputs, so the previews are quick and do not write the final images. Disabled if the callback is null */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionProgressiveLoading(yafaray_xml_ParseOptions *parse_options, yafaray_xml_ProgressiveLoadCallback progressive_load_callback, void *callback_data, size_t objects_per_step, int step_time_ms);
+	/* Calls the callback for each film created, so the application knows which surface integrator each film is bound to and which is its preview film. Disabled if the callback is null */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionFilmCallback(yafaray_xml_ParseOptions *parse_options, yafaray_xml_FilmCallback film_callback, void *callback_data);
+	/* Parses the documents with the built-in tokenizer for the subset of XML used by YafaRay scenes, which is faster than libxml2 but does not read DTDs and only reads UTF-8 or ASCII documents (others are parsed with libxml2). Included files are still parsed with libxml2. Ignored, with a warning, if the library was built without the tokenizer. Disabled by default */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionBuiltinTokenizer(yafaray_xml_ParseOptions *parse_options, yafaray_Bool builtin_tokenizer);
+	/* Takes the temporary memory used by the importer while parsing, like the values of compact geometry blocks, from pools that reuse the memory freed and are released all at once when the parse ends, instead of from the system allocator. The number of temporary allocations is reported in verbose mode either way. The allocations of libxml2 itself are not affected. Disabled by default */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_setParseOptionArenaAllocation(yafaray_xml_ParseOptions *parse_options, yafaray_Bool arena_allocation);
+	/* Starts parsing the file in a library thread and returns immediately. The options are copied and can be destroyed afterwards, but the objects they point to (parse control, include cache) must outlive the job. The progress callback, if any, is called from the job thread */
+	YAFARAY_XML_C_API_EXPORT yafaray_xml_ParseJob *yafaray_xml_startParseFile(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options);
+	/* Same as yafaray_xml_startParseFile but for a memory buffer, which is not copied and must be kept valid until the job finishes */
+	YAFARAY_XML_C_API_EXPORT yafaray_xml_ParseJob *yafaray_xml_startParseMemory(yafaray_Logger *yafaray_logger, const char *xml_buffer, size_t xml_buffer_size, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options);
+	YAFARAY_XML_C_API_EXPORT yafaray_xml_ParseJobStatus yafaray_xml_getParseJobStatus(const yafaray_xml_ParseJob *parse_job);
+	/* Waits until the job finishes or the timeout in milliseconds expires, returning true if the job finished. A negative timeout waits without limit and 0 only polls */
+	YAFARAY_XML_C_API_EXPORT yafaray_Bool yafaray_xml_waitParseJob(yafaray_xml_ParseJob *parse_job, int timeout_ms);
+	/* Gets the bytes parsed so far and the total bytes, which is 0 when unknown (for example for compressed files). Any of the pointers can be null */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_getParseJobProgress(const yafaray_xml_ParseJob *parse_job, size_t *bytes_parsed, size_t *bytes_total);
+	/* Requests the job to stop without waiting for it. Safe to call from other threads. The parse control in the options, if any, is not cancelled, so it can still be used for other parses */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_cancelParseJob(yafaray_xml_ParseJob *parse_job);
+	/* Waits until the job finishes and returns the parsed container, whose ownership is passed to the caller. Returns null if the parse did not succeed or if the container was already taken */
+	YAFARAY_XML_C_API_EXPORT yafaray_Container *yafaray_xml_takeParseJobContainer(yafaray_xml_ParseJob *parse_job);
+	/* Cancels the job if still running and waits for it to stop. The container is destroyed too if it was not taken */
+	YAFARAY_XML_C_API_EXPORT void yafaray_xml_destroyParseJob(yafaray_xml_ParseJob *parse_job);
 	YAFARAY_XML_C_API_EXPORT int yafaray_xml_getVersionMajor();
 	YAFARAY_XML_C_API_EXPORT int yafaray_xml_getVersionMinor();
 	YAFARAY_XML_C_API_EXPORT int yafaray_xml_getVersionPatch();
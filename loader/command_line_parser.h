@@ -40,8 +40,9 @@ class CliParserOption final
 		bool isFlag() const { return is_flag_; }
 		bool isSet() const { return is_set_; }
 		std::string getValue() const { return value_; }
+		std::vector<std::string> getValues() const { return values_; }
 		std::string getDescription() const { return desc_; }
-		void setValue(const std::string &value) { value_ = value; }
+		void setValue(const std::string &value) { value_ = value; values_.push_back(value); }
 		void markAsSet(bool value) { is_set_ = value; }
 
 	private:
@@ -50,6 +51,7 @@ class CliParserOption final
 		bool is_flag_ = false;
 		std::string desc_;
 		std::string value_;
+		std::vector<std::string> values_; //! All the values given when the option is repeated
 		bool is_set_ = false;
 };
 
@@ -72,10 +74,12 @@ class CliParser final
 		void setOption(const std::string &s_opt, const std::string &l_opt, bool is_flag, const std::string &desc); //! Option registrar method, it adds a valid parsing option to the list
 		const CliParserOption *findOption(const std::string &s_opt, const std::string &l_opt = "") const;
 		std::string getOptionString(const std::string &s_opt, const std::string &l_opt = "") const; //! Retrieves the string value associated with the option if any, if no option returns an empty string
+		std::vector<std::string> getOptionStrings(const std::string &s_opt, const std::string &l_opt = "") const; //! Retrieves all the string values given to a repeated option, if no option returns an empty list
 		int getOptionInteger(const std::string &s_opt, const std::string &l_opt = "") const; //! Retrieves the integer value associated with the option if any, if no option returns std::numeric_limits<int>::min()
 		double getOptionFloat(const std::string &s_opt, const std::string &l_opt = "") const; //! Retrieves the floating point value associated with the option if any, if no option returns std::numeric_limits<double>::quiet_NaN();
 		bool isFlagSet(const std::string &s_opt, const std::string &l_opt = "") const; //! Returns true is the flag was set in command line, false else
 		std::vector<std::string> getCleanArgs() const;
+		std::vector<std::string> getOptionArgs(const std::vector<std::string> &excluded_s_opts) const; //! Rebuilds the arguments of the options set in command line, except the excluded ones, to run the program again with them
 		void setAppName(const std::string &name, const std::string &b_usage);
 		void printUsage() const; //! Prints usage instructions with the registrered options
 		void printError() const; //! Prints error found during parsing (if any)
@@ -147,6 +151,13 @@ inline std::string CliParser::getOptionString(const std::string &s_opt, const st
 	else return reg_option->getValue();
 }
 
+inline std::vector<std::string> CliParser::getOptionStrings(const std::string &s_opt, const std::string &l_opt) const
+{
+	const CliParserOption *reg_option = findOption(s_opt, l_opt);
+	if(!reg_option || reg_option->isFlag()) return {};
+	else return reg_option->getValues();
+}
+
 inline int CliParser::getOptionInteger(const std::string &s_opt, const std::string &l_opt) const
 {
 	constexpr int default_value = std::numeric_limits<int>::min();
@@ -181,6 +192,33 @@ inline std::vector<std::string> CliParser::getCleanArgs() const
 	return clean_values_;
 }
 
+inline std::vector<std::string> CliParser::getOptionArgs(const std::vector<std::string> &excluded_s_opts) const
+{
+	std::vector<std::string> option_args;
+	for(const auto &reg_option : reg_options_)
+	{
+		if(!reg_option->isSet()) continue;
+		bool excluded = false;
+		for(const auto &excluded_s_opt : excluded_s_opts)
+		{
+			if(reg_option->getShortOpt() == "-" + excluded_s_opt) excluded = true;
+		}
+		if(excluded) continue;
+		const std::string option_name = reg_option->getShortOpt().empty() ? reg_option->getLongOpt() : reg_option->getShortOpt();
+		if(reg_option->isFlag())
+		{
+			option_args.push_back(option_name);
+			continue;
+		}
+		for(const auto &value : reg_option->getValues())
+		{
+			option_args.push_back(option_name);
+			option_args.push_back(value);
+		}
+	}
+	return option_args;
+}
+
 inline void CliParser::setAppName(const std::string &name, const std::string &b_usage)
 {
 	app_name_.clear();
@@ -215,9 +253,10 @@ inline bool CliParser::parseCommandLine()
 {
 	std::stringstream error;
 	clean_values_.clear();
+	const size_t clean_values_start = arg_values_.size() > clean_args_ ? arg_values_.size() - clean_args_ : 0; //Clean values are taken only from the last arguments
 	for(size_t i = 0; i < arg_values_.size(); i++)
 	{
-		if((i >= arg_values_.size() - (clean_args_ - clean_args_optional_)) || (i >= arg_values_.size() - clean_args_))
+		if(i >= clean_values_start)
 		{
 			if(arg_values_[i].compare(0, 1, "-") != 0)
 			{
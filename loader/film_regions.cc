@@ -0,0 +1,213 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "film_regions.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#ifndef WIN32
+#include <spawn.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
+
+bool readTga_global(const std::string &file_path, TgaImage &image)
+{
+	std::ifstream file(file_path, std::ios::binary);
+	unsigned char header[18];
+	if(!file.read(reinterpret_cast<char *>(header), sizeof header)) return false;
+	const unsigned char image_type = header[2];
+	const bool run_length_encoded = (image_type == 10 || image_type == 11);
+	if(header[1] != 0 || (image_type != 2 && image_type != 3 && !run_length_encoded)) return false; //Only true color and gray images without color map
+	image.width_ = header[12] | (header[13] << 8);
+	image.height_ = header[14] | (header[15] << 8);
+	image.bytes_per_pixel_ = header[16] / 8;
+	image.gray_ = (image_type == 3 || image_type == 11);
+	image.alpha_bits_ = header[17] & 0x0f;
+	if(image.width_ <= 0 || image.height_ <= 0 || (image.bytes_per_pixel_ != 1 && image.bytes_per_pixel_ != 3 && image.bytes_per_pixel_ != 4) || (header[17] & 0x10) != 0) return false;
+	file.ignore(header[0]);
+	const size_t row_size = static_cast<size_t>(image.width_) * image.bytes_per_pixel_;
+	std::vector<unsigned char> pixels(row_size * image.height_);
+	if(!run_length_encoded)
+	{
+		if(!file.read(reinterpret_cast<char *>(pixels.data()), static_cast<std::streamsize>(pixels.size()))) return false;
+	}
+	else
+	{
+		size_t position = 0;
+		while(position < pixels.size())
+		{
+			const int packet_header = file.get();
+			if(packet_header == EOF) return false;
+			const size_t packet_size = static_cast<size_t>((packet_header & 0x7f) + 1) * image.bytes_per_pixel_;
+			if(position + packet_size > pixels.size()) return false;
+			if(packet_header & 0x80)
+			{
+				unsigned char pixel[4];
+				if(!file.read(reinterpret_cast<char *>(pixel), image.bytes_per_pixel_)) return false;
+				for(size_t offset = 0; offset < packet_size; ++offset) pixels[position + offset] = pixel[offset % image.bytes_per_pixel_];
+			}
+			else if(!file.read(reinterpret_cast<char *>(pixels.data() + position), static_cast<std::streamsize>(packet_size))) return false;
+			position += packet_size;
+		}
+	}
+	if(header[17] & 0x20) image.pixels_ = std::move(pixels); //Top-left origin
+	else
+	{
+		image.pixels_.resize(pixels.size());
+		for(int row = 0; row < image.height_; ++row) std::copy(pixels.begin() + row_size * row, pixels.begin() + row_size * (row + 1), image.pixels_.begin() + row_size * (image.height_ - 1 - row));
+	}
+	return true;
+}
+
+namespace
+{
+
+bool writeTga(const std::string &file_path, const TgaImage &image)
+{
+	std::ofstream file(file_path, std::ios::binary);
+	const unsigned char header[18]{0, 0, static_cast<unsigned char>(image.gray_ ? 3 : 2), 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		static_cast<unsigned char>(image.width_ & 0xff), static_cast<unsigned char>(image.width_ >> 8),
+		static_cast<unsigned char>(image.height_ & 0xff), static_cast<unsigned char>(image.height_ >> 8),
+		static_cast<unsigned char>(image.bytes_per_pixel_ * 8), static_cast<unsigned char>(image.alpha_bits_ | 0x20)};
+	file.write(reinterpret_cast<const char *>(header), sizeof header);
+	file.write(reinterpret_cast<const char *>(image.pixels_.data()), static_cast<std::streamsize>(image.pixels_.size()));
+	return static_cast<bool>(file);
+}
+
+//! Final and partial image paths of the outputs of a region
+bool readManifest(const std::string &file_path, std::vector<std::pair<std::string, std::string>> &outputs)
+{
+	std::ifstream file(file_path);
+	if(!file) return false;
+	std::string line;
+	while(std::getline(file, line))
+	{
+		const size_t separator = line.find('\t');
+		if(separator == std::string::npos) return false;
+		outputs.emplace_back(line.substr(0, separator), line.substr(separator + 1));
+	}
+	return true;
+}
+
+} //namespace
+
+std::string regionManifestPath_global(const std::string &xml_file_path, size_t region_index, size_t regions)
+{
+	return xml_file_path + ".region" + std::to_string(region_index) + "of" + std::to_string(regions) + ".txt";
+}
+
+bool mergeRegions_global(yafaray_Logger *yafaray_logger, const std::string &xml_file_path, size_t regions)
+{
+	std::vector<std::vector<std::pair<std::string, std::string>>> region_outputs(regions);
+	for(size_t region_index = 0; region_index < regions; ++region_index)
+	{
+		const std::string manifest_path{regionManifestPath_global(xml_file_path, region_index, regions)};
+		if(!readManifest(manifest_path, region_outputs[region_index]) || region_outputs[region_index].size() != region_outputs[0].size())
+		{
+			yafaray_printError(yafaray_logger, ("Regions: cannot read the region manifest '" + manifest_path + "', or it does not match the first region").c_str());
+			return false;
+		}
+	}
+	bool merge_ok = true;
+	for(size_t output_index = 0; output_index < region_outputs[0].size(); ++output_index)
+	{
+		//The regions are horizontal strips in order from the top of the image
+		TgaImage merged_image;
+		for(size_t region_index = 0; region_index < regions && merge_ok; ++region_index)
+		{
+			const auto &output = region_outputs[region_index][output_index];
+			TgaImage region_image;
+			if(output.first != region_outputs[0][output_index].first || !readTga_global(output.second, region_image))
+			{
+				yafaray_printError(yafaray_logger, ("Regions: cannot read the partial image '" + output.second + "'").c_str());
+				merge_ok = false;
+			}
+			else if(region_index == 0) merged_image = std::move(region_image);
+			else if(region_image.width_ != merged_image.width_ || region_image.bytes_per_pixel_ != merged_image.bytes_per_pixel_ || region_image.gray_ != merged_image.gray_)
+			{
+				yafaray_printError(yafaray_logger, ("Regions: the partial image '" + output.second + "' does not match the size or format of the other regions").c_str());
+				merge_ok = false;
+			}
+			else
+			{
+				merged_image.height_ += region_image.height_;
+				merged_image.pixels_.insert(merged_image.pixels_.end(), region_image.pixels_.begin(), region_image.pixels_.end());
+			}
+		}
+		if(!merge_ok) break;
+		//Only TGA outputs are rendered by regions, so the merged image is written to the image path of the output
+		const std::string &image_path{region_outputs[0][output_index].first};
+		if(merged_image.height_ > 0xffff || !writeTga(image_path, merged_image))
+		{
+			yafaray_printError(yafaray_logger, ("Regions: cannot write the merged image '" + image_path + "'").c_str());
+			merge_ok = false;
+			break;
+		}
+		yafaray_printInfo(yafaray_logger, ("Regions: merged image '" + image_path + "'").c_str());
+	}
+	if(!merge_ok) return false;
+	for(size_t region_index = 0; region_index < regions; ++region_index)
+	{
+		for(const auto &output : region_outputs[region_index]) std::remove(output.second.c_str());
+		std::remove(regionManifestPath_global(xml_file_path, region_index, regions).c_str());
+	}
+	return true;
+}
+
+#ifndef WIN32
+bool renderRegionProcesses_global(yafaray_Logger *yafaray_logger, const std::string &program_path, const std::vector<std::string> &option_arguments, const std::vector<std::string> &xml_file_paths, size_t regions)
+{
+	std::vector<pid_t> process_ids;
+	bool processes_ok = true;
+	for(size_t region_index = 0; region_index < regions; ++region_index)
+	{
+		std::vector<std::string> region_arguments{program_path};
+		region_arguments.insert(region_arguments.end(), option_arguments.begin(), option_arguments.end());
+		region_arguments.push_back("--region");
+		region_arguments.push_back(std::to_string(region_index) + "/" + std::to_string(regions));
+		region_arguments.insert(region_arguments.end(), xml_file_paths.begin(), xml_file_paths.end());
+		std::vector<char *> region_argv;
+		for(auto &argument : region_arguments) region_argv.push_back(&argument[0]);
+		region_argv.push_back(nullptr);
+		pid_t process_id;
+		if(posix_spawnp(&process_id, region_argv[0], nullptr, nullptr, region_argv.data(), environ) != 0)
+		{
+			yafaray_printError(yafaray_logger, ("Regions: cannot start the process for region " + std::to_string(region_index)).c_str());
+			processes_ok = false;
+			break;
+		}
+		process_ids.push_back(process_id);
+	}
+	for(const pid_t process_id : process_ids)
+	{
+		int status = 0;
+		if(waitpid(process_id, &status, 0) != process_id || !WIFEXITED(status) || WEXITSTATUS(status) != 0) processes_ok = false;
+	}
+	if(!processes_ok)
+	{
+		yafaray_printError(yafaray_logger, "Regions: the render of some regions failed, not merging them");
+		return false;
+	}
+	return mergeRegions_global(yafaray_logger, xml_file_paths.front(), regions);
+}
+#endif
@@ -0,0 +1,50 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_LOADER_FILM_REGIONS_H
+#define LIBYAFARAY_XML_LOADER_FILM_REGIONS_H
+
+#include "yafaray_xml_c_api.h"
+#include <string>
+#include <vector>
+
+//! Uncompressed image with its rows from top to bottom, as read from or written to a TGA file
+struct TgaImage
+{
+	int width_ = 0;
+	int height_ = 0;
+	int bytes_per_pixel_ = 0;
+	bool gray_ = false;
+	unsigned char alpha_bits_ = 0;
+	std::vector<unsigned char> pixels_;
+};
+
+//! Reads an 8 bit true color or gray TGA image, uncompressed or run length encoded. Returns false if it cannot be read or has another format
+bool readTga_global(const std::string &file_path, TgaImage &image);
+//! Path of the manifest written by the render of a film region. It is next to the XML file, so the merge finds it also when the regions were rendered in other nodes sharing the filesystem
+std::string regionManifestPath_global(const std::string &xml_file_path, size_t region_index, size_t regions);
+//! Merges the partial TGA images listed in the manifests of all the regions into their final TGA images, removing the partial images and manifests. Returns false if any region is missing or the images do not match
+bool mergeRegions_global(yafaray_Logger *yafaray_logger, const std::string &xml_file_path, size_t regions);
+#ifndef WIN32
+//! Renders each film region in its own process, running this program again with the given options, "--region <index>/<regions>" and the XML files, and merges the regions. Returns false if any process failed
+bool renderRegionProcesses_global(yafaray_Logger *yafaray_logger, const std::string &program_path, const std::vector<std::string> &option_arguments, const std::vector<std::string> &xml_file_paths, size_t regions);
+#endif
+
+#endif //LIBYAFARAY_XML_LOADER_FILM_REGIONS_H
@@ -18,20 +18,35 @@
 
 #include "yafaray_xml_c_api.h"
 #include "command_line_parser.h"
+#include "render_job.h"
+#include "phase_report.h"
+#include "film_regions.h"
+#include <algorithm>
+#include <atomic>
 #include <csignal>
 #include <fstream>
+#include <sstream>
 
 #ifdef WIN32
 #include <windows.h>
+#else
+#include "render_server.h"
 #endif
 
 yafaray_Logger *yafaray_logger_global = nullptr;
 yafaray_RenderControl *yafaray_render_control_global = yafaray_createRenderControl();
+yafaray_xml_ParseControl *yafaray_parse_control_global = yafaray_xml_createParseControl();
+std::atomic<bool> render_cancelled_global{false};
+#ifndef WIN32
+RenderServer *render_server_global = nullptr;
+#endif
 
 #ifdef WIN32
 BOOL WINAPI ctrlCHandler_global(DWORD signal)
 {
 	yafaray_printWarning(yi, "CTRL+C pressed, cancelling.\n");
+	if(yafaray_parse_control_global) yafaray_xml_cancelParsing(yafaray_parse_control_global);
+	render_cancelled_global = true;
 	if(yafaray_render_control_global)
 	{
 		yafaray_cancelRendering(yafaray_render_control_global);
@@ -42,9 +57,12 @@ BOOL WINAPI ctrlCHandler_global(DWORD signal)
 #else
 void ctrlCHandler_global(int /*signal*/)
 {
-	if(yafaray_logger_global)
+	if(render_server_global) render_server_global->requestStop();
+	else if(yafaray_logger_global)
 	{
 		yafaray_printWarning(yafaray_logger_global, "CTRL+C pressed, cancelling.\n");
+		if(yafaray_parse_control_global) yafaray_xml_cancelParsing(yafaray_parse_control_global);
+		render_cancelled_global = true;
 		if(yafaray_render_control_global) yafaray_cancelRendering(yafaray_render_control_global);
 		else exit(1);
 	}
@@ -66,12 +84,16 @@ int main(int argc, char *argv[])
 		signal(SIGINT, ctrlCHandler_global);
 	#endif
 
-	CliParser parse(argc, argv, 2, 1, "You need to set at least a yafaray's valid XML file.");
+	const int max_clean_args = std::max(2, argc); //Any number of XML files
+	CliParser parse(argc, argv, max_clean_args, max_clean_args - 1, "You need to set at least a yafaray's valid XML file.");
 
 	char *version_string = yafaray_xml_getVersionString();
 	parse.setAppName("YafaRay XML loader v" + std::string(version_string),
-					 std::string{"[OPTIONS]... <input xml file>\n"}
-					 + "<input xml file> : A valid yafaray XML file\n"
+					 std::string{"[OPTIONS]... <input xml file> [<more input xml files>]...\n"}
+					 + "<input xml file> : A valid yafaray XML file. Several files are parsed concurrently into one container, merging their scenes into the scene of the first file\n"
+#ifndef WIN32
+					 + "<server socket path> : When running as render server, the Unix domain socket path to listen on instead of the input xml file\n"
+#endif
 					 + "*Note: the output file name(s) and parameters are defined in the XML file, in the <output> tags.");
 
 	parse.setOption("v", "version", true, "Displays this program's version.");
@@ -95,8 +117,36 @@ int main(int argc, char *argv[])
 	+ "                                       \"XYZ\" (experimental)\n");
 	parse.setOption("ig", "input-gamma", false, R"(Sets the input gamma for the input color space, 1.0 by default)");
 	parse.setOption("sn", "scene-name", false, R"(Scene name from XML file to be rendered. If not specified or does not exist in the XML, the first scene in the XML will be rendered)");
-	parse.setOption("in", "integrator-name", false, R"(Surface Integrator name from XML file to be rendered. If not specified or does not exist in the XML, the first surface integrator in the XML will be rendered)");
-	parse.setOption("fn", "film-name", false, R"(Film name from XML file to be rendered. If not specified or does not exist in the XML, the first film in the XML will be rendered)");
+	parse.setOption("in", "integrator-name", false, R"(Surface Integrator name from XML file to be rendered, or comma separated list of names. If not specified or does not exist in the XML, the first surface integrator in the XML will be rendered)");
+	parse.setOption("fn", "film-name", false, R"(Film name from XML file to be rendered, or comma separated list of names. If not specified or does not exist in the XML, the first film in the XML will be rendered)");
+	parse.setOption("p", "param-override", false, "Overrides the value of the matching parameters of the XML file while parsing it, as path=value. Can be repeated. For example:\n"
+	"                                       -p scene.accelerator.threads=32 -p film.parameters.width=960 -p scene.material[Glass].IOR=1.5\n"
+	"                                       Vectors, colors and matrices are given as numbers separated by commas, and \"*\" matches any element");
+	parse.setOption("rgn", "region", false, "Renders only the region <index>/<regions> of the films, an horizontal strip with index from 0 to regions - 1, writing partial TGA images to be merged with --merge-regions.\n"
+	"                                       The outputs must be TGA images, and their badges and denoising are disabled. The regions can be rendered in different nodes sharing the filesystem");
+	parse.setOption("mrg", "merge-regions", false, "Merges the partial images of the given number of regions, rendered before with --region, into TGA images");
+#ifndef WIN32
+	parse.setOption("rgs", "regions", false, "Splits the films into the given number of horizontal strips, each one rendered in its own process, and merges them. The outputs must be TGA images, see --region");
+#endif
+	parse.setOption("ra", "render-all", true, "If specified, every film of the XML file (or those given by name) is rendered with the surface integrator it was created with, parsing and preprocessing the scene only once.\n"
+	"                                       Films created with a surface integrator not selected by name are skipped");
+	parse.setOption("cs", "concurrent-scenes", true, "If specified, each scene in the XML file is built in its own thread");
+	parse.setOption("pf", "prefetch-images", true, "If specified, the image files referenced in the XML file are read in background while parsing, to have them cached by the OS in advance");
+	parse.setOption("dg", "deduplicate-geometry", true, "If specified, objects with the same geometry as a previous object, except for a translation, are added as instances of it. Mesh lights and objects referred to by earlier lights are kept as they are");
+	parse.setOption("dr", "deduplicate-resources", true, "If specified, materials, textures and images with the same parameters as a previous one are not created again, and the references to them use the previous one instead");
+	parse.setOption("bt", "builtin-tokenizer", true, "If specified, the XML file is parsed with the built-in tokenizer instead of libxml2, which is faster but does not read DTDs");
+	parse.setOption("ar", "arena-allocation", true, "If specified, the temporary memory used while parsing is taken from pools released all at once at the end of the parsing");
+	parse.setOption("tr", "trace-file", false, "Writes the time spent in each XML element and libYafaRay call during the parsing to the file given, in the Chrome trace event JSON format (chrome://tracing or Perfetto)");
+	parse.setOption("rp", "report", false, "Writes the wall time, CPU time, resident memory and page faults of each phase (parsing, preprocessing, rendering) to the JSON file given");
+	parse.setOption("pl", "progressive-load", false, "Builds the scene geometry after the rest of the XML file, in steps of the given number of objects, rendering a quick preview of the partial scene after each step, with one sample per pixel and without writing the outputs");
+	parse.setOption("plt", "progressive-load-time", false, "Same as --progressive-load, but with steps of the given time in milliseconds. Both can be used together, ending each step with whichever comes first");
+	parse.setOption("po", "parse-only", true, "If specified, stops after parsing the XML file, without preprocessing nor rendering the scene");
+	parse.setOption("pp", "preprocess-only", true, "If specified, stops after preprocessing the scene and surface integrator, without rendering");
+#ifndef WIN32
+	parse.setOption("srv", "server", true, "If specified, runs as a persistent render server accepting render jobs on the Unix domain socket given instead of the input xml file.\n"
+	"                                       The options above are used as defaults for the jobs. See render_server.h for the request protocol");
+	parse.setOption("smb", "server-max-buffer", false, "When running as render server, the largest XML document in MiB accepted from memory by RENDER_MEMORY requests. 1024 by default");
+#endif
 
 	const bool parse_ok = parse.parseCommandLine();
 	if(!parse_ok)
@@ -135,80 +185,126 @@ int main(int argc, char *argv[])
 	if(log_verb_level.empty()) yafaray_setLogVerbosityLevel(yafaray_logger_global, YAFARAY_LOG_LEVEL_VERBOSE);
 	else yafaray_setLogVerbosityLevel(yafaray_logger_global, yafaray_logLevelFromString(verb_level.c_str()));
 
-	std::string input_color_space_string = parse.getOptionString("ics");
-	if(input_color_space_string.empty()) input_color_space_string = "LinearRGB";
-	float input_gamma = static_cast<float>(parse.getOptionFloat("ig"));
-	if(isNan_global(input_gamma)) input_gamma = 1.f;
+	RenderJobSettings render_job_settings;
+	const std::string input_color_space_string = parse.getOptionString("ics");
+	if(!input_color_space_string.empty()) render_job_settings.input_color_space_ = input_color_space_string;
+	const float input_gamma = static_cast<float>(parse.getOptionFloat("ig"));
+	if(!isNan_global(input_gamma)) render_job_settings.input_gamma_ = input_gamma;
+	render_job_settings.scene_name_ = parse.getOptionString("sn");
+	render_job_settings.integrator_name_ = parse.getOptionString("in");
+	render_job_settings.film_name_ = parse.getOptionString("fn");
+	render_job_settings.concurrent_scenes_ = parse.isFlagSet("cs");
+	render_job_settings.prefetch_image_files_ = parse.isFlagSet("pf");
+	render_job_settings.deduplicate_geometry_ = parse.isFlagSet("dg");
+	render_job_settings.deduplicate_resources_ = parse.isFlagSet("dr");
+	render_job_settings.builtin_tokenizer_ = parse.isFlagSet("bt");
+	render_job_settings.arena_allocation_ = parse.isFlagSet("ar");
+	render_job_settings.trace_file_path_ = parse.getOptionString("tr");
+	render_job_settings.report_file_path_ = parse.getOptionString("rp");
+	render_job_settings.parse_only_ = parse.isFlagSet("po");
+	render_job_settings.preprocess_only_ = parse.isFlagSet("pp");
+	render_job_settings.render_all_ = parse.isFlagSet("ra");
+	render_job_settings.param_overrides_ = parse.getOptionStrings("p");
+	render_job_settings.progressive_load_objects_per_step_ = static_cast<size_t>(std::max(0, parse.getOptionInteger("pl")));
+	render_job_settings.progressive_load_step_time_ms_ = std::max(0, parse.getOptionInteger("plt"));
+	render_job_settings.preview_render_control_ = yafaray_render_control_global;
+	std::vector<ParsedFilm> parsed_films;
+	render_job_settings.parsed_films_ = &parsed_films;
+	render_job_settings.render_cancelled_ = &render_cancelled_global;
 
 	const std::vector<std::string> files = parse.getCleanArgs();
 	if(files.empty()) return 0;
 	const auto &xml_file_path{files.at(0)};
 
-//#define USE_XML_ALTERNATE_MEMORY_PARSING_METHOD
-#ifdef USE_XML_ALTERNATE_MEMORY_PARSING_METHOD
-	// Test using standard ParseMemory (alternative just to demonstrate memory parsing)
-	yafaray_printInfo(yafaray_logger_global, ("Parsing file '" + xml_file_path + "' using alternate ParseMemory method").c_str());
-	const std::ifstream xml_stream(xml_file_path);
-	std::stringstream xml_stream_buffer;
-	xml_stream_buffer << xml_stream.rdbuf();
-	const std::string xml_string = xml_stream_buffer.str();
-	yafaray_Container *container = yafaray_xml_ParseMemory(yafaray_logger_global, xml_string.c_str(), static_cast<int>(xml_string.size()), input_color_space_string.c_str(), input_gamma);
-#else
-	// Regular code using standard ParseFile (recommended)
-	yafaray_printInfo(yafaray_logger_global, ("Parsing file '" + xml_file_path + "' using standard ParseFile method").c_str());
-	yafaray_Container *container = yafaray_xml_ParseFile(yafaray_logger_global, xml_file_path.c_str(), input_color_space_string.c_str(), input_gamma);
-#endif
-
-	const std::string scene_name = parse.getOptionString("sn");
-	yafaray_Scene *yafaray_scene{nullptr};
-	if(scene_name.empty())
+	const std::string region_string = parse.getOptionString("rgn");
+	if(!region_string.empty())
 	{
-		yafaray_scene = yafaray_getSceneFromContainerByIndex(container, 0);
+		unsigned long region_index = 0, regions = 0;
+		char region_separator = '\0';
+		std::istringstream region_stream(region_string);
+		if(!(region_stream >> region_index >> region_separator >> regions) || region_separator != '/' || regions < 2 || region_index >= regions)
+		{
+			yafaray_printError(yafaray_logger_global, ("Invalid region '" + region_string + "', it must be <index>/<regions> with index from 0 to regions - 1").c_str());
+			return 1;
+		}
+		render_job_settings.film_region_index_ = region_index;
+		render_job_settings.film_regions_ = regions;
+		render_job_settings.film_region_manifest_path_ = regionManifestPath_global(xml_file_path, region_index, regions);
 	}
-	else if(!yafaray_scene)
+	const int merge_regions = parse.getOptionInteger("mrg");
+	if(merge_regions > 1)
 	{
-		yafaray_printWarning(yafaray_logger_global, ("Scene name '" + scene_name + "' not found in XML file, using the first scene in the file").c_str());
-		yafaray_scene = yafaray_getSceneFromContainerByIndex(container, 0);
+		const bool merge_ok = mergeRegions_global(yafaray_logger_global, xml_file_path, static_cast<size_t>(merge_regions));
+		yafaray_destroyRenderControl(yafaray_render_control_global);
+		yafaray_xml_destroyParseControl(yafaray_parse_control_global);
+		yafaray_destroyLogger(yafaray_logger_global);
+		yafaray_xml_destroyCharString(version_string);
+		return merge_ok ? 0 : 1;
 	}
-	else yafaray_scene = yafaray_getSceneFromContainerByName(container, scene_name.c_str());
-
-	const std::string integrator_name = parse.getOptionString("in");
-	yafaray_SurfaceIntegrator *yafaray_surface_integrator{nullptr};
-	if(integrator_name.empty())
+#ifndef WIN32
+	const int regions = parse.getOptionInteger("rgs");
+	if(regions > 1)
 	{
-		yafaray_surface_integrator = yafaray_getSurfaceIntegratorFromContainerByIndex(container, 0);
+		const bool regions_ok = renderRegionProcesses_global(yafaray_logger_global, argv[0], parse.getOptionArgs({"rgs", "rgn", "mrg", "srv"}), files, static_cast<size_t>(regions));
+		yafaray_destroyRenderControl(yafaray_render_control_global);
+		yafaray_xml_destroyParseControl(yafaray_parse_control_global);
+		yafaray_destroyLogger(yafaray_logger_global);
+		yafaray_xml_destroyCharString(version_string);
+		return regions_ok ? 0 : 1;
 	}
-	else if(!yafaray_surface_integrator)
+#endif
+
+#ifndef WIN32
+	if(parse.isFlagSet("srv"))
 	{
-		yafaray_printWarning(yafaray_logger_global, ("Surface Integrator name '" + integrator_name + "' not found in XML file, using the first surface integrator in the file").c_str());
-		yafaray_surface_integrator = yafaray_getSurfaceIntegratorFromContainerByIndex(container, 0);
+		bool server_ok;
+		{
+			const int server_max_buffer_mib = parse.getOptionInteger("smb");
+			const size_t server_max_buffer_size = static_cast<size_t>(server_max_buffer_mib > 0 ? server_max_buffer_mib : 1024) * 1024 * 1024;
+			RenderServer render_server(yafaray_logger_global, xml_file_path, render_job_settings, server_max_buffer_size);
+			render_server_global = &render_server;
+			server_ok = render_server.run();
+			render_server_global = nullptr;
+		}
+		yafaray_destroyRenderControl(yafaray_render_control_global);
+		yafaray_xml_destroyParseControl(yafaray_parse_control_global);
+		yafaray_destroyLogger(yafaray_logger_global);
+		yafaray_xml_destroyCharString(version_string);
+		return server_ok ? 0 : 1;
 	}
-	else yafaray_surface_integrator = yafaray_getSurfaceIntegratorFromContainerByName(container, integrator_name.c_str());
+#endif
 
-	const std::string film_name = parse.getOptionString("fn");
-	yafaray_Film *yafaray_film{nullptr};
-	if(film_name.empty())
+	PhaseReport phase_report;
+//#define USE_XML_ALTERNATE_MEMORY_PARSING_METHOD
+#ifdef USE_XML_ALTERNATE_MEMORY_PARSING_METHOD
+	// Test using standard ParseMemory (alternative just to demonstrate memory parsing)
+	yafaray_printInfo(yafaray_logger_global, ("Parsing file '" + xml_file_path + "' using alternate ParseMemory method").c_str());
+	const std::ifstream xml_stream(xml_file_path);
+	std::stringstream xml_stream_buffer;
+	xml_stream_buffer << xml_stream.rdbuf();
+	yafaray_Container *container = parseXmlMemory_global(yafaray_logger_global, xml_stream_buffer.str(), render_job_settings, yafaray_parse_control_global, &phase_report);
+#else
+	yafaray_Container *container = nullptr;
+	if(files.size() > 1)
 	{
-		yafaray_film = yafaray_getFilmFromContainerByIndex(container, 0);
+		yafaray_printInfo(yafaray_logger_global, ("Parsing " + std::to_string(files.size()) + " files into one container using ParseFiles method").c_str());
+		container = parseXmlFiles_global(yafaray_logger_global, files, render_job_settings, yafaray_parse_control_global, &phase_report);
 	}
-	else if(!yafaray_film)
+	else
 	{
-		yafaray_printWarning(yafaray_logger_global, ("Film name '" + film_name + "' not found in XML file, using the first film in the file").c_str());
-		yafaray_film = yafaray_getFilmFromContainerByIndex(container, 0);
+		// Regular code using standard ParseFile (recommended)
+		yafaray_printInfo(yafaray_logger_global, ("Parsing file '" + xml_file_path + "' using standard ParseFile method").c_str());
+		container = parseXmlFile_global(yafaray_logger_global, xml_file_path, render_job_settings, yafaray_parse_control_global, &phase_report);
 	}
-	else yafaray_film = yafaray_getFilmFromContainerByName(container, film_name.c_str());
-
-	yafaray_setRenderControlForNormalStart(yafaray_render_control_global);
-	yafaray_SceneModifiedFlags yafaray_scene_modified_flags{YAFARAY_SCENE_MODIFIED_NOTHING};
-	yafaray_scene_modified_flags = yafaray_checkAndClearSceneModifiedFlags(yafaray_scene);
-	yafaray_preprocessScene(yafaray_scene, yafaray_render_control_global, yafaray_scene_modified_flags);
-	yafaray_RenderMonitor *yafaray_render_monitor = yafaray_createRenderMonitor(nullptr, nullptr, YAFARAY_DISPLAY_CONSOLE_NORMAL);
-	yafaray_preprocessSurfaceIntegrator(yafaray_render_monitor, yafaray_surface_integrator, yafaray_render_control_global, yafaray_scene);
-	yafaray_render(yafaray_render_control_global, yafaray_render_monitor, yafaray_surface_integrator, yafaray_film);
-	yafaray_destroyRenderMonitor(yafaray_render_monitor);
+#endif
+
+	if(container) renderContainer_global(yafaray_logger_global, container, yafaray_render_control_global, render_job_settings, &phase_report);
+	if(!render_job_settings.report_file_path_.empty() && !phase_report.writeFile(render_job_settings.report_file_path_, xml_file_path)) yafaray_printError(yafaray_logger_global, ("Cannot write the report file '" + render_job_settings.report_file_path_ + "'").c_str());
+	const bool region_failed = (render_job_settings.film_regions_ > 1 && !container); //So the process rendering all the regions knows it failed
 	yafaray_destroyRenderControl(yafaray_render_control_global);
-	yafaray_destroyContainerAndContainedPointers(container);
+	yafaray_xml_destroyParseControl(yafaray_parse_control_global);
+	if(container) yafaray_destroyContainerAndContainedPointers(container);
 	yafaray_destroyLogger(yafaray_logger_global);
 	yafaray_xml_destroyCharString(version_string);
-	return 0;
+	return region_failed ? 1 : 0;
 }
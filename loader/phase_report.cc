@@ -0,0 +1,130 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "phase_report.h"
+#include "common/json_string.h"
+#include <fstream>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+#ifdef WIN32
+double fileTimeSeconds_global(const FILETIME &file_time)
+{
+	ULARGE_INTEGER hundreds_of_nanoseconds;
+	hundreds_of_nanoseconds.LowPart = file_time.dwLowDateTime;
+	hundreds_of_nanoseconds.HighPart = file_time.dwHighDateTime;
+	return static_cast<double>(hundreds_of_nanoseconds.QuadPart) / 1e7;
+}
+#elif defined(__linux__)
+long residentSetKib_global()
+{
+	std::ifstream statm("/proc/self/statm");
+	long total_pages = 0, resident_pages = 0;
+	if(!(statm >> total_pages >> resident_pages)) return 0;
+	return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+#endif
+
+} //namespace
+
+PhaseReport::ResourceUsage PhaseReport::getResourceUsage()
+{
+	ResourceUsage resource_usage;
+	resource_usage.wall_time_ = std::chrono::steady_clock::now();
+#ifdef WIN32
+	FILETIME creation_time, exit_time, kernel_time, user_time;
+	if(GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time)) resource_usage.cpu_time_seconds_ = fileTimeSeconds_global(kernel_time) + fileTimeSeconds_global(user_time); //Memory and page faults not available without linking psapi
+#else
+	rusage usage{};
+	if(getrusage(RUSAGE_SELF, &usage) != 0) return resource_usage;
+	resource_usage.cpu_time_seconds_ = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#ifdef __APPLE__
+	resource_usage.peak_rss_kib_ = usage.ru_maxrss / 1024; //In bytes in macOS, in KiB in Linux
+#else
+	resource_usage.peak_rss_kib_ = usage.ru_maxrss;
+#endif
+	resource_usage.minor_page_faults_ = usage.ru_minflt;
+	resource_usage.major_page_faults_ = usage.ru_majflt;
+#ifdef __linux__
+	resource_usage.rss_kib_ = residentSetKib_global();
+#endif
+#endif
+	return resource_usage;
+}
+
+void PhaseReport::startPhase(const std::string &phase_name)
+{
+	Phase phase;
+	phase.name_ = phase_name;
+	phase.start_ = getResourceUsage();
+	phases_.push_back(phase);
+}
+
+void PhaseReport::endPhase(bool success)
+{
+	if(phases_.empty()) return;
+	phases_.back().end_ = getResourceUsage();
+	phases_.back().success_ = success;
+}
+
+bool PhaseReport::writeFile(const std::string &file_path, const std::string &xml_file_path) const
+{
+	std::ofstream file(file_path);
+	if(!file) return false;
+	double total_wall_time_seconds = 0.0;
+	double total_cpu_time_seconds = 0.0;
+	long peak_rss_kib = 0;
+	bool success = !phases_.empty();
+	file << "{\n\t\"xml_file\": ";
+	yafaray_xml::writeJsonString(file, xml_file_path);
+	file << ",\n\t\"phases\": [";
+	for(size_t phase_index = 0; phase_index < phases_.size(); ++phase_index)
+	{
+		const Phase &phase{phases_[phase_index]};
+		const double wall_time_seconds = std::chrono::duration<double>(phase.end_.wall_time_ - phase.start_.wall_time_).count();
+		const double cpu_time_seconds = phase.end_.cpu_time_seconds_ - phase.start_.cpu_time_seconds_;
+		total_wall_time_seconds += wall_time_seconds;
+		total_cpu_time_seconds += cpu_time_seconds;
+		if(phase.end_.peak_rss_kib_ > peak_rss_kib) peak_rss_kib = phase.end_.peak_rss_kib_;
+		success = success && phase.success_;
+		file << (phase_index > 0 ? "," : "") << "\n\t\t{\"name\": ";
+		yafaray_xml::writeJsonString(file, phase.name_);
+		file << ", \"success\": " << (phase.success_ ? "true" : "false")
+			 << ", \"wall_time_seconds\": " << wall_time_seconds
+			 << ", \"cpu_time_seconds\": " << cpu_time_seconds
+			 << ", \"rss_kib\": " << phase.end_.rss_kib_
+			 << ", \"process_peak_rss_kib\": " << phase.end_.peak_rss_kib_
+			 << ", \"minor_page_faults\": " << phase.end_.minor_page_faults_ - phase.start_.minor_page_faults_
+			 << ", \"major_page_faults\": " << phase.end_.major_page_faults_ - phase.start_.major_page_faults_ << "}";
+	}
+	file << "\n\t],\n\t\"success\": " << (success ? "true" : "false")
+		 << ",\n\t\"wall_time_seconds\": " << total_wall_time_seconds
+		 << ",\n\t\"cpu_time_seconds\": " << total_cpu_time_seconds
+		 << ",\n\t\"process_peak_rss_kib\": " << peak_rss_kib << "\n}\n";
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,60 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef LIBYAFARAY_XML_LOADER_PHASE_REPORT_H
+#define LIBYAFARAY_XML_LOADER_PHASE_REPORT_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+//! Measures the wall time, CPU time, peak resident memory and page faults of each phase of a render job (parsing, preprocessing and rendering), to be written as a JSON report
+/*! The CPU time and page faults are those of the whole process, including the threads started by libYafaRay and the XML parser.
+ *  Each phase reports the resident memory at its end (rss_kib, only in Linux) and the process high water mark at that point (process_peak_rss_kib). The latter is process-wide since the start, so it never decreases between phases and a phase can show the peak reached by an earlier one */
+class PhaseReport final
+{
+	public:
+		void startPhase(const std::string &phase_name);
+		void endPhase(bool success);
+		//! Writes the report as JSON, returns false if the file could not be written
+		bool writeFile(const std::string &file_path, const std::string &xml_file_path) const;
+
+	private:
+		struct ResourceUsage
+		{
+			std::chrono::steady_clock::time_point wall_time_;
+			double cpu_time_seconds_ = 0.0;
+			long peak_rss_kib_ = 0;
+			long rss_kib_ = 0;
+			long minor_page_faults_ = 0;
+			long major_page_faults_ = 0;
+		};
+		struct Phase
+		{
+			std::string name_;
+			ResourceUsage start_;
+			ResourceUsage end_;
+			bool success_ = false;
+		};
+		static ResourceUsage getResourceUsage();
+		std::vector<Phase> phases_;
+};
+
+#endif //LIBYAFARAY_XML_LOADER_PHASE_REPORT_H
@@ -0,0 +1,281 @@
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "render_job.h"
+#include "phase_report.h"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+struct ParseProgress
+{
+	yafaray_Logger *yafaray_logger_ = nullptr;
+	size_t last_step_printed_ = 0;
+	const RenderJobSettings *render_job_settings_ = nullptr;
+};
+
+//! Prints the parsing progress every 10% of the file, or every 64MiB parsed when the file size is unknown. Nothing is printed for files parsed before the first progress report
+void printParseProgress(size_t bytes_parsed, size_t bytes_total, const char *scene_name, const char *object_name, void *callback_data)
+{
+	ParseProgress &parse_progress = *static_cast<ParseProgress *>(callback_data);
+	if(bytes_parsed == bytes_total && parse_progress.last_step_printed_ == 0) return;
+	const size_t step = bytes_total > 0 ? bytes_parsed * 10 / bytes_total : bytes_parsed / (64 * 1024 * 1024);
+	if(step <= parse_progress.last_step_printed_) return;
+	parse_progress.last_step_printed_ = step;
+	std::string message = "Parsing: " + (bytes_total > 0 ? std::to_string(step * 10) + "%" : std::to_string(bytes_parsed / (1024 * 1024)) + "MiB");
+	if(scene_name && scene_name[0] != '\0') message += ", scene '" + std::string(scene_name) + "'";
+	if(object_name && object_name[0] != '\0') message += ", object '" + std::string(object_name) + "'";
+	yafaray_printInfo(parse_progress.yafaray_logger_, message.c_str());
+}
+
+std::vector<std::string> splitNames(const std::string &names)
+{
+	std::vector<std::string> result;
+	size_t name_start = 0;
+	while(name_start <= names.size())
+	{
+		size_t name_end = names.find(',', name_start);
+		if(name_end == std::string::npos) name_end = names.size();
+		if(name_end > name_start) result.push_back(names.substr(name_start, name_end - name_start));
+		name_start = name_end + 1;
+	}
+	return result;
+}
+
+//! Renders a quick preview of the partial scene in the preview film of the first film selected, until the last step of the progressive loading, which is rendered as usual after the parsing
+void renderProgressiveLoadPreview(yafaray_Container *container, size_t objects_built, size_t objects_total, void *callback_data)
+{
+	const ParseProgress &parse_progress = *static_cast<const ParseProgress *>(callback_data);
+	const RenderJobSettings &render_job_settings = *parse_progress.render_job_settings_;
+	yafaray_printInfo(parse_progress.yafaray_logger_, ("Progressive loading: " + std::to_string(objects_built) + "/" + std::to_string(objects_total) + " objects built").c_str());
+	if(objects_built == objects_total || !render_job_settings.preview_render_control_ || render_job_settings.parse_only_ || render_job_settings.preprocess_only_) return;
+	RenderJobSettings preview_render_job_settings{render_job_settings};
+	preview_render_job_settings.render_all_ = false;
+	preview_render_job_settings.preview_ = true;
+	const std::vector<std::string> integrator_names{splitNames(render_job_settings.integrator_name_)};
+	preview_render_job_settings.integrator_name_ = integrator_names.empty() ? std::string{} : integrator_names.front();
+	const std::vector<std::string> film_names{splitNames(render_job_settings.film_name_)};
+	preview_render_job_settings.film_name_ = film_names.empty() ? std::string{} : film_names.front();
+	renderContainer_global(parse_progress.yafaray_logger_, container, render_job_settings.preview_render_control_, preview_render_job_settings, nullptr);
+}
+
+void addParsedFilm(yafaray_Film *film, yafaray_SurfaceIntegrator *surface_integrator, yafaray_Film *preview_film, void *callback_data)
+{
+	ParsedFilm parsed_film;
+	parsed_film.film_ = film;
+	parsed_film.surface_integrator_ = surface_integrator;
+	parsed_film.preview_film_ = preview_film;
+	static_cast<std::vector<ParsedFilm> *>(callback_data)->push_back(parsed_film);
+}
+
+yafaray_xml_ParseOptions *createParseOptions(const RenderJobSettings &render_job_settings, ParseProgress &parse_progress, yafaray_xml_ParseControl *parse_control)
+{
+	yafaray_xml_ParseOptions *parse_options = yafaray_xml_createParseOptions();
+	if(render_job_settings.concurrent_scenes_) yafaray_xml_setParseOptionConcurrentScenes(parse_options, YAFARAY_BOOL_TRUE);
+	if(render_job_settings.prefetch_image_files_) yafaray_xml_setParseOptionPrefetchImageFiles(parse_options, YAFARAY_BOOL_TRUE);
+	if(render_job_settings.deduplicate_geometry_) yafaray_xml_setParseOptionDeduplicateGeometry(parse_options, YAFARAY_BOOL_TRUE);
+	if(render_job_settings.deduplicate_resources_) yafaray_xml_setParseOptionDeduplicateResources(parse_options, YAFARAY_BOOL_TRUE);
+	if(render_job_settings.builtin_tokenizer_) yafaray_xml_setParseOptionBuiltinTokenizer(parse_options, YAFARAY_BOOL_TRUE);
+	if(render_job_settings.arena_allocation_) yafaray_xml_setParseOptionArenaAllocation(parse_options, YAFARAY_BOOL_TRUE);
+	if(!render_job_settings.trace_file_path_.empty()) yafaray_xml_setParseOptionTraceFile(parse_options, render_job_settings.trace_file_path_.c_str());
+	if(render_job_settings.film_regions_ > 1) yafaray_xml_setParseOptionFilmRegion(parse_options, render_job_settings.film_region_index_, render_job_settings.film_regions_, render_job_settings.film_region_manifest_path_.c_str());
+	for(const auto &param_override : render_job_settings.param_overrides_)
+	{
+		if(!yafaray_xml_setParseOptionParamOverride(parse_options, param_override.c_str())) yafaray_printWarning(parse_progress.yafaray_logger_, ("Ignoring parameter override '" + param_override + "', it must be in the form element.element.parameter=value").c_str());
+	}
+	yafaray_xml_setParseOptionProgressCallback(parse_options, printParseProgress, &parse_progress);
+	if(render_job_settings.progressive_load_objects_per_step_ > 0 || render_job_settings.progressive_load_step_time_ms_ > 0)
+	{
+		parse_progress.render_job_settings_ = &render_job_settings;
+		yafaray_xml_setParseOptionProgressiveLoading(parse_options, renderProgressiveLoadPreview, &parse_progress, render_job_settings.progressive_load_objects_per_step_, render_job_settings.progressive_load_step_time_ms_);
+	}
+	if(parse_control) yafaray_xml_setParseOptionParseControl(parse_options, parse_control);
+	if(render_job_settings.include_cache_) yafaray_xml_setParseOptionIncludeCache(parse_options, render_job_settings.include_cache_);
+	if(render_job_settings.parsed_films_)
+	{
+		render_job_settings.parsed_films_->clear();
+		yafaray_xml_setParseOptionFilmCallback(parse_options, addParsedFilm, render_job_settings.parsed_films_);
+	}
+	return parse_options;
+}
+
+//! Gets the items in the comma separated list of names. Without names, gets all the items in the container if all_items is set, or only the first one otherwise
+template <typename T>
+std::vector<T *> selectContainerItems(yafaray_Logger *yafaray_logger, yafaray_Container *container, const std::string &names, bool all_items, T *(*get_by_name)(yafaray_Container *, const char *), T *(*get_by_index)(yafaray_Container *, size_t), const std::string &item_title, const std::string &item_kind)
+{
+	std::vector<T *> items;
+	const std::vector<std::string> name_list{splitNames(names)};
+	for(const auto &name : name_list)
+	{
+		T *item = get_by_name(container, name.c_str());
+		if(item) items.push_back(item);
+		else if(name_list.size() > 1) yafaray_printWarning(yafaray_logger, (item_title + " name '" + name + "' not found in XML file, skipping it").c_str());
+	}
+	if(!items.empty()) return items;
+	if(!names.empty()) yafaray_printWarning(yafaray_logger, (item_title + " name '" + names + "' not found in XML file, using the first " + item_kind + " in the file").c_str());
+	if(all_items && names.empty())
+	{
+		while(T *item = get_by_index(container, items.size())) items.push_back(item);
+	}
+	else if(T *item = get_by_index(container, 0)) items.push_back(item);
+	return items;
+}
+
+const ParsedFilm *findParsedFilm(yafaray_Film *film, const RenderJobSettings &render_job_settings)
+{
+	if(!render_job_settings.parsed_films_) return nullptr;
+	for(const auto &parsed_film : *render_job_settings.parsed_films_)
+	{
+		if(parsed_film.film_ == film) return &parsed_film;
+	}
+	return nullptr;
+}
+
+bool isPreviewFilm(yafaray_Film *film, const RenderJobSettings &render_job_settings)
+{
+	if(!render_job_settings.parsed_films_) return false;
+	for(const auto &parsed_film : *render_job_settings.parsed_films_)
+	{
+		if(parsed_film.preview_film_ == film) return true;
+	}
+	return false;
+}
+
+//! The surface integrator the film was created with, if it is one of those selected. Films not reported while parsing are rendered with the first one selected
+yafaray_SurfaceIntegrator *filmSurfaceIntegrator(yafaray_Film *film, const std::vector<yafaray_SurfaceIntegrator *> &surface_integrators, const RenderJobSettings &render_job_settings)
+{
+	const ParsedFilm *parsed_film = findParsedFilm(film, render_job_settings);
+	if(!parsed_film) return surface_integrators.front();
+	else if(std::find(surface_integrators.begin(), surface_integrators.end(), parsed_film->surface_integrator_) != surface_integrators.end()) return parsed_film->surface_integrator_;
+	else return nullptr;
+}
+
+bool isRenderCancelled(const RenderJobSettings &render_job_settings)
+{
+	return render_job_settings.render_cancelled_ && *render_job_settings.render_cancelled_;
+}
+
+} //namespace
+
+yafaray_Container *parseXmlFile_global(yafaray_Logger *yafaray_logger, const std::string &xml_file_path, const RenderJobSettings &render_job_settings, yafaray_xml_ParseControl *parse_control, PhaseReport *phase_report)
+{
+	ParseProgress parse_progress;
+	parse_progress.yafaray_logger_ = yafaray_logger;
+	yafaray_xml_ParseOptions *parse_options = createParseOptions(render_job_settings, parse_progress, parse_control);
+	if(phase_report) phase_report->startPhase("parse");
+	yafaray_Container *container = yafaray_xml_ParseFileWithOptions(yafaray_logger, xml_file_path.c_str(), render_job_settings.input_color_space_.c_str(), render_job_settings.input_gamma_, parse_options);
+	if(phase_report) phase_report->endPhase(container != nullptr);
+	yafaray_xml_destroyParseOptions(parse_options);
+	return container;
+}
+
+yafaray_Container *parseXmlFiles_global(yafaray_Logger *yafaray_logger, const std::vector<std::string> &xml_file_paths, const RenderJobSettings &render_job_settings, yafaray_xml_ParseControl *parse_control, PhaseReport *phase_report)
+{
+	ParseProgress parse_progress;
+	parse_progress.yafaray_logger_ = yafaray_logger;
+	yafaray_xml_ParseOptions *parse_options = createParseOptions(render_job_settings, parse_progress, parse_control);
+	std::vector<const char *> xml_file_path_pointers;
+	for(const auto &xml_file_path : xml_file_paths) xml_file_path_pointers.push_back(xml_file_path.c_str());
+	if(phase_report) phase_report->startPhase("parse");
+	yafaray_Container *container = yafaray_xml_ParseFiles(yafaray_logger, xml_file_path_pointers.data(), xml_file_path_pointers.size(), render_job_settings.input_color_space_.c_str(), render_job_settings.input_gamma_, parse_options);
+	if(phase_report) phase_report->endPhase(container != nullptr);
+	yafaray_xml_destroyParseOptions(parse_options);
+	return container;
+}
+
+yafaray_Container *parseXmlMemory_global(yafaray_Logger *yafaray_logger, const std::string &xml_buffer, const RenderJobSettings &render_job_settings, yafaray_xml_ParseControl *parse_control, PhaseReport *phase_report)
+{
+	ParseProgress parse_progress;
+	parse_progress.yafaray_logger_ = yafaray_logger;
+	yafaray_xml_ParseOptions *parse_options = createParseOptions(render_job_settings, parse_progress, parse_control);
+	if(phase_report) phase_report->startPhase("parse");
+	yafaray_Container *container = yafaray_xml_ParseMemoryWithOptions(yafaray_logger, xml_buffer.c_str(), xml_buffer.size(), render_job_settings.input_color_space_.c_str(), render_job_settings.input_gamma_, parse_options);
+	if(phase_report) phase_report->endPhase(container != nullptr);
+	yafaray_xml_destroyParseOptions(parse_options);
+	return container;
+}
+
+bool renderContainer_global(yafaray_Logger *yafaray_logger, yafaray_Container *container, yafaray_RenderControl *render_control, const RenderJobSettings &render_job_settings, PhaseReport *phase_report)
+{
+	if(render_job_settings.parse_only_) return true;
+	yafaray_Scene *yafaray_scene{nullptr};
+	if(!render_job_settings.scene_name_.empty())
+	{
+		yafaray_scene = yafaray_getSceneFromContainerByName(container, render_job_settings.scene_name_.c_str());
+		if(!yafaray_scene) yafaray_printWarning(yafaray_logger, ("Scene name '" + render_job_settings.scene_name_ + "' not found in XML file, using the first scene in the file").c_str());
+	}
+	if(!yafaray_scene) yafaray_scene = yafaray_getSceneFromContainerByIndex(container, 0);
+
+	const std::vector<yafaray_SurfaceIntegrator *> yafaray_surface_integrators{selectContainerItems(yafaray_logger, container, render_job_settings.integrator_name_, render_job_settings.render_all_, yafaray_getSurfaceIntegratorFromContainerByName, yafaray_getSurfaceIntegratorFromContainerByIndex, "Surface Integrator", "surface integrator")};
+	std::vector<yafaray_Film *> yafaray_films{selectContainerItems(yafaray_logger, container, render_job_settings.film_name_, render_job_settings.render_all_, yafaray_getFilmFromContainerByName, yafaray_getFilmFromContainerByIndex, "Film", "film")};
+	//The preview films of the progressive loading are only rendered in place of their films, for the previews
+	yafaray_films.erase(std::remove_if(yafaray_films.begin(), yafaray_films.end(), [&render_job_settings](yafaray_Film *film) { return isPreviewFilm(film, render_job_settings); }), yafaray_films.end());
+
+	if(!yafaray_scene || yafaray_surface_integrators.empty() || yafaray_films.empty())
+	{
+		yafaray_printError(yafaray_logger, "Nothing to render, the XML file must have at least one scene, one surface integrator and one film");
+		return false;
+	}
+
+	yafaray_setRenderControlForNormalStart(render_control);
+	yafaray_SceneModifiedFlags yafaray_scene_modified_flags{YAFARAY_SCENE_MODIFIED_NOTHING};
+	yafaray_scene_modified_flags = yafaray_checkAndClearSceneModifiedFlags(yafaray_scene);
+	if(phase_report) phase_report->startPhase("preprocess_scene");
+	const yafaray_Bool scene_preprocessed = yafaray_preprocessScene(yafaray_scene, render_control, yafaray_scene_modified_flags);
+	if(phase_report) phase_report->endPhase(scene_preprocessed == YAFARAY_BOOL_TRUE);
+	//Each film is bound to the surface integrator it was created with, so it is rendered only with that one, which writes its outputs. With a single film and surface integrator selected, the film is rendered with it as selected
+	std::vector<yafaray_SurfaceIntegrator *> film_surface_integrators(yafaray_films.size(), yafaray_surface_integrators.front());
+	if(yafaray_surface_integrators.size() > 1 || yafaray_films.size() > 1)
+	{
+		for(size_t film_index = 0; film_index < yafaray_films.size(); ++film_index)
+		{
+			film_surface_integrators[film_index] = filmSurfaceIntegrator(yafaray_films[film_index], yafaray_surface_integrators, render_job_settings);
+			if(!film_surface_integrators[film_index]) yafaray_printWarning(yafaray_logger, ("Film " + std::to_string(film_index + 1) + "/" + std::to_string(yafaray_films.size()) + " was created with a surface integrator not selected, skipping it").c_str());
+		}
+	}
+	yafaray_RenderMonitor *yafaray_render_monitor = yafaray_createRenderMonitor(nullptr, nullptr, YAFARAY_DISPLAY_CONSOLE_NORMAL);
+	//The scene is preprocessed only once, and each surface integrator only once for all the films rendered with it
+	for(size_t integrator_index = 0; integrator_index < yafaray_surface_integrators.size() && !isRenderCancelled(render_job_settings); ++integrator_index)
+	{
+		yafaray_SurfaceIntegrator *yafaray_surface_integrator = yafaray_surface_integrators[integrator_index];
+		if(std::find(film_surface_integrators.begin(), film_surface_integrators.end(), yafaray_surface_integrator) == film_surface_integrators.end()) continue;
+		if(phase_report) phase_report->startPhase("preprocess_surface_integrator");
+		const yafaray_Bool surface_integrator_preprocessed = yafaray_preprocessSurfaceIntegrator(yafaray_render_monitor, yafaray_surface_integrator, render_control, yafaray_scene);
+		if(phase_report) phase_report->endPhase(surface_integrator_preprocessed == YAFARAY_BOOL_TRUE);
+		if(render_job_settings.preprocess_only_) continue;
+		for(size_t film_index = 0; film_index < yafaray_films.size() && !isRenderCancelled(render_job_settings); ++film_index)
+		{
+			if(film_surface_integrators[film_index] != yafaray_surface_integrator) continue;
+			yafaray_Film *yafaray_film = yafaray_films[film_index];
+			if(render_job_settings.preview_)
+			{
+				const ParsedFilm *parsed_film = findParsedFilm(yafaray_film, render_job_settings);
+				yafaray_film = parsed_film ? parsed_film->preview_film_ : nullptr;
+				if(!yafaray_film) continue;
+			}
+			if(yafaray_films.size() > 1) yafaray_printInfo(yafaray_logger, ("Rendering film " + std::to_string(film_index + 1) + "/" + std::to_string(yafaray_films.size()) + " with surface integrator " + std::to_string(integrator_index + 1) + "/" + std::to_string(yafaray_surface_integrators.size())).c_str());
+			if(phase_report) phase_report->startPhase("render");
+			yafaray_render(render_control, yafaray_render_monitor, yafaray_surface_integrator, yafaray_film);
+			if(phase_report) phase_report->endPhase(true);
+		}
+	}
+	yafaray_destroyRenderMonitor(yafaray_render_monitor);
+	return true;
+}
@@ -0,0 +1,78 @@
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_XML_LOADER_RENDER_JOB_H
+#define LIBYAFARAY_XML_LOADER_RENDER_JOB_H
+
+#include "yafaray_xml_c_api.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+class PhaseReport;
+
+//! Film created while parsing, with the surface integrator it was created with and its preview film when loading progressively
+struct ParsedFilm
+{
+	yafaray_Film *film_ = nullptr;
+	yafaray_SurfaceIntegrator *surface_integrator_ = nullptr;
+	yafaray_Film *preview_film_ = nullptr;
+};
+
+//! Settings used to parse and render a XML scene, either from the command line or from a render server request
+struct RenderJobSettings
+{
+	std::string input_color_space_ = "LinearRGB";
+	float input_gamma_ = 1.f;
+	std::string scene_name_;
+	std::string integrator_name_; //!< Comma separated list of names
+	std::string film_name_; //!< Comma separated list of names
+	bool concurrent_scenes_ = false;
+	bool prefetch_image_files_ = false;
+	bool deduplicate_geometry_ = false;
+	bool deduplicate_resources_ = false;
+	bool builtin_tokenizer_ = false;
+	bool arena_allocation_ = false;
+	std::string trace_file_path_; //!< If not empty, the parsing trace is written to this file
+	std::string report_file_path_; //!< If not empty, the time and resources used by each phase of the job are written to this file
+	bool parse_only_ = false; //!< Stops the job after parsing
+	bool preprocess_only_ = false; //!< Stops the job after preprocessing the scene and surface integrator, without rendering
+	std::vector<std::string> param_overrides_; //!< Parameter values replacing those in the XML file, as "path=value"
+	size_t film_region_index_ = 0; //!< Horizontal strip of the films rendered when film_regions_ is greater than 1
+	size_t film_regions_ = 1;
+	std::string film_region_manifest_path_;
+	bool render_all_ = false; //!< Renders every film in the container with the surface integrator it was created with, unless they are selected by name
+	size_t progressive_load_objects_per_step_ = 0; //!< When this or the step time are not 0, the scene geometry is built last, in steps, rendering a quick preview in the preview film after each one
+	int progressive_load_step_time_ms_ = 0;
+	yafaray_RenderControl *preview_render_control_ = nullptr; //!< Not owned, to render the previews of the progressive loading, which are not rendered if null
+	yafaray_xml_IncludeCache *include_cache_ = nullptr; //!< Not owned, to keep the included files parsed between jobs
+	std::vector<ParsedFilm> *parsed_films_ = nullptr; //!< Not owned. Filled while parsing with the surface integrator each film was created with, so each film is rendered with its own one, and its preview film
+	bool preview_ = false; //!< Renders the preview films of the selected films instead of them, so their outputs are not written
+	const std::atomic<bool> *render_cancelled_ = nullptr; //!< Not owned. When set, no more films are rendered once it is true
+};
+
+//! Parses a XML file using the job settings, printing the parsing progress. The parse control, if not null, allows cancelling it. Returns nullptr if the file could not be parsed or the parsing was cancelled. The phase report, if not null, gets the parsing phase
+yafaray_Container *parseXmlFile_global(yafaray_Logger *yafaray_logger, const std::string &xml_file_path, const RenderJobSettings &render_job_settings, yafaray_xml_ParseControl *parse_control, PhaseReport *phase_report);
+//! Parses several XML files into one container using the job settings, as parseXmlFile_global does with a single file
+yafaray_Container *parseXmlFiles_global(yafaray_Logger *yafaray_logger, const std::vector<std::string> &xml_file_paths, const RenderJobSettings &render_job_settings, yafaray_xml_ParseControl *parse_control, PhaseReport *phase_report);
+//! Parses a XML memory buffer using the job settings, printing the parsing progress. The parse control, if not null, allows cancelling it. Returns nullptr if the buffer could not be parsed or the parsing was cancelled. The phase report, if not null, gets the parsing phase
+yafaray_Container *parseXmlMemory_global(yafaray_Logger *yafaray_logger, const std::string &xml_buffer, const RenderJobSettings &render_job_settings, yafaray_xml_ParseControl *parse_control, PhaseReport *phase_report);
+//! Preprocesses and renders the scene, surface integrator and film selected by the job settings from the container, unless the job settings stop it earlier. Returns false if the container does not have anything to render. The phase report, if not null, gets the preprocessing and rendering phases
+bool renderContainer_global(yafaray_Logger *yafaray_logger, yafaray_Container *container, yafaray_RenderControl *render_control, const RenderJobSettings &render_job_settings, PhaseReport *phase_report);
+
+#endif //LIBYAFARAY_XML_LOADER_RENDER_JOB_H
@@ -0,0 +1,453 @@
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "render_server.h"
+#include "phase_report.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+RenderServer::RenderServer(yafaray_Logger *yafaray_logger, const std::string &socket_path, const RenderJobSettings &default_render_job_settings, size_t max_xml_buffer_size) : yafaray_logger_(yafaray_logger), socket_path_(socket_path), max_xml_buffer_size_(max_xml_buffer_size), default_render_job_settings_(default_render_job_settings), include_cache_(yafaray_xml_createIncludeCache())
+{
+	default_render_job_settings_.include_cache_ = include_cache_;
+}
+
+RenderServer::~RenderServer()
+{
+	cancelAllJobs();
+	if(jobs_thread_.joinable()) jobs_thread_.join();
+	{
+		std::lock_guard<std::mutex> lock(clients_mutex_);
+		for(const auto &client : clients_) shutdown(client->socket_, SHUT_RDWR); //To unblock the clients waiting for requests
+	}
+	for(const auto &client : clients_)
+	{
+		if(client->thread_.joinable()) client->thread_.join();
+	}
+	if(listen_socket_ >= 0)
+	{
+		close(listen_socket_);
+		unlink(socket_path_.c_str());
+	}
+	yafaray_xml_destroyIncludeCache(include_cache_);
+}
+
+bool RenderServer::run()
+{
+	if(!createSocket()) return false;
+	signal(SIGPIPE, SIG_IGN); //Clients closing the connection early must not terminate the server
+	jobs_thread_ = std::thread(&RenderServer::processJobs, this);
+	yafaray_printInfo(yafaray_logger_, ("Render server: listening on socket '" + socket_path_ + "'").c_str());
+	acceptClients();
+	yafaray_printInfo(yafaray_logger_, "Render server: stopping");
+	return true;
+}
+
+bool RenderServer::createSocket()
+{
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	if(socket_path_.size() >= sizeof(address.sun_path))
+	{
+		yafaray_printError(yafaray_logger_, ("Render server: socket path '" + socket_path_ + "' is too long").c_str());
+		return false;
+	}
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, socket_path_.c_str(), sizeof(address.sun_path) - 1);
+	if(!removeStaleSocket())
+	{
+		yafaray_printError(yafaray_logger_, ("Render server: socket '" + socket_path_ + "' is in use by another server").c_str());
+		return false;
+	}
+	listen_socket_ = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(listen_socket_ < 0 || bind(listen_socket_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || listen(listen_socket_, 16) != 0)
+	{
+		yafaray_printError(yafaray_logger_, ("Render server: could not listen on socket '" + socket_path_ + "': " + std::strerror(errno)).c_str());
+		if(listen_socket_ >= 0) close(listen_socket_);
+		listen_socket_ = -1;
+		return false;
+	}
+	return true;
+}
+
+bool RenderServer::removeStaleSocket() const
+{
+	//A socket file left behind by a server that did not stop cleanly makes bind fail, but it must be kept if a server is still accepting connections on it
+	struct stat socket_stat;
+	if(lstat(socket_path_.c_str(), &socket_stat) != 0 || !S_ISSOCK(socket_stat.st_mode)) return true;
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, socket_path_.c_str(), sizeof(address.sun_path) - 1);
+	const int probe_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(probe_socket < 0) return false;
+	const bool server_running = (connect(probe_socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0);
+	close(probe_socket);
+	if(server_running) return false;
+	yafaray_printWarning(yafaray_logger_, ("Render server: removing stale socket '" + socket_path_ + "'").c_str());
+	return unlink(socket_path_.c_str()) == 0;
+}
+
+void RenderServer::acceptClients()
+{
+	pollfd listen_poll;
+	listen_poll.fd = listen_socket_;
+	listen_poll.events = POLLIN;
+	while(!stop_requested_)
+	{
+		//Polling with a timeout to notice stop requests coming from signal handlers or SHUTDOWN requests
+		listen_poll.revents = 0;
+		if(poll(&listen_poll, 1, 200) <= 0 || !(listen_poll.revents & POLLIN)) continue;
+		const int client_socket = accept(listen_socket_, nullptr, nullptr);
+		if(client_socket < 0) continue;
+		joinFinishedClients();
+		std::lock_guard<std::mutex> lock(clients_mutex_);
+		std::unique_ptr<Client> client(new Client);
+		client->socket_ = client_socket;
+		client->thread_ = std::thread(&RenderServer::serveClient, this, std::ref(*client));
+		clients_.push_back(std::move(client));
+	}
+}
+
+void RenderServer::joinFinishedClients()
+{
+	std::lock_guard<std::mutex> lock(clients_mutex_);
+	for(auto client = clients_.begin(); client != clients_.end();)
+	{
+		if((*client)->finished_)
+		{
+			(*client)->thread_.join();
+			client = clients_.erase(client);
+		}
+		else ++client;
+	}
+}
+
+void RenderServer::serveClient(Client &client)
+{
+	RenderJobSettings render_job_settings = default_render_job_settings_;
+	std::string pending_input;
+	std::string request;
+	while(!stop_requested_ && readLine(client.socket_, pending_input, request))
+	{
+		if(request.empty()) continue;
+		const std::string reply = processRequest(client, request, render_job_settings, pending_input);
+		if(!writeLine(client.socket_, reply)) break;
+	}
+	close(client.socket_);
+	client.finished_ = true;
+}
+
+std::string RenderServer::processRequest(Client &client, const std::string &request, RenderJobSettings &render_job_settings, std::string &pending_input)
+{
+	const size_t command_end = request.find(' ');
+	const std::string command = request.substr(0, command_end);
+	const std::string argument = command_end == std::string::npos ? "" : request.substr(command_end + 1);
+	const unsigned long long job_id = std::strtoull(argument.c_str(), nullptr, 10);
+	if(command == "SET")
+	{
+		const size_t option_end = argument.find(' ');
+		if(option_end == std::string::npos || !setJobSetting(render_job_settings, argument.substr(0, option_end), argument.substr(option_end + 1))) return "ERROR invalid setting '" + argument + "'";
+		else return "OK";
+	}
+	else if(command == "RENDER_FILE")
+	{
+		if(argument.empty()) return "ERROR missing XML file path";
+		std::unique_ptr<Job> job(new Job);
+		job->xml_file_path_ = argument;
+		job->render_job_settings_ = render_job_settings;
+		return queueJob(std::move(job));
+	}
+	else if(command == "RENDER_MEMORY")
+	{
+		char *size_end = nullptr;
+		const unsigned long long size = std::strtoull(argument.c_str(), &size_end, 10);
+		if(argument.empty() || *size_end != '\0' || size == 0) return "ERROR invalid XML buffer size '" + argument + "'";
+		if(size > max_xml_buffer_size_)
+		{
+			if(!skipBytes(client.socket_, pending_input, static_cast<size_t>(size))) return "ERROR incomplete XML buffer";
+			return "ERROR XML buffer size " + argument + " exceeds the maximum of " + std::to_string(max_xml_buffer_size_) + " bytes";
+		}
+		std::unique_ptr<Job> job(new Job);
+		bool allocated = true;
+		try
+		{
+			job->xml_buffer_.reserve(static_cast<size_t>(size));
+		}
+		catch(const std::bad_alloc &) { allocated = false; }
+		catch(const std::length_error &) { allocated = false; }
+		if(!allocated)
+		{
+			if(!skipBytes(client.socket_, pending_input, static_cast<size_t>(size))) return "ERROR incomplete XML buffer";
+			return "ERROR not enough memory for an XML buffer of " + argument + " bytes";
+		}
+		if(!readBytes(client.socket_, pending_input, static_cast<size_t>(size), job->xml_buffer_)) return "ERROR incomplete XML buffer";
+		job->from_memory_ = true;
+		job->render_job_settings_ = render_job_settings;
+		return queueJob(std::move(job));
+	}
+	else if(command == "STATUS") return jobStatusReply(job_id);
+	else if(command == "WAIT") return waitJob(job_id);
+	else if(command == "CANCEL") return cancelJob(job_id);
+	else if(command == "SHUTDOWN")
+	{
+		requestStop();
+		return "OK";
+	}
+	else return "ERROR unknown request '" + command + "'";
+}
+
+bool RenderServer::setJobSetting(RenderJobSettings &render_job_settings, const std::string &option, const std::string &value)
+{
+	if(option == "scene-name") render_job_settings.scene_name_ = value;
+	else if(option == "integrator-name") render_job_settings.integrator_name_ = value;
+	else if(option == "film-name") render_job_settings.film_name_ = value;
+	else if(option == "input-color-space") render_job_settings.input_color_space_ = value;
+	else if(option == "input-gamma")
+	{
+		char *value_end = nullptr;
+		const float input_gamma = std::strtof(value.c_str(), &value_end);
+		if(value.empty() || *value_end != '\0') return false;
+		render_job_settings.input_gamma_ = input_gamma;
+	}
+	else if(option == "concurrent-scenes") render_job_settings.concurrent_scenes_ = (value == "1" || value == "true");
+	else if(option == "prefetch-images") render_job_settings.prefetch_image_files_ = (value == "1" || value == "true");
+	else if(option == "deduplicate-geometry") render_job_settings.deduplicate_geometry_ = (value == "1" || value == "true");
+	else if(option == "deduplicate-resources") render_job_settings.deduplicate_resources_ = (value == "1" || value == "true");
+	else if(option == "builtin-tokenizer") render_job_settings.builtin_tokenizer_ = (value == "1" || value == "true");
+	else if(option == "arena-allocation") render_job_settings.arena_allocation_ = (value == "1" || value == "true");
+	else if(option == "trace-file") render_job_settings.trace_file_path_ = value;
+	else if(option == "report") render_job_settings.report_file_path_ = value;
+	else if(option == "parse-only") render_job_settings.parse_only_ = (value == "1" || value == "true");
+	else if(option == "preprocess-only") render_job_settings.preprocess_only_ = (value == "1" || value == "true");
+	else if(option == "param-override")
+	{
+		if(value == "clear") render_job_settings.param_overrides_.clear();
+		else render_job_settings.param_overrides_.push_back(value);
+	}
+	else if(option == "render-all") render_job_settings.render_all_ = (value == "1" || value == "true");
+	else return false;
+	return true;
+}
+
+std::string RenderServer::queueJob(std::unique_ptr<Job> job)
+{
+	std::lock_guard<std::mutex> lock(jobs_mutex_);
+	if(stopping_) return "ERROR server is stopping";
+	job->id_ = ++last_job_id_;
+	const unsigned long long job_id = job->id_;
+	queued_jobs_.push_back(job.get());
+	jobs_[job_id] = std::move(job);
+	jobs_condition_.notify_all();
+	return "OK " + std::to_string(job_id);
+}
+
+std::string RenderServer::jobStatusReply(unsigned long long job_id)
+{
+	std::lock_guard<std::mutex> lock(jobs_mutex_);
+	const auto job = jobs_.find(job_id);
+	if(job == jobs_.end()) return "ERROR unknown job " + std::to_string(job_id);
+	else return "OK " + std::to_string(job_id) + " " + jobStatusName(job->second->status_);
+}
+
+std::string RenderServer::waitJob(unsigned long long job_id)
+{
+	std::unique_lock<std::mutex> lock(jobs_mutex_);
+	auto job = jobs_.find(job_id);
+	while(job != jobs_.end() && !isFinished(job->second->status_))
+	{
+		jobs_condition_.wait(lock);
+		job = jobs_.find(job_id);
+	}
+	if(job == jobs_.end()) return "ERROR unknown job " + std::to_string(job_id);
+	else return "OK " + std::to_string(job_id) + " " + jobStatusName(job->second->status_);
+}
+
+std::string RenderServer::cancelJob(unsigned long long job_id)
+{
+	std::lock_guard<std::mutex> lock(jobs_mutex_);
+	const auto job = jobs_.find(job_id);
+	if(job == jobs_.end()) return "ERROR unknown job " + std::to_string(job_id);
+	else if(isFinished(job->second->status_)) return "ERROR job " + std::to_string(job_id) + " already finished";
+	job->second->cancel_requested_ = true;
+	yafaray_xml_cancelParsing(job->second->parse_control_);
+	if(job->second->render_control_) yafaray_cancelRendering(job->second->render_control_);
+	return "OK " + std::to_string(job_id);
+}
+
+void RenderServer::cancelAllJobs()
+{
+	std::lock_guard<std::mutex> lock(jobs_mutex_);
+	stopping_ = true;
+	for(const auto &job : jobs_)
+	{
+		if(isFinished(job.second->status_)) continue;
+		job.second->cancel_requested_ = true;
+		yafaray_xml_cancelParsing(job.second->parse_control_);
+		if(job.second->render_control_) yafaray_cancelRendering(job.second->render_control_);
+	}
+	jobs_condition_.notify_all();
+}
+
+void RenderServer::processJobs()
+{
+	std::unique_lock<std::mutex> lock(jobs_mutex_);
+	while(true)
+	{
+		while(!stopping_ && queued_jobs_.empty()) jobs_condition_.wait(lock);
+		if(queued_jobs_.empty()) break;
+		Job &job = *queued_jobs_.front();
+		queued_jobs_.pop_front();
+		if(!job.cancel_requested_)
+		{
+			job.status_ = JobStatus::Running;
+			lock.unlock();
+			runJob(job);
+			lock.lock();
+		}
+		else job.status_ = JobStatus::Cancelled;
+		finished_job_ids_.push_back(job.id_);
+		removeOldFinishedJobs();
+		jobs_condition_.notify_all();
+	}
+}
+
+void RenderServer::runJob(Job &job)
+{
+	yafaray_printInfo(yafaray_logger_, ("Render server: starting job " + std::to_string(job.id_) + (job.from_memory_ ? " from a memory buffer" : " from file '" + job.xml_file_path_ + "'")).c_str());
+	PhaseReport phase_report;
+	job.render_job_settings_.parsed_films_ = &job.parsed_films_;
+	job.render_job_settings_.render_cancelled_ = &job.cancel_requested_;
+	yafaray_Container *container = job.from_memory_ ? parseXmlMemory_global(yafaray_logger_, job.xml_buffer_, job.render_job_settings_, job.parse_control_, &phase_report) : parseXmlFile_global(yafaray_logger_, job.xml_file_path_, job.render_job_settings_, job.parse_control_, &phase_report);
+	job.xml_buffer_.clear();
+	job.xml_buffer_.shrink_to_fit();
+	yafaray_RenderControl *render_control = yafaray_createRenderControl();
+	bool cancelled;
+	{
+		std::lock_guard<std::mutex> lock(jobs_mutex_);
+		cancelled = job.cancel_requested_;
+		if(!cancelled) job.render_control_ = render_control;
+	}
+	bool rendered = false;
+	if(container && !cancelled) rendered = renderContainer_global(yafaray_logger_, container, render_control, job.render_job_settings_, &phase_report);
+	if(!job.render_job_settings_.report_file_path_.empty() && !phase_report.writeFile(job.render_job_settings_.report_file_path_, job.from_memory_ ? std::string{} : job.xml_file_path_)) yafaray_printError(yafaray_logger_, ("Render server: cannot write the report file '" + job.render_job_settings_.report_file_path_ + "'").c_str());
+	{
+		std::lock_guard<std::mutex> lock(jobs_mutex_);
+		job.render_control_ = nullptr;
+		if(job.cancel_requested_) job.status_ = JobStatus::Cancelled;
+		else job.status_ = rendered ? JobStatus::Done : JobStatus::Failed;
+	}
+	yafaray_destroyRenderControl(render_control);
+	if(container) yafaray_destroyContainerAndContainedPointers(container);
+	yafaray_printInfo(yafaray_logger_, ("Render server: job " + std::to_string(job.id_) + " " + jobStatusName(job.status_)).c_str());
+}
+
+void RenderServer::removeOldFinishedJobs()
+{
+	while(finished_job_ids_.size() > max_finished_jobs_kept_)
+	{
+		jobs_.erase(finished_job_ids_.front());
+		finished_job_ids_.pop_front();
+	}
+}
+
+bool RenderServer::readLine(int socket, std::string &pending_input, std::string &line)
+{
+	size_t line_end;
+	while((line_end = pending_input.find('\n')) == std::string::npos)
+	{
+		char buffer[4096];
+		const ssize_t bytes_read = recv(socket, buffer, sizeof(buffer), 0);
+		if(bytes_read < 0 && errno == EINTR) continue;
+		else if(bytes_read <= 0) return false;
+		pending_input.append(buffer, static_cast<size_t>(bytes_read));
+	}
+	line = pending_input.substr(0, line_end);
+	if(!line.empty() && line.back() == '\r') line.pop_back();
+	pending_input.erase(0, line_end + 1);
+	return true;
+}
+
+bool RenderServer::readBytes(int socket, std::string &pending_input, size_t size, std::string &bytes)
+{
+	const size_t bytes_pending = std::min(size, pending_input.size());
+	bytes.assign(pending_input, 0, bytes_pending);
+	pending_input.erase(0, bytes_pending);
+	bytes.resize(size);
+	size_t bytes_total = bytes_pending;
+	while(bytes_total < size)
+	{
+		const ssize_t bytes_read = recv(socket, &bytes[bytes_total], size - bytes_total, 0);
+		if(bytes_read < 0 && errno == EINTR) continue;
+		else if(bytes_read <= 0) return false;
+		bytes_total += static_cast<size_t>(bytes_read);
+	}
+	return true;
+}
+
+bool RenderServer::skipBytes(int socket, std::string &pending_input, size_t size)
+{
+	const size_t bytes_pending = std::min(size, pending_input.size());
+	pending_input.erase(0, bytes_pending);
+	size_t bytes_total = bytes_pending;
+	while(bytes_total < size)
+	{
+		char buffer[4096];
+		const ssize_t bytes_read = recv(socket, buffer, std::min(sizeof(buffer), size - bytes_total), 0);
+		if(bytes_read < 0 && errno == EINTR) continue;
+		else if(bytes_read <= 0) return false;
+		bytes_total += static_cast<size_t>(bytes_read);
+	}
+	return true;
+}
+
+bool RenderServer::writeLine(int socket, const std::string &line)
+{
+	const std::string output = line + "\n";
+	size_t bytes_total = 0;
+	while(bytes_total < output.size())
+	{
+		const ssize_t bytes_written = send(socket, output.data() + bytes_total, output.size() - bytes_total, 0);
+		if(bytes_written < 0 && errno == EINTR) continue;
+		else if(bytes_written <= 0) return false;
+		bytes_total += static_cast<size_t>(bytes_written);
+	}
+	return true;
+}
+
+const char *RenderServer::jobStatusName(JobStatus job_status)
+{
+	switch(job_status)
+	{
+		case JobStatus::Queued: return "queued";
+		case JobStatus::Running: return "running";
+		case JobStatus::Done: return "done";
+		case JobStatus::Failed: return "failed";
+		case JobStatus::Cancelled:
+		default: return "cancelled";
+	}
+}
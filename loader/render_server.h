@@ -0,0 +1,121 @@
+/****************************************************************************
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_XML_LOADER_RENDER_SERVER_H
+#define LIBYAFARAY_XML_LOADER_RENDER_SERVER_H
+
+#include "render_job.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+//! Persistent render server listening on a Unix domain socket, to avoid paying the process and libYafaRay startup costs for every render job
+/*! Jobs are rendered one at a time, in the order they were received. Each client connection sends text requests, one per line:
+ *   SET <option> <value>     Sets a job setting for the next jobs sent in this connection. Options: scene-name, integrator-name, film-name, input-color-space, input-gamma, concurrent-scenes, prefetch-images, deduplicate-geometry, deduplicate-resources, builtin-tokenizer, arena-allocation, trace-file, report, parse-only, preprocess-only, render-all
+ *                            "param-override" adds an override as path=value to the previous ones, or removes them all with the value "clear"
+ *   RENDER_FILE <path>       Queues the render of a XML file. Relative paths are relative to the server working directory
+ *   RENDER_MEMORY <size>     Queues the render of the XML document sent in the <size> bytes following the request line. Documents larger than the maximum given to the server are discarded
+ *   STATUS <job id>          Returns the job status: queued, running, done, failed or cancelled
+ *   WAIT <job id>            Waits until the job finishes and returns its status
+ *   CANCEL <job id>          Cancels a queued job, or the parsing or rendering of a running job
+ *   SHUTDOWN                 Cancels all jobs and stops the server
+ * Each request gets a single line reply starting with either "OK" or "ERROR".
+ * The files included by the scenes with <include> are kept parsed between jobs, and parsed again only when they change */
+class RenderServer final
+{
+	public:
+		RenderServer(yafaray_Logger *yafaray_logger, const std::string &socket_path, const RenderJobSettings &default_render_job_settings, size_t max_xml_buffer_size);
+		~RenderServer();
+		//! Runs the server until stopped, returns false if the socket could not be created
+		bool run();
+		//! Requests the server to stop. It only sets a flag, so it can be called from signal handlers
+		void requestStop() { stop_requested_ = true; }
+
+	private:
+		enum class JobStatus : int { Queued, Running, Done, Failed, Cancelled };
+		struct Job
+		{
+			Job() : parse_control_(yafaray_xml_createParseControl()) { }
+			Job(const Job &) = delete;
+			~Job() { yafaray_xml_destroyParseControl(parse_control_); }
+			unsigned long long id_ = 0;
+			std::string xml_file_path_;
+			std::string xml_buffer_;
+			bool from_memory_ = false;
+			RenderJobSettings render_job_settings_;
+			JobStatus status_ = JobStatus::Queued;
+			std::atomic<bool> cancel_requested_{false}; //!< Also read by the render loop, to stop rendering the remaining films
+			std::vector<ParsedFilm> parsed_films_;
+			yafaray_xml_ParseControl *parse_control_ = nullptr;
+			yafaray_RenderControl *render_control_ = nullptr;
+		};
+		struct Client
+		{
+			int socket_ = -1;
+			std::thread thread_;
+			std::atomic<bool> finished_{false};
+		};
+		bool createSocket();
+		bool removeStaleSocket() const;
+		void acceptClients();
+		void serveClient(Client &client);
+		std::string processRequest(Client &client, const std::string &request, RenderJobSettings &render_job_settings, std::string &pending_input);
+		std::string queueJob(std::unique_ptr<Job> job);
+		std::string jobStatusReply(unsigned long long job_id);
+		std::string waitJob(unsigned long long job_id);
+		std::string cancelJob(unsigned long long job_id);
+		void cancelAllJobs();
+		void processJobs();
+		void runJob(Job &job);
+		void removeOldFinishedJobs();
+		void joinFinishedClients();
+		static bool readLine(int socket, std::string &pending_input, std::string &line);
+		static bool readBytes(int socket, std::string &pending_input, size_t size, std::string &bytes);
+		static bool skipBytes(int socket, std::string &pending_input, size_t size);
+		static bool writeLine(int socket, const std::string &line);
+		static bool setJobSetting(RenderJobSettings &render_job_settings, const std::string &option, const std::string &value);
+		static const char *jobStatusName(JobStatus job_status);
+		static bool isFinished(JobStatus job_status) { return job_status != JobStatus::Queued && job_status != JobStatus::Running; }
+
+		static constexpr size_t max_finished_jobs_kept_ = 1024;
+		yafaray_Logger *yafaray_logger_ = nullptr;
+		std::string socket_path_;
+		size_t max_xml_buffer_size_ = 0; //!< Largest document accepted by RENDER_MEMORY, in bytes
+		RenderJobSettings default_render_job_settings_;
+		yafaray_xml_IncludeCache *include_cache_ = nullptr; //!< Shared by all the jobs, so asset libraries included by many scenes are parsed only once
+		int listen_socket_ = -1;
+		std::atomic<bool> stop_requested_{false};
+		std::mutex jobs_mutex_;
+		std::condition_variable jobs_condition_;
+		std::map<unsigned long long, std::unique_ptr<Job>> jobs_;
+		std::deque<Job *> queued_jobs_;
+		std::deque<unsigned long long> finished_job_ids_;
+		unsigned long long last_job_id_ = 0;
+		bool stopping_ = false;
+		std::thread jobs_thread_;
+		std::mutex clients_mutex_;
+		std::list<std::unique_ptr<Client>> clients_;
+};
+
+#endif //LIBYAFARAY_XML_LOADER_RENDER_SERVER_H
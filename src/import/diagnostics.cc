@@ -0,0 +1,58 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/diagnostics.h"
+
+namespace yafaray_xml
+{
+
+bool Diagnostics::countWarning(Kind kind, const char *element)
+{
+	warning_key_.assign(1, static_cast<char>(kind));
+	warning_key_ += element;
+	const size_t count{++warning_counts_[warning_key_]};
+	return count <= max_printed_warnings_per_element_;
+}
+
+void Diagnostics::printWarning(Kind kind, const char *element, const char *detail, int line_number) const
+{
+	std::string message{"XMLParser: "};
+	switch(kind)
+	{
+		case Kind::UnrecognizedElement: message += "Skipping unrecognized element '" + std::string(element) + "' in '" + detail + "'"; break;
+		case Kind::WrongAttribute:
+		default: message += "Ignored wrong attribute '" + std::string(detail) + "' in " + element; break;
+	}
+	if(line_number > 0) message += " [line:" + std::to_string(line_number) + "]";
+	yafaray_printWarning(yafaray_logger_, message.c_str());
+}
+
+void Diagnostics::printSummary() const
+{
+	for(const auto &[warning_key, count] : warning_counts_)
+	{
+		if(count <= max_printed_warnings_per_element_) continue;
+		const std::string element{warning_key.substr(1)};
+		const std::string description{static_cast<Kind>(warning_key[0]) == Kind::UnrecognizedElement ? "unrecognized element '" + element + "'" : "wrong attributes in " + element};
+		yafaray_printWarning(yafaray_logger_, ("XMLParser: Found " + std::to_string(count) + " warnings about " + description + ", only the first " + std::to_string(max_printed_warnings_per_element_) + " were printed").c_str());
+	}
+}
+
+} //namespace yafaray_xml
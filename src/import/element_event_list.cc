@@ -0,0 +1,57 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/element_event_list.h"
+#include "import/import_xml.h"
+#include <cstring>
+
+namespace yafaray_xml
+{
+
+void ElementEventList::appendString(const char *string)
+{
+	strings_.insert(strings_.end(), string, string + std::strlen(string) + 1);
+}
+
+void ElementEventList::addStartElement(const char *element, const char **attrs)
+{
+	Event event{strings_.size(), 0, true};
+	appendString(element);
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		appendString(attrs[0]);
+		appendString(attrs[1] ? attrs[1] : "");
+		++event.number_of_attributes_;
+	}
+	events_.push_back(event);
+}
+
+void ElementEventList::addEndElement(const char *element)
+{
+	events_.push_back({strings_.size(), 0, false});
+	appendString(element);
+}
+
+void ElementEventList::replay(XmlParser &parser, size_t first_event, size_t end_event) const
+{
+	visit(first_event, end_event, [&parser](const char *element, const char **attrs) { parser.startElement(element, attrs); }, [&parser](const char *element) { parser.endElement(element); });
+}
+
+} //namespace yafaray_xml
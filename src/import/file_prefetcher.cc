@@ -0,0 +1,235 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/file_prefetcher.h"
+#include <algorithm>
+#include <cstdio>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace yafaray_xml
+{
+
+FilePrefetcher::FilePrefetcher(size_t number_of_threads)
+{
+	for(size_t thread_index = 0; thread_index < number_of_threads; ++thread_index) threads_.emplace_back(&FilePrefetcher::run, this);
+}
+
+FilePrefetcher::~FilePrefetcher()
+{
+	{
+		std::lock_guard<std::mutex> lock_guard(mutex_);
+		stop_ = true;
+		tasks_.clear();
+	}
+	condition_.notify_all();
+	for(auto &thread : threads_) thread.join();
+}
+
+void FilePrefetcher::addTask(std::function<void()> &&function, bool scan)
+{
+	{
+		std::lock_guard<std::mutex> lock_guard(mutex_);
+		if(stop_) return;
+		tasks_.push_back({std::move(function), scan});
+	}
+	condition_.notify_one();
+}
+
+void FilePrefetcher::cancelScans()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	tasks_.erase(std::remove_if(tasks_.begin(), tasks_.end(), [](const Task &task) { return task.scan_; }), tasks_.end());
+	scans_cancelled_ = true;
+	scans_finished_condition_.wait(lock, [this] { return running_scans_ == 0; });
+	scans_cancelled_ = false;
+}
+
+void FilePrefetcher::clearRequestedFiles()
+{
+	std::lock_guard<std::mutex> lock_guard(mutex_);
+	requested_files_.clear();
+}
+
+void FilePrefetcher::run()
+{
+	while(true)
+	{
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+			if(stop_) return;
+			task = std::move(tasks_.front());
+			tasks_.pop_front();
+			if(task.scan_) ++running_scans_;
+		}
+		task.function_();
+		if(task.scan_)
+		{
+			{
+				std::lock_guard<std::mutex> lock_guard(mutex_);
+				--running_scans_;
+			}
+			scans_finished_condition_.notify_all();
+		}
+	}
+}
+
+void FilePrefetcher::prefetchFile(const std::string &file_path)
+{
+	if(file_path.empty()) return;
+	{
+		std::lock_guard<std::mutex> lock_guard(mutex_);
+		if(!requested_files_.insert(file_path).second) return;
+	}
+	addTask([this, file_path] { readFile(file_path); }, false);
+}
+
+void FilePrefetcher::prefetchImageFilesInXmlFile(const std::string &xml_file_path)
+{
+	addTask([this, xml_file_path]
+	{
+		std::FILE *xml_file = std::fopen(xml_file_path.c_str(), "rb");
+		if(!xml_file) return;
+		ImageFileNameScanner image_file_name_scanner{*this};
+		std::vector<char> buffer(read_block_size_);
+		size_t bytes_read;
+		while(!isScanStopped() && (bytes_read = std::fread(buffer.data(), 1, buffer.size(), xml_file)) > 0)
+		{
+			image_file_name_scanner.scan(buffer.data(), bytes_read);
+		}
+		std::fclose(xml_file);
+	}, true);
+}
+
+void FilePrefetcher::prefetchImageFilesInXmlMemory(const char *xml_buffer, size_t xml_buffer_size)
+{
+	addTask([this, xml_buffer, xml_buffer_size]
+	{
+		ImageFileNameScanner image_file_name_scanner{*this};
+		for(size_t offset = 0; offset < xml_buffer_size && !isScanStopped(); offset += read_block_size_)
+		{
+			image_file_name_scanner.scan(xml_buffer + offset, std::min(read_block_size_, xml_buffer_size - offset));
+		}
+	}, true);
+}
+
+void FilePrefetcher::readFile(const std::string &file_path) const
+{
+	std::vector<char> buffer(read_block_size_);
+#if defined(__linux__)
+	const int file_descriptor = open(file_path.c_str(), O_RDONLY);
+	if(file_descriptor < 0) return;
+	posix_fadvise(file_descriptor, 0, 0, POSIX_FADV_WILLNEED);
+	while(!stop_ && read(file_descriptor, buffer.data(), buffer.size()) > 0) { }
+	close(file_descriptor);
+#else
+	std::FILE *file = std::fopen(file_path.c_str(), "rb");
+	if(!file) return;
+	while(!stop_ && std::fread(buffer.data(), 1, buffer.size(), file) > 0) { }
+	std::fclose(file);
+#endif
+}
+
+std::string FilePrefetcher::decodeXmlEntities(const std::string &text)
+{
+	if(text.find('&') == std::string::npos) return text;
+	static constexpr std::pair<const char *, char> entities[] {{"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}};
+	std::string result;
+	for(size_t position = 0; position < text.size(); ++position)
+	{
+		bool entity_found = false;
+		for(const auto &[entity, character] : entities)
+		{
+			if(text.compare(position, std::char_traits<char>::length(entity), entity) == 0)
+			{
+				result += character;
+				position += std::char_traits<char>::length(entity) - 1;
+				entity_found = true;
+				break;
+			}
+		}
+		if(!entity_found) result += text[position];
+	}
+	return result;
+}
+
+bool FilePrefetcher::ImageFileNameScanner::matchPattern(char character, const char *pattern, size_t &pattern_position)
+{
+	if(character == pattern[pattern_position])
+	{
+		++pattern_position;
+		if(pattern[pattern_position] != '\0') return false;
+		pattern_position = 0;
+		return true;
+	}
+	pattern_position = (character == pattern[0]) ? 1 : 0;
+	return false;
+}
+
+void FilePrefetcher::ImageFileNameScanner::scan(const char *data, size_t size)
+{
+	static constexpr size_t max_file_name_size = 4096;
+	for(const char *character = data; character < data + size; ++character)
+	{
+		switch(state_)
+		{
+			case State::OutsideImage:
+				if(matchPattern(*character, "<image", pattern_position_)) state_ = State::ImageTagName;
+				break;
+			case State::ImageTagName: //To discard elements such as <image_name>
+				state_ = (*character == ' ' || *character == '\t' || *character == '\r' || *character == '\n' || *character == '>') ? State::InsideImage : State::OutsideImage;
+				pattern_position_ = 0;
+				closing_pattern_position_ = 0;
+				break;
+			case State::InsideImage:
+				if(matchPattern(*character, "</image", closing_pattern_position_)) state_ = State::OutsideImage;
+				else if(matchPattern(*character, "<filename", pattern_position_)) state_ = State::FileNameTag;
+				break;
+			case State::FileNameTag:
+				if(*character == '>') state_ = State::InsideImage;
+				else if(matchPattern(*character, "sval", pattern_position_)) state_ = State::FileNameValueQuote;
+				break;
+			case State::FileNameValueQuote:
+				if(*character == '"' || *character == '\'')
+				{
+					quote_ = *character;
+					file_name_.clear();
+					state_ = State::FileNameValue;
+				}
+				else if(*character != '=' && *character != ' ' && *character != '\t') state_ = State::InsideImage;
+				break;
+			case State::FileNameValue:
+				if(*character == quote_)
+				{
+					file_prefetcher_.prefetchFile(decodeXmlEntities(file_name_));
+					state_ = State::InsideImage;
+				}
+				else if(file_name_.size() < max_file_name_size) file_name_ += *character;
+				else state_ = State::InsideImage;
+				break;
+		}
+	}
+}
+
+} //namespace yafaray_xml
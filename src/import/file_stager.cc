@@ -0,0 +1,97 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/file_stager.h"
+#include "import/include_cache.h"
+#include "import/trace_recorder.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
+
+namespace yafaray_xml
+{
+
+void FileStager::stageFiles(const std::vector<std::string> &file_paths, IncludeCache *include_cache, const ParseControl *parse_control, TraceRecorder *trace_recorder)
+{
+	staged_files_.assign(file_paths.size(), {});
+	for(size_t file_index = 0; file_index < file_paths.size(); ++file_index)
+	{
+		std::error_code canonical_path_error;
+		staged_files_[file_index].file_path_ = file_paths[file_index];
+		staged_files_[file_index].canonical_file_path_ = std::filesystem::weakly_canonical(file_paths[file_index], canonical_path_error).string();
+	}
+	std::atomic<size_t> next_file_index{0};
+	const auto stage_next_files{[&]
+	{
+		for(size_t file_index = next_file_index++; file_index < staged_files_.size(); file_index = next_file_index++)
+		{
+			StagedFile &staged_file{staged_files_[file_index]};
+			const TraceScope trace_scope{trace_recorder, "xml", "stage file", staged_file.file_path_};
+			staged_file.element_events_ = include_cache ? include_cache->getElementEvents(staged_file.canonical_file_path_, parse_control, staged_file.error_message_) : IncludeCache::parseFile(staged_file.canonical_file_path_, parse_control, staged_file.error_message_);
+		}
+	}};
+	const size_t threads_count = std::min<size_t>(staged_files_.size(), std::max(1U, std::thread::hardware_concurrency()));
+	std::vector<std::thread> threads;
+	for(size_t thread_index = 1; thread_index < threads_count; ++thread_index)
+	{
+		threads.emplace_back([&]
+		{
+			if(trace_recorder) trace_recorder->setThreadName("File stager");
+			stage_next_files();
+		});
+	}
+	stage_next_files(); //The calling thread stages files too
+	for(auto &thread : threads) thread.join();
+}
+
+size_t FileStager::reportNameCollisions(yafaray_Logger *yafaray_logger) const
+{
+	std::unordered_map<std::string, size_t> first_file_indices; //!< Element kind + name -> index of the first file with such an element
+	size_t collisions = 0;
+	std::vector<std::string> element_stack;
+	for(size_t file_index = 0; file_index < staged_files_.size(); ++file_index)
+	{
+		if(!staged_files_[file_index].element_events_) continue;
+		const ElementEventList &element_events{*staged_files_[file_index].element_events_};
+		element_stack.clear();
+		const auto start_element{[&](const char *element, const char **attrs)
+		{
+			//Scene elements are named with their "name" attribute, while objects, surface integrators and films are named in their <parameters> element
+			const bool has_name = attrs && attrs[0] && !strcmp(attrs[0], "name");
+			std::string kind;
+			if(has_name && element_stack.size() == 1 && element_stack[0] == "scene" && strcmp(element, "parameters") != 0) kind = element;
+			else if(has_name && !strcmp(element, "parameters") && ((element_stack.size() == 1 && element_stack[0] != "scene") || (element_stack.size() == 2 && element_stack[0] == "scene" && element_stack[1] == "object"))) kind = element_stack.back();
+			element_stack.emplace_back(element);
+			if(kind.empty()) return;
+			const auto [first_file_index, inserted]{first_file_indices.emplace(kind + '\x1d' + attrs[1], file_index)};
+			if(inserted || first_file_index->second == file_index) return;
+			++collisions;
+			yafaray_printWarning(yafaray_logger, ("XMLParser: The " + kind + " '" + attrs[1] + "' of file '" + staged_files_[file_index].file_path_ + "' has the same name as the " + kind + " of file '" + staged_files_[first_file_index->second].file_path_ + "'").c_str());
+		}};
+		const auto end_element{[&](const char *) { if(!element_stack.empty()) element_stack.pop_back(); }};
+		element_events.visit(0, element_events.size(), start_element, end_element);
+	}
+	return collisions;
+}
+
+} //namespace yafaray_xml
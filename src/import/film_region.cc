@@ -0,0 +1,75 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/film_region.h"
+#include "common/string_to_number.h"
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+namespace yafaray_xml
+{
+
+void FilmRegion::readFilmParameter(const char *param_name, const char **attrs)
+{
+	if(!attrs || !attrs[0] || strcmp(attrs[0], "ival") != 0) return;
+	if(!strcmp(param_name, "height")) film_height_ = string_to_number::toInt(attrs[1]);
+	else if(!strcmp(param_name, "ystart")) film_start_y_ = string_to_number::toInt(attrs[1]);
+}
+
+bool FilmRegion::applyToFilm(yafaray_ParamMap *param_map)
+{
+	const int film_height = film_height_;
+	const int film_start_y = film_start_y_;
+	film_height_ = 0;
+	film_start_y_ = 0;
+	if(film_height <= 0) return false;
+	const auto region_start = static_cast<int>(static_cast<long long>(film_height) * region_index_ / regions_);
+	const auto region_end = static_cast<int>(static_cast<long long>(film_height) * (region_index_ + 1) / regions_);
+	yafaray_setParamMapInt(param_map, "height", region_end - region_start);
+	yafaray_setParamMapInt(param_map, "ystart", film_start_y + region_start);
+	return true;
+}
+
+std::string FilmRegion::addOutput(const std::string &image_path)
+{
+	const size_t extension_start = image_path.find_last_of('.');
+	const size_t file_name_start = image_path.find_last_of("/\\");
+	std::string extension{(extension_start == std::string::npos || (file_name_start != std::string::npos && extension_start < file_name_start)) ? std::string{} : image_path.substr(extension_start)};
+	for(auto &character : extension) character = static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+	if(extension != ".tga")
+	{
+		++unsupported_outputs_;
+		return {};
+	}
+	std::string partial_image_path{image_path + ".region" + std::to_string(region_index_) + "of" + std::to_string(regions_) + ".tga"};
+	outputs_.emplace_back(image_path, partial_image_path);
+	return partial_image_path;
+}
+
+bool FilmRegion::writeManifest(const std::string &file_path) const
+{
+	std::ofstream file(file_path);
+	if(!file) return false;
+	for(const auto &[image_path, partial_image_path] : outputs_) file << image_path << '\t' << partial_image_path << '\n';
+	return static_cast<bool>(file);
+}
+
+} //namespace yafaray_xml
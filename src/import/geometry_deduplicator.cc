@@ -0,0 +1,156 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include "import/geometry_deduplicator.h"
+#include "common/compact_geometry.h"
+#include "common/string_to_number.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace yafaray_xml
+{
+
+void GeometryDeduplicator::startObject()
+{
+	recorded_elements_.clear();
+	object_name_.clear();
+	positions_.clear();
+	hash_ = 14695981039346656037ull; //64 bit FNV-1a offset basis
+	level_ = 0;
+	base_object_ = false;
+	light_object_ = false;
+}
+
+void GeometryDeduplicator::hashString(const char *string)
+{
+	for(; *string; ++string)
+	{
+		hash_ ^= static_cast<unsigned char>(*string);
+		hash_ *= 1099511628211ull;
+	}
+	hash_ ^= 0xFF; //So the boundaries between strings are part of the hash
+	hash_ *= 1099511628211ull;
+}
+
+void GeometryDeduplicator::recordStartElement(const char *element, const char **attrs, const std::string &document_directory)
+{
+	recorded_elements_.addStartElement(element, attrs);
+	++level_;
+	hashString(element);
+	const bool object_parameters = level_ == 1 && !strcmp(element, "parameters");
+	const bool point = level_ == 1 && !strcmp(element, "p");
+	float position[3] = {0.f, 0.f, 0.f};
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		if(object_parameters && !strcmp(attrs[0], "name")) object_name_ = attrs[1];
+		else if(point && attrs[0][0] >= 'x' && attrs[0][0] <= 'z' && attrs[0][1] == '\0') position[attrs[0][0] - 'x'] = string_to_number::toFloat(attrs[1]);
+		else if(level_ == 1 && !strcmp(attrs[0], "file"))
+		{
+			//The same relative path in documents from different directories refers to different sidecar files
+			hashString(attrs[0]);
+			hashString(std::filesystem::absolute(compact_geometry::sidecarFilePath(attrs[1], document_directory)).lexically_normal().string().c_str());
+		}
+		else
+		{
+			hashString(attrs[0]);
+			hashString(attrs[1]);
+		}
+	}
+	if(point) positions_.insert(positions_.end(), std::begin(position), std::end(position));
+	else if(level_ == 2 && !strcmp(element, "is_base_object")) base_object_ = true;
+	else if(level_ == 2 && !strcmp(element, "light_name")) light_object_ = true;
+}
+
+void GeometryDeduplicator::recordEndElement(const char *element)
+{
+	recorded_elements_.addEndElement(element);
+	--level_;
+	hashString("/");
+}
+
+bool GeometryDeduplicator::findDuplicate(Duplicate &duplicate)
+{
+	if(base_object_ || light_object_ || object_name_.empty() || light_objects_.count(object_name_) > 0) return false;
+	std::vector<UniqueObject> &unique_objects = unique_objects_[hash_];
+	for(const auto &unique_object : unique_objects)
+	{
+		if(isTranslatedCopy(unique_object.positions_, positions_, duplicate.translation_))
+		{
+			duplicate.object_name_ = unique_object.object_name_;
+			return true;
+		}
+	}
+	unique_objects.push_back({object_name_, positions_});
+	return false;
+}
+
+bool GeometryDeduplicator::isTranslatedCopy(const std::vector<float> &original_positions, const std::vector<float> &positions, double translation[3])
+{
+	std::fill(translation, translation + 3, 0.0);
+	if(original_positions.size() != positions.size()) return false;
+	if(positions.empty()) return true;
+	double position_min[3], position_max[3];
+	double coordinate_max = 0.0;
+	for(int axis = 0; axis < 3; ++axis)
+	{
+		translation[axis] = static_cast<double>(positions[axis]) - static_cast<double>(original_positions[axis]);
+		position_min[axis] = position_max[axis] = original_positions[axis];
+	}
+	for(size_t index = 0; index < positions.size(); ++index)
+	{
+		const int axis = static_cast<int>(index % 3);
+		position_min[axis] = std::min(position_min[axis], static_cast<double>(original_positions[index]));
+		position_max[axis] = std::max(position_max[axis], static_cast<double>(original_positions[index]));
+		coordinate_max = std::max({coordinate_max, std::abs(static_cast<double>(original_positions[index])), std::abs(static_cast<double>(positions[index]))});
+	}
+	const double extent = std::max({position_max[0] - position_min[0], position_max[1] - position_min[1], position_max[2] - position_min[2]});
+	//The copies are usually written already translated, so their coordinates have float rounding errors of a few ulps relative to the largest coordinate
+	const double tolerance = 1e-6 * extent + std::ldexp(coordinate_max, -21);
+	for(size_t index = 0; index < positions.size(); ++index)
+	{
+		const double difference = static_cast<double>(positions[index]) - static_cast<double>(original_positions[index]) - translation[index % 3];
+		if(std::abs(difference) > tolerance) return false;
+	}
+	return true;
+}
+
+bool GeometryDeduplicator::findObjectInstance(const std::string &object_name, size_t &instance_id) const
+{
+	if(object_instances_.empty()) return false;
+	const auto object_instance{object_instances_.find(object_name)};
+	if(object_instance == object_instances_.end()) return false;
+	instance_id = object_instance->second;
+	return true;
+}
+
+bool GeometryDeduplicator::addLightObject(const std::string &object_name)
+{
+	light_objects_.insert(object_name);
+	return object_instances_.count(object_name) == 0;
+}
+
+void GeometryDeduplicator::clear()
+{
+	unique_objects_.clear();
+	object_instances_.clear();
+	light_objects_.clear();
+}
+
+} //namespace yafaray_xml
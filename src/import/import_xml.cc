@@ -19,9 +19,28 @@
  */
 
 #include "import/import_xml.h"
+#include "import/scene_worker.h"
+#include "import/file_prefetcher.h"
+#include "import/parse_control.h"
+#include "import/include_cache.h"
+#include "import/geometry_deduplicator.h"
+#include "import/trace_recorder.h"
+#include "import/param_overrides.h"
+#include "import/film_region.h"
+#include "import/progressive_loader.h"
+#include "import/file_stager.h"
+#ifdef YAFARAY_XML_WITH_TOKENIZER
+#include "import/xml_tokenizer.h"
+#endif
 #include <libxml/parser.h>
+#include <libxml/SAX2.h>
 #include "common/version_build_info.h"
 #include "common/element_parser_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <mutex>
 #include <sstream>
 #include <iostream>
 
@@ -63,8 +82,10 @@ static void xmlErrorProcessing(XmlErrorSeverity xml_error_severity, void *user_d
 		default: message_stream << "warning: "; break;
 	}
 
-	xmlErrorPtr error = xmlGetLastError();
-	message_stream << "(error code " << error->code << ") [line:" << error->line << ", col:" << error->int2 << "] " << error->message;
+	//Using the error stored in this parser's own libxml2 context instead of the last global error, which could belong to another parser running in another thread
+	const xmlError *error = parser.getXmlParserContext() ? xmlCtxtGetLastError(parser.getXmlParserContext()) : nullptr;
+	if(error) message_stream << "(error code " << error->code << ") [line:" << error->line << ", col:" << error->int2 << "] " << (error->message ? error->message : "");
+	else message_stream << "(unknown error)";
 	switch(xml_error_severity)
 	{
 		case XmlErrorSeverity::FatalError:
@@ -118,18 +139,58 @@ static xmlSAXHandler my_handler_global =
 };
 
 
-XmlParser::XmlParser(yafaray_Logger *yafaray_logger, const char *input_color_space, float input_gamma) :
+static bool isTracedElement(const std::string &element)
+{
+	//Parameters and shader nodes are part of the element containing them, and instances are too many and too quick to be worth tracing
+	return element != "root" && element != "yafaray_container" && element != "parameters" && element != "shader_node" && element != "instance";
+}
+
+XmlParser::XmlParser(yafaray_Logger *yafaray_logger, const char *input_color_space, float input_gamma, const ParseOptions &parse_options) :
 		yafaray_logger_{yafaray_logger},
+		input_color_space_{input_color_space ? input_color_space : ""},
+		input_gamma_{input_gamma},
+		parse_options_{parse_options},
 		yafaray_param_map_{yafaray_createParamMap()},
 		yafaray_param_map_list_{yafaray_createParamMapList()}
 {
 	if(yafaray_param_map_) yafaray_setInputColorSpace(yafaray_param_map_, input_color_space, input_gamma);
-	std::setlocale(LC_NUMERIC, "C"); //To make sure floating points in the xml file are evaluated using the dot and not a comma in some locales
+	if(parse_options_.prefetch_image_files_) file_prefetcher_ = std::make_unique<FilePrefetcher>(2);
+	if(parse_options_.deduplicate_geometry_) geometry_deduplicator_ = std::make_unique<GeometryDeduplicator>();
+	if(parse_options_.trace_recorder_) trace_recorder_ = parse_options_.trace_recorder_;
+	else if(!parse_options_.trace_file_path_.empty())
+	{
+		trace_recorder_owned_ = std::make_unique<TraceRecorder>();
+		trace_recorder_ = trace_recorder_owned_.get();
+		trace_recorder_->setThreadName("XML parser");
+	}
+	if(parse_options_.shared_param_overrides_) param_overrides_ = parse_options_.shared_param_overrides_;
+	else if(!parse_options_.param_overrides_.empty())
+	{
+		param_overrides_owned_ = std::make_unique<ParamOverrides>();
+		for(const auto &param_override : parse_options_.param_overrides_)
+		{
+			if(!param_overrides_owned_->add(param_override)) yafaray_printWarning(yafaray_logger_, ("XMLParser: Ignoring parameter override '" + param_override + "', it must be in the form element.element.parameter=value").c_str());
+		}
+		if(!param_overrides_owned_->empty()) param_overrides_ = param_overrides_owned_.get();
+	}
+	if(parse_options_.progressive_load_callback_)
+	{
+		progressive_loader_ = std::make_unique<ProgressiveLoader>(parse_options_.progressive_load_callback_, parse_options_.progressive_load_callback_data_, parse_options_.progressive_load_objects_per_step_, parse_options_.progressive_load_step_time_ms_);
+		if(parse_options_.concurrent_scenes_) yafaray_printWarning(yafaray_logger_, "XMLParser: Concurrent scenes are not used with progressive loading, building the scenes in the parsing thread");
+	}
+#ifndef YAFARAY_XML_WITH_TOKENIZER
+	if(parse_options_.builtin_tokenizer_) yafaray_printWarning(yafaray_logger_, "XMLParser: The library was built without the built-in tokenizer, parsing with libxml2");
+#endif
+	if(parse_options_.film_regions_ > 1 && parse_options_.film_region_index_ < parse_options_.film_regions_) film_region_ = std::make_unique<FilmRegion>(parse_options_.film_region_index_, parse_options_.film_regions_);
+	static std::once_flag xml_library_initialized;
+	std::call_once(xml_library_initialized, xmlInitParser); //libxml2 global initialization is not thread safe, so doing it only once before any parser can start using it
 	pushState(startElDocument, endElDocument, "root", nullptr);
 }
 
 XmlParser::~XmlParser()
 {
+	joinSceneWorkers();
+	if(idle_xml_parser_context_) xmlFreeParserCtxt(idle_xml_parser_context_);
 	yafaray_destroyParamMapList(yafaray_param_map_list_);
 	yafaray_destroyParamMap(yafaray_param_map_);
 }
@@ -143,12 +204,170 @@ void XmlParser::pushState(StartElementCb_t start, EndElementCb_t end, const char
 	state.element_name_ = getElementName(*this, element_attrs);
 	state.element_attributes_ = getElementAttrs(element_attrs);
 	state.level_ = level_;
-	state_stack_.push_back(state);
+	state.trace_start_time_ = trace_recorder_ ? trace_recorder_->getTimeMicroseconds() : 0;
+	state_stack_.push_back(std::move(state));
 	current_ = &state_stack_.back();
 }
 
+void XmlParser::startElement(const char *element, const char **attrs)
+{
+	if(isParsingCancelled())
+	{
+		if(xml_parser_context_) xmlStopParser(xml_parser_context_);
+#ifdef YAFARAY_XML_WITH_TOKENIZER
+		if(xml_tokenizer_) xml_tokenizer_->stop();
+#endif
+		return;
+	}
+	if(parse_options_.progress_callback_) updateProgress(element, attrs);
+	++level_;
+	if(scene_worker_receiving_) scene_worker_receiving_->startElement(element, attrs);
+	else if(current_) current_->start_(*this, element, attrs);
+}
+
+void XmlParser::endElement(const char *element)
+{
+	if(isParsingCancelled()) return;
+	if(scene_worker_receiving_)
+	{
+		scene_worker_receiving_->endElement(element);
+		if(level_ == scene_worker_level_)
+		{
+			scene_worker_receiving_->finish();
+			scene_worker_receiving_ = nullptr;
+		}
+	}
+	else if(current_) current_->end_(*this, element);
+	--level_;
+}
+
+void XmlParser::startSceneWorker(const char *element, const char **attrs)
+{
+	ParseOptions scene_worker_parse_options{parse_options_};
+	scene_worker_parse_options.concurrent_scenes_ = false;
+	scene_worker_parse_options.prefetch_image_files_ = false; //Already done by this parser, which sees all the document
+	scene_worker_parse_options.progress_callback_ = nullptr; //Also reported by this parser
+	scene_worker_parse_options.builtin_tokenizer_ = false; //Scene workers do not parse the XML text themselves
+	scene_worker_parse_options.trace_recorder_ = trace_recorder_;
+	scene_worker_parse_options.shared_param_overrides_ = param_overrides_;
+	scene_workers_.emplace_back(std::make_unique<SceneWorker>(yafaray_logger_, input_color_space_, input_gamma_, scene_worker_parse_options, document_directory_));
+	scene_worker_receiving_ = scene_workers_.back().get();
+	scene_worker_level_ = level_;
+	scene_worker_receiving_->startElement(element, attrs);
+}
+
+void XmlParser::joinSceneWorkers()
+{
+	scene_worker_receiving_ = nullptr;
+	if(scene_workers_.empty()) return;
+	const TraceScope trace_scope{trace_recorder_, "xml", "join scene workers", {}};
+	for(auto &scene_worker : scene_workers_)
+	{
+		yafaray_scene_ = scene_worker->join();
+		if(yafaray_scene_ && yafaray_container_) yafaray_addSceneToContainer(yafaray_container_, yafaray_scene_);
+	}
+	scene_workers_.clear();
+}
+
+void XmlParser::includeFile(const char **attrs)
+{
+	std::filesystem::path include_path;
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		if(!strcmp(attrs[0], "file")) include_path = attrs[1];
+	}
+	if(include_path.empty())
+	{
+		yafaray_printWarning(yafaray_logger_, "XMLParser: Ignoring <include> element without 'file' attribute");
+		return;
+	}
+	//Relative paths are relative to the file with the <include> element, which for nested includes is the including file, not the main document
+	if(include_path.is_relative() && !document_directory_.empty()) include_path = std::filesystem::path{document_directory_} / include_path;
+	std::error_code canonical_path_error;
+	const std::string include_file_path{std::filesystem::weakly_canonical(include_path, canonical_path_error).string()};
+	if(std::find(include_stack_.begin(), include_stack_.end(), include_file_path) != include_stack_.end())
+	{
+		yafaray_printError(yafaray_logger_, ("XMLParser: Ignoring circular include of file '" + include_file_path + "'").c_str());
+		return;
+	}
+	std::string error_message;
+	const std::shared_ptr<const ElementEventList> element_events{parse_options_.include_cache_ ? parse_options_.include_cache_->getElementEvents(include_file_path, parse_options_.parse_control_, error_message) : IncludeCache::parseFile(include_file_path, parse_options_.parse_control_, error_message)};
+	if(!element_events)
+	{
+		yafaray_printError(yafaray_logger_, ("XMLParser: Cannot include file '" + include_file_path + "': " + error_message).c_str());
+		return;
+	}
+	yafaray_printVerbose(yafaray_logger_, ("XMLParser: Including file '" + include_file_path + "'").c_str());
+	const TraceScope trace_scope{trace_recorder_, "xml", "include", include_file_path};
+	const std::string document_directory{document_directory_};
+	document_directory_ = std::filesystem::path{include_file_path}.parent_path().string();
+	include_stack_.push_back(include_file_path);
+	element_events->replay(*this);
+	include_stack_.pop_back();
+	document_directory_ = document_directory;
+}
+
+void XmlParser::addWarning(Diagnostics::Kind kind, const char *element, const char *detail)
+{
+	if(!diagnostics_.countWarning(kind, element)) return;
+	diagnostics_.printWarning(kind, element, detail, getLineNumber());
+}
+
+int XmlParser::getLineNumber() const
+{
+#ifdef YAFARAY_XML_WITH_TOKENIZER
+	if(xml_tokenizer_) return xml_tokenizer_->getLineNumber();
+#endif
+	return xml_parser_context_ ? xmlSAX2GetLineNumber(xml_parser_context_) : 0; //Not available for scene workers, which do not parse the XML text themselves
+}
+
+bool XmlParser::isParsingCancelled() const
+{
+	return parse_options_.parse_control_ && parse_options_.parse_control_->isCancelled();
+}
+
+void XmlParser::updateProgress(const char *element, const char **attrs)
+{
+	//Scene and object names are set in the <parameters> element right after the <scene> or <object> element
+	if(!strcmp(element, "scene")) progress_name_pending_ = &progress_scene_name_;
+	else if(!strcmp(element, "object")) progress_name_pending_ = &progress_object_name_;
+	else
+	{
+		if(progress_name_pending_ && !strcmp(element, "parameters")) *progress_name_pending_ = getElementName(*this, attrs);
+		progress_name_pending_ = nullptr;
+	}
+	if(++elements_since_progress_check_ < progress_check_elements_interval_) return;
+	elements_since_progress_check_ = 0;
+	if(std::chrono::steady_clock::now() - last_progress_report_time_ >= progress_report_interval_) reportProgress(false);
+}
+
+void XmlParser::reportProgress(bool parsing_finished)
+{
+	if(!parse_options_.progress_callback_) return;
+	size_t bytes_parsed = parsing_finished ? input_size_ : 0;
+	if(!parsing_finished && xml_parser_context_) bytes_parsed = static_cast<size_t>(std::max(0L, xmlByteConsumed(xml_parser_context_)));
+#ifdef YAFARAY_XML_WITH_TOKENIZER
+	if(!parsing_finished && xml_tokenizer_) bytes_parsed = xml_tokenizer_->getBytesConsumed();
+#endif
+	last_progress_report_time_ = std::chrono::steady_clock::now();
+	parse_options_.progress_callback_(bytes_parsed, input_size_, progress_scene_name_.c_str(), progress_object_name_.c_str(), parse_options_.progress_callback_data_);
+}
+
+void XmlParser::prefetchImageFile(const char **attrs)
+{
+	if(!file_prefetcher_ || !attrs || !attrs[0] || attrs[2] || strcmp(attrs[0], "sval") != 0) return;
+	file_prefetcher_->prefetchFile(attrs[1]);
+}
+
+void XmlParser::addLightObject(const char **attrs)
+{
+	if(!geometry_deduplicator_ || !attrs || !attrs[0] || attrs[2] || strcmp(attrs[0], "sval") != 0) return;
+	if(!geometry_deduplicator_->addLightObject(attrs[1])) yafaray_printWarning(yafaray_logger_, ("XMLParser: A light refers to object '" + std::string(attrs[1]) + "', which was already added as an instance of an object with the same geometry. Write the lights before the objects they refer to when deduplicating geometry").c_str());
+}
+
 void XmlParser::popState()
 {
+	if(trace_recorder_ && isTracedElement(current_->element_)) trace_recorder_->addEvent("xml", current_->element_.c_str(), current_->element_name_, current_->trace_start_time_);
 	state_stack_.pop_back();
 	if(!state_stack_.empty()) current_ = &state_stack_.back();
 	else current_ = nullptr;
@@ -156,42 +375,408 @@ void XmlParser::popState()
 
 void XmlParser::createScene(const char *name)
 {
+	element_fingerprints_.clear();
+	name_aliases_.clear();
+	if(geometry_deduplicator_) geometry_deduplicator_->clear();
+	const TraceScope trace_scope{trace_recorder_, "libyafaray", "yafaray_createScene", name};
 	yafaray_scene_ = yafaray_createScene(yafaray_logger_, name);
-	yafaray_addSceneToContainer(yafaray_container_, yafaray_scene_);
+	if(yafaray_container_) yafaray_addSceneToContainer(yafaray_container_, yafaray_scene_);
+}
+
+void XmlParser::addObjectToInstance(size_t instance_id, const char *object_name)
+{
+	size_t object_instance_id;
+	if(geometry_deduplicator_ && geometry_deduplicator_->findObjectInstance(object_name, object_instance_id))
+	{
+		//The object was replaced by an instance when deduplicating the geometry
+		yafaray_addInstanceOfInstance(yafaray_scene_, instance_id, object_instance_id);
+		return;
+	}
+	size_t object_id;
+	yafaray_getObjectId(yafaray_scene_, &object_id, object_name);
+	yafaray_addInstanceObject(yafaray_scene_, instance_id, object_id);
 }
 
 void XmlParser::createSurfaceIntegrator(const char *name)
 {
+	const TraceScope trace_scope{trace_recorder_, "libyafaray", "yafaray_createSurfaceIntegrator", name};
 	yafaray_surface_integrator_ = yafaray_createSurfaceIntegrator(yafaray_logger_, name, yafaray_param_map_);
 	yafaray_addSurfaceIntegratorToContainer(yafaray_container_, yafaray_surface_integrator_);
 }
 
 void XmlParser::createFilm(const char *name)
 {
+	const TraceScope trace_scope{trace_recorder_, "libyafaray", "yafaray_createFilm", name};
 	yafaray_film_ = yafaray_createFilm(yafaray_logger_, yafaray_surface_integrator_, name, yafaray_param_map_);
 	yafaray_addFilmToContainer(yafaray_container_, yafaray_film_);
+	yafaray_preview_film_ = nullptr;
+	if(progressive_loader_)
+	{
+		//The previews of the progressive loading are rendered quickly in their own film, so they do not write the outputs of the film
+		yafaray_setParamMapInt(yafaray_param_map_, "AA_passes", 1);
+		yafaray_setParamMapInt(yafaray_param_map_, "AA_minsamples", 1);
+		yafaray_preview_film_ = yafaray_createFilm(yafaray_logger_, yafaray_surface_integrator_, (std::string{name} + " (preview)").c_str(), yafaray_param_map_);
+		yafaray_addFilmToContainer(yafaray_container_, yafaray_preview_film_);
+	}
+	if(parse_options_.film_callback_) parse_options_.film_callback_(yafaray_film_, yafaray_surface_integrator_, yafaray_preview_film_, parse_options_.film_callback_data_);
+}
+
+void XmlParser::startElementFingerprint(const char *element)
+{
+	param_map_fingerprint_.clear();
+	fingerprinting_element_ = parse_options_.deduplicate_resources_ && (!strcmp(element, "material") || !strcmp(element, "texture") || !strcmp(element, "image"));
+}
+
+void XmlParser::appendParamMapFingerprint(const char *param_name, const char **attrs)
+{
+	if(!fingerprinting_element_) return;
+	const bool name_reference{isNameReference(param_name)};
+	param_map_fingerprint_ += param_name;
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		param_map_fingerprint_ += '\x1f';
+		param_map_fingerprint_ += attrs[0];
+		param_map_fingerprint_ += '=';
+		if(attrs[1]) param_map_fingerprint_ += name_reference ? resolveNameAlias(attrs[1]) : attrs[1];
+	}
+	param_map_fingerprint_ += '\x1e';
+}
+
+std::string XmlParser::findDuplicateElement(const std::string &element) const
+{
+	const auto element_fingerprint{element_fingerprints_.find(element + '\x1d' + param_map_fingerprint_)};
+	if(element_fingerprint == element_fingerprints_.end()) return {};
+	else return element_fingerprint->second;
+}
+
+void XmlParser::registerElementFingerprint(const std::string &element, const std::string &element_name)
+{
+	element_fingerprints_.emplace(element + '\x1d' + param_map_fingerprint_, element_name);
+}
+
+const char *XmlParser::resolveNameAlias(const char *name) const
+{
+	if(name_aliases_.empty()) return name;
+	const auto name_alias{name_aliases_.find(name)};
+	if(name_alias == name_aliases_.end()) return name;
+	else return name_alias->second.c_str();
+}
+
+bool XmlParser::isNameReference(const char *param_name)
+{
+	return !strcmp(param_name, "texture") || !strcmp(param_name, "image_name") || !strcmp(param_name, "material") || !strcmp(param_name, "material1") || !strcmp(param_name, "material2");
+}
+
+bool XmlParser::beginPushParsing(const char *document_name)
+{
+	if(idle_xml_parser_context_ && xmlCtxtResetPush(idle_xml_parser_context_, nullptr, 0, document_name, nullptr) == 0)
+	{
+		xml_parser_context_ = idle_xml_parser_context_;
+		xml_parser_context_->userData = this;
+	}
+	else
+	{
+		if(idle_xml_parser_context_) xmlFreeParserCtxt(idle_xml_parser_context_);
+		xml_parser_context_ = xmlCreatePushParserCtxt(&my_handler_global, this, nullptr, 0, document_name);
+	}
+	idle_xml_parser_context_ = nullptr;
+	if(!xml_parser_context_) return false;
+	xmlCtxtUseOptions(xml_parser_context_, XML_PARSE_HUGE);
+	return true;
+}
+
+bool XmlParser::parseChunk(const char *chunk, size_t chunk_size)
+{
+	if(isParsingCancelled()) return false;
+	xmlParseChunk(xml_parser_context_, chunk, static_cast<int>(chunk_size), 0);
+	return xml_parser_context_->instate != XML_PARSER_EOF;
+}
+
+bool XmlParser::endPushParsing()
+{
+	if(!isParsingCancelled()) xmlParseChunk(xml_parser_context_, nullptr, 0, 1);
+	idle_xml_parser_context_ = xml_parser_context_;
+	xml_parser_context_ = nullptr;
+	return !isParsingCancelled();
+}
+
+bool XmlParser::parseFile(const char *xml_file_path)
+{
+	if(!xml_file_path) return false;
+	const TraceScope trace_scope{trace_recorder_, "xml", "parse file", xml_file_path};
+	document_directory_ = std::filesystem::path{xml_file_path}.parent_path().string();
+	std::error_code canonical_path_error;
+	include_stack_.assign(1, std::filesystem::weakly_canonical(xml_file_path, canonical_path_error).string());
+	//Using the libxml2 input layer to read the file, so compressed files and URIs are still accepted as with xmlSAXUserParseFile
+	xmlParserInputBufferPtr xml_input_buffer{xmlParserInputBufferCreateFilename(xml_file_path, XML_CHAR_ENCODING_NONE)};
+	if(!xml_input_buffer) return false;
+	if(!xml_input_buffer->readcallback)
+	{
+		xmlFreeParserInputBuffer(xml_input_buffer);
+		return false;
+	}
+	std::error_code file_size_error;
+	const auto file_size{std::filesystem::file_size(xml_file_path, file_size_error)};
+	if(!file_size_error && xml_input_buffer->compressed != 1) input_size_ = static_cast<size_t>(file_size);
+	const ReadInput_t read_input{[xml_input_buffer](char *buffer, int size) { return xml_input_buffer->readcallback(xml_input_buffer->context, buffer, size); }};
+	bool parse_ok;
+#ifdef YAFARAY_XML_WITH_TOKENIZER
+	if(parse_options_.builtin_tokenizer_) parse_ok = tokenizeInput(xml_file_path, read_input);
+	else
+#endif
+	parse_ok = pushParseInput(xml_file_path, read_input, 0);
+	xmlFreeParserInputBuffer(xml_input_buffer);
+	return parse_ok;
+}
+
+bool XmlParser::pushParseInput(const char *document_name, const ReadInput_t &read_input, size_t data_size)
+{
+	if(!beginPushParsing(document_name)) return false;
+	read_buffer_.resize(std::max(read_buffer_.size(), parse_chunk_size_));
+	int chunk_size = 0;
+	if(data_size == 0 || parseChunk(read_buffer_.data(), data_size))
+	{
+		while((chunk_size = read_input(read_buffer_.data(), static_cast<int>(parse_chunk_size_))) > 0)
+		{
+			if(!parseChunk(read_buffer_.data(), static_cast<size_t>(chunk_size))) break;
+		}
+	}
+	return endPushParsing() && chunk_size >= 0;
+}
+
+#ifdef YAFARAY_XML_WITH_TOKENIZER
+static void tokenizerStartElement(void *user_data, const char *element, const char **attrs)
+{
+	static_cast<XmlParser *>(user_data)->startElement(element, attrs);
+}
+
+static void tokenizerEndElement(void *user_data, const char *element)
+{
+	static_cast<XmlParser *>(user_data)->endElement(element);
 }
 
-std::tuple<bool, yafaray_Container *> XmlParser::parseXmlFile(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma) noexcept
+bool XmlParser::tokenizeInput(const char *document_name, const ReadInput_t &read_input)
 {
-	XmlParser parser{yafaray_logger, input_color_space, input_gamma};
-	if(!xml_file_path || xmlSAXUserParseFile(&my_handler_global, &parser, xml_file_path) < 0)
+	XmlTokenizer xml_tokenizer{tokenizerStartElement, tokenizerEndElement, this};
+	size_t data_size = 0; //Data read and not tokenized yet, at the start of the read buffer
+	bool input_ended = false;
+	bool read_ok = true;
+	while(!input_ended)
 	{
-		yafaray_printError(parser.getLogger(), ("XMLParser: Error parsing the file " + std::string(xml_file_path)).c_str());
-		return {};
+		//Reading at least as much as is already in the buffer, so a single huge element is not scanned again and again while it is being read
+		const size_t read_size{std::min(std::max(parse_chunk_size_, data_size), static_cast<size_t>(std::numeric_limits<int>::max()))};
+		if(read_buffer_.size() < data_size + read_size + 1) read_buffer_.resize(data_size + read_size + 1); //One more byte for the tokenizer sentinel
+		const int chunk_size = read_input(read_buffer_.data() + data_size, static_cast<int>(read_size));
+		if(chunk_size < 0) read_ok = false;
+		input_ended = chunk_size <= 0;
+		if(!input_ended && data_size == 0 && xml_tokenizer.getBytesConsumed() == 0 && !XmlTokenizer::isSupportedEncoding(read_buffer_.data(), static_cast<size_t>(chunk_size)))
+		{
+			yafaray_printVerbose(yafaray_logger_, "XMLParser: The document encoding is not read by the built-in tokenizer, parsing it with libxml2");
+			return pushParseInput(document_name, read_input, static_cast<size_t>(chunk_size));
+		}
+		data_size += static_cast<size_t>(std::max(0, chunk_size));
+		size_t bytes_tokenized = 0;
+		xml_tokenizer_ = &xml_tokenizer;
+		const XmlTokenizer::Result result{xml_tokenizer.tokenize(read_buffer_.data(), data_size, input_ended, bytes_tokenized)};
+		xml_tokenizer_ = nullptr;
+		if(result == XmlTokenizer::Result::Error)
+		{
+			//Reported like the libxml2 errors, which do not make the parsing fail either
+			yafaray_printError(yafaray_logger_, ("XMLParser error: [line:" + std::to_string(xml_tokenizer.getLineNumber()) + "] " + xml_tokenizer.getErrorMessage()).c_str());
+			break;
+		}
+		else if(result != XmlTokenizer::Result::NeedMoreData) break;
+		std::memmove(read_buffer_.data(), read_buffer_.data() + bytes_tokenized, data_size - bytes_tokenized);
+		data_size -= bytes_tokenized;
 	}
-	else return {true, parser.getContainer()};
+	return !isParsingCancelled() && read_ok;
 }
+#endif //YAFARAY_XML_WITH_TOKENIZER
 
-std::tuple<bool, yafaray_Container *> XmlParser::parseXmlMemory(yafaray_Logger *yafaray_logger, const char *xml_buffer, int xml_buffer_size, const char *input_color_space, float input_gamma) noexcept
+bool XmlParser::parseMemory(const char *xml_buffer, size_t xml_buffer_size)
 {
-	XmlParser parser{yafaray_logger, input_color_space, input_gamma};
-	if(!xml_buffer || xml_buffer_size <= 0 || xmlSAXUserParseMemory(&my_handler_global, &parser, xml_buffer, xml_buffer_size) < 0)
+	if(!xml_buffer || xml_buffer_size == 0) return false;
+#ifdef YAFARAY_XML_WITH_TOKENIZER
+	if(parse_options_.builtin_tokenizer_)
 	{
-		yafaray_printError(parser.getLogger(), "XMLParser: Error parsing a memory buffer");
-		return {};
+		//The tokenizer works in place and needs a sentinel byte after the data, so the buffer, which belongs to the caller and is const, is copied in chunks into the read buffer.
+		//The copy takes about 2% of the tokenizing time and keeps the extra memory bounded to one chunk, which is cheaper than a writable copy of the whole buffer
+		const TraceScope trace_scope{trace_recorder_, "xml", "parse memory", {}};
+		input_size_ = xml_buffer_size;
+		size_t buffer_offset = 0;
+		const ReadInput_t read_input{[xml_buffer, xml_buffer_size, &buffer_offset](char *buffer, int size) {
+			const size_t chunk_size{std::min(static_cast<size_t>(size), xml_buffer_size - buffer_offset)};
+			std::memcpy(buffer, xml_buffer + buffer_offset, chunk_size);
+			buffer_offset += chunk_size;
+			return static_cast<int>(chunk_size);
+		}};
+		return tokenizeInput(nullptr, read_input);
 	}
-	else return {true, parser.getContainer()};
+#endif
+	if(!beginPushParsing(nullptr)) return false;
+	const TraceScope trace_scope{trace_recorder_, "xml", "parse memory", {}};
+	input_size_ = xml_buffer_size;
+	for(size_t offset = 0; offset < xml_buffer_size; offset += parse_chunk_size_)
+	{
+		if(!parseChunk(xml_buffer + offset, std::min(parse_chunk_size_, xml_buffer_size - offset))) break;
+	}
+	return endPushParsing();
+}
+
+std::tuple<bool, yafaray_Container *> XmlParser::parseXmlFile(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma, const ParseOptions &parse_options) noexcept
+{
+	XmlParser parser{yafaray_logger, input_color_space, input_gamma, parse_options};
+	return parser.parseDocumentFile(xml_file_path);
+}
+
+std::tuple<bool, yafaray_Container *> XmlParser::parseXmlMemory(yafaray_Logger *yafaray_logger, const char *xml_buffer, size_t xml_buffer_size, const char *input_color_space, float input_gamma, const ParseOptions &parse_options) noexcept
+{
+	XmlParser parser{yafaray_logger, input_color_space, input_gamma, parse_options};
+	return parser.parseDocumentMemory(xml_buffer, xml_buffer_size);
+}
+
+std::tuple<bool, yafaray_Container *> XmlParser::parseXmlFiles(yafaray_Logger *yafaray_logger, const std::vector<std::string> &xml_file_paths, const char *input_color_space, float input_gamma, const ParseOptions &parse_options) noexcept
+{
+	ParseOptions files_parse_options{parse_options};
+	files_parse_options.concurrent_scenes_ = false; //The files are already parsed concurrently, and their scenes are merged into one
+	XmlParser parser{yafaray_logger, input_color_space, input_gamma, files_parse_options};
+	parser.merging_scenes_ = true;
+	parser.document_parsed_ = true;
+	parser.createContainer();
+	if(parser.file_prefetcher_)
+	{
+		for(const auto &xml_file_path : xml_file_paths) parser.file_prefetcher_->prefetchImageFilesInXmlFile(xml_file_path.c_str());
+	}
+	FileStager file_stager;
+	{
+		const TraceScope trace_scope{parser.trace_recorder_, "xml", "stage files", {}};
+		file_stager.stageFiles(xml_file_paths, parse_options.include_cache_, parse_options.parse_control_, parser.trace_recorder_);
+	}
+	bool parse_ok = !xml_file_paths.empty();
+	for(const auto &staged_file : file_stager.getStagedFiles())
+	{
+		if(staged_file.element_events_) continue;
+		yafaray_printError(yafaray_logger, ("XMLParser: Cannot parse file '" + staged_file.file_path_ + "': " + staged_file.error_message_).c_str());
+		parse_ok = false;
+	}
+	if(parse_ok)
+	{
+		file_stager.reportNameCollisions(yafaray_logger);
+		//The staged files do not include their root element, so it is opened and closed here for all of them
+		parser.level_ = 1;
+		parser.pushState(startElYafaRayContainer, endElYafaRayContainer, "yafaray_container", nullptr);
+		for(const auto &staged_file : file_stager.getStagedFiles())
+		{
+			if(parser.isParsingCancelled()) break;
+			const TraceScope trace_scope{parser.trace_recorder_, "xml", "build file", staged_file.file_path_};
+			parser.document_directory_ = std::filesystem::path{staged_file.file_path_}.parent_path().string();
+			parser.include_stack_.assign(1, staged_file.canonical_file_path_);
+			staged_file.element_events_->replay(parser);
+		}
+		parser.endElement("yafaray_container");
+		parse_ok = !parser.isParsingCancelled();
+	}
+	return parser.finishParsing(parse_ok, std::to_string(xml_file_paths.size()) + " files");
+}
+
+std::tuple<bool, yafaray_Container *> XmlParser::parseDocumentFile(const char *xml_file_path) noexcept
+{
+	if(document_parsed_) resetDocument();
+	document_parsed_ = true;
+	createContainer();
+	if(file_prefetcher_ && xml_file_path) file_prefetcher_->prefetchImageFilesInXmlFile(xml_file_path);
+	const bool parse_ok{parseFile(xml_file_path)};
+	return finishParsing(parse_ok, "the file " + std::string(xml_file_path ? xml_file_path : ""));
+}
+
+std::tuple<bool, yafaray_Container *> XmlParser::parseDocumentMemory(const char *xml_buffer, size_t xml_buffer_size) noexcept
+{
+	if(document_parsed_) resetDocument();
+	document_parsed_ = true;
+	createContainer();
+	if(file_prefetcher_ && xml_buffer) file_prefetcher_->prefetchImageFilesInXmlMemory(xml_buffer, xml_buffer_size);
+	const bool parse_ok{parseMemory(xml_buffer, xml_buffer_size)};
+	return finishParsing(parse_ok, "a memory buffer");
+}
+
+void XmlParser::resetDocument()
+{
+	//Everything set while parsing the previous document goes back to its initial state. The libxml2 parser context, the file prefetcher threads and the buffers are kept
+	joinSceneWorkers();
+	state_stack_.clear();
+	current_ = nullptr;
+	level_ = 0;
+	document_directory_.clear();
+	include_stack_.clear();
+	scene_worker_level_ = 0;
+	input_size_ = 0;
+	elements_since_progress_check_ = 0;
+	last_progress_report_time_ = {};
+	progress_scene_name_.clear();
+	progress_object_name_.clear();
+	progress_name_pending_ = nullptr;
+	if(trace_recorder_owned_)
+	{
+		trace_recorder_owned_ = std::make_unique<TraceRecorder>();
+		trace_recorder_ = trace_recorder_owned_.get();
+		trace_recorder_->setThreadName("XML parser");
+	}
+	if(param_overrides_owned_) param_overrides_owned_->clearCounts();
+	if(film_region_) film_region_->clear();
+	if(geometry_deduplicator_) geometry_deduplicator_->clear();
+	if(progressive_loader_) progressive_loader_->clear();
+	if(file_prefetcher_) file_prefetcher_->clearRequestedFiles();
+	parse_arena_.clear();
+	polygon_triangulator_.clearPoints();
+	diagnostics_.clear();
+	yafaray_container_ = nullptr;
+	yafaray_scene_ = nullptr;
+	yafaray_surface_integrator_ = nullptr;
+	yafaray_film_ = nullptr;
+	yafaray_preview_film_ = nullptr;
+	clearParamMap();
+	clearParamMapList();
+	element_fingerprints_.clear();
+	name_aliases_.clear();
+	instance_id_current_ = 0;
+	object_id_current_ = 0;
+	material_id_current_ = 0;
+	time_current_ = 0.f;
+	pushState(startElDocument, endElDocument, "root", nullptr);
+}
+
+std::tuple<bool, yafaray_Container *> XmlParser::finishParsing(bool parse_ok, const std::string &input_description)
+{
+	joinSceneWorkers();
+	//The XML scans of the prefetcher may still be reading the caller's buffer, which can be freed as soon as this returns
+	if(file_prefetcher_) file_prefetcher_->cancelScans();
+	printDiagnosticsSummary();
+	if(param_overrides_owned_) param_overrides_owned_->printSummary(yafaray_logger_);
+	if(film_region_ && !film_region_->outputsSupported()) parse_ok = false;
+	if(film_region_ && parse_ok && !parse_options_.film_region_manifest_path_.empty() && !film_region_->writeManifest(parse_options_.film_region_manifest_path_)) yafaray_printError(yafaray_logger_, ("XMLParser: Cannot write the film region manifest file '" + parse_options_.film_region_manifest_path_ + "'").c_str());
+	if(trace_recorder_owned_ && !trace_recorder_owned_->writeFile(parse_options_.trace_file_path_)) yafaray_printError(yafaray_logger_, ("XMLParser: Cannot write the trace file '" + parse_options_.trace_file_path_ + "'").c_str());
+	reportTemporaryAllocations();
+	parse_arena_.release();
+	if(parse_ok)
+	{
+		reportProgress(true);
+		return {true, yafaray_container_};
+	}
+	if(isParsingCancelled()) yafaray_printWarning(yafaray_logger_, ("XMLParser: Parsing of " + input_description + " cancelled").c_str());
+	else yafaray_printError(yafaray_logger_, ("XMLParser: Error parsing " + input_description).c_str());
+	//The partially built container cannot be returned to the caller, so it is destroyed here to avoid leaking it
+	if(yafaray_container_) yafaray_destroyContainerAndContainedPointers(yafaray_container_);
+	yafaray_container_ = nullptr;
+	return {};
+}
+
+void XmlParser::reportTemporaryAllocations() const
+{
+	const CountingMemoryResource &requested = parse_arena_.getRequested();
+	if(requested.getAllocations() == 0) return;
+	std::string message{"XMLParser: " + std::to_string(requested.getAllocations()) + " temporary allocations (" + std::to_string(requested.getAllocatedBytes()) + " bytes)"};
+	if(parse_arena_.isEnabled()) message += ", " + std::to_string(parse_arena_.getSystem().getAllocations()) + " of them from the system allocator (" + std::to_string(parse_arena_.getSystem().getAllocatedBytes()) + " bytes) and the rest from the parse arena";
+	yafaray_printVerbose(yafaray_logger_, message.c_str());
 }
 
 std::string XmlParser::printStateStack() const
@@ -0,0 +1,142 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include "import/include_cache.h"
+#include "import/parse_control.h"
+#include <libxml/parser.h>
+#include <vector>
+
+namespace yafaray_xml
+{
+
+namespace
+{
+
+//! Records the element events inside the root element of an included file
+struct IncludeRecorder
+{
+	ElementEventList &element_events_;
+	int level_ = 0;
+};
+
+void recordStartElement(void *user_data, const xmlChar *name, const xmlChar **attrs)
+{
+	IncludeRecorder &include_recorder = *static_cast<IncludeRecorder *>(user_data);
+	if(include_recorder.level_++ > 0) include_recorder.element_events_.addStartElement(reinterpret_cast<const char *>(name), reinterpret_cast<const char **>(attrs));
+}
+
+void recordEndElement(void *user_data, const xmlChar *name)
+{
+	IncludeRecorder &include_recorder = *static_cast<IncludeRecorder *>(user_data);
+	if(--include_recorder.level_ > 0) include_recorder.element_events_.addEndElement(reinterpret_cast<const char *>(name));
+}
+
+//! Errors are taken from the parser context when the parsing fails, to report them with the name of the included file
+void ignoreXmlMessage(void * /*user_data*/, const char * /*msg*/, ...) { }
+
+} //namespace
+
+std::shared_ptr<const ElementEventList> IncludeCache::getElementEvents(const std::string &file_path, const ParseControl *parse_control, std::string &error_message)
+{
+	std::error_code file_error;
+	const auto modification_time{std::filesystem::last_write_time(file_path, file_error)};
+	const uintmax_t size{file_error ? 0 : std::filesystem::file_size(file_path, file_error)};
+	if(file_error)
+	{
+		error_message = file_error.message();
+		return nullptr;
+	}
+	{
+		std::lock_guard<std::mutex> lock{mutex_};
+		const auto entry{entries_.find(file_path)};
+		if(entry != entries_.end() && entry->second.modification_time_ == modification_time && entry->second.size_ == size) return entry->second.element_events_;
+	}
+	//Parsed without holding the lock, so parsers including other files are not blocked meanwhile
+	auto element_events{parseFile(file_path, parse_control, error_message)};
+	if(element_events)
+	{
+		std::lock_guard<std::mutex> lock{mutex_};
+		entries_[file_path] = {modification_time, size, element_events};
+	}
+	return element_events;
+}
+
+void IncludeCache::clear()
+{
+	std::lock_guard<std::mutex> lock{mutex_};
+	entries_.clear();
+}
+
+std::shared_ptr<const ElementEventList> IncludeCache::parseFile(const std::string &file_path, const ParseControl *parse_control, std::string &error_message)
+{
+	xmlParserInputBufferPtr xml_input_buffer{xmlParserInputBufferCreateFilename(file_path.c_str(), XML_CHAR_ENCODING_NONE)};
+	if(!xml_input_buffer || !xml_input_buffer->readcallback)
+	{
+		if(xml_input_buffer) xmlFreeParserInputBuffer(xml_input_buffer);
+		error_message = "cannot open the file";
+		return nullptr;
+	}
+	xmlSAXHandler include_handler{};
+	include_handler.startElement = recordStartElement;
+	include_handler.endElement = recordEndElement;
+	include_handler.warning = ignoreXmlMessage;
+	include_handler.error = ignoreXmlMessage;
+	include_handler.fatalError = ignoreXmlMessage;
+	auto element_events{std::make_shared<ElementEventList>()};
+	IncludeRecorder include_recorder{*element_events};
+	xmlParserCtxtPtr xml_parser_context{xmlCreatePushParserCtxt(&include_handler, &include_recorder, nullptr, 0, file_path.c_str())};
+	if(!xml_parser_context)
+	{
+		xmlFreeParserInputBuffer(xml_input_buffer);
+		error_message = "cannot create the XML parser";
+		return nullptr;
+	}
+	xmlCtxtUseOptions(xml_parser_context, XML_PARSE_HUGE);
+	constexpr int chunk_size_max = 4 * 1024 * 1024;
+	std::vector<char> chunk(chunk_size_max);
+	bool parse_ok = true;
+	int chunk_size;
+	while(parse_ok && (chunk_size = xml_input_buffer->readcallback(xml_input_buffer->context, chunk.data(), chunk_size_max)) > 0)
+	{
+		if(parse_control && parse_control->isCancelled())
+		{
+			error_message = "parsing cancelled";
+			parse_ok = false;
+		}
+		else parse_ok = xmlParseChunk(xml_parser_context, chunk.data(), chunk_size, 0) == 0;
+	}
+	if(parse_ok && chunk_size < 0)
+	{
+		error_message = "error reading the file";
+		parse_ok = false;
+	}
+	else if(parse_ok) parse_ok = xmlParseChunk(xml_parser_context, nullptr, 0, 1) == 0 && xml_parser_context->wellFormed;
+	if(!parse_ok && error_message.empty())
+	{
+		const xmlError *error = xmlCtxtGetLastError(xml_parser_context);
+		error_message = error && error->message ? "line " + std::to_string(error->line) + ": " + error->message : "XML parsing error";
+		while(!error_message.empty() && error_message.back() == '\n') error_message.pop_back();
+	}
+	xmlFreeParserCtxt(xml_parser_context);
+	xmlFreeParserInputBuffer(xml_input_buffer);
+	if(!parse_ok) return nullptr;
+	return element_events;
+}
+
+} //namespace yafaray_xml
@@ -0,0 +1,136 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/param_overrides.h"
+#include "import/import_xml.h"
+
+namespace yafaray_xml
+{
+
+bool ParamOverrides::parse(const std::string &param_override, Override &result)
+{
+	const size_t value_start = param_override.find('=');
+	if(value_start == std::string::npos || value_start == 0) return false;
+	result.text_ = param_override;
+	result.value_ = param_override.substr(value_start + 1);
+	result.path_.clear();
+	size_t path_element_start = 0;
+	while(true)
+	{
+		size_t path_element_end = param_override.find('.', path_element_start);
+		if(path_element_end == std::string::npos || path_element_end > value_start) path_element_end = value_start;
+		const std::string path_element{param_override.substr(path_element_start, path_element_end - path_element_start)};
+		if(path_element.empty()) return false;
+		if(path_element_end == value_start)
+		{
+			if(path_element.find_first_of("[]*") != std::string::npos) return false;
+			result.param_name_ = path_element;
+			return true;
+		}
+		PathElement element;
+		const size_t name_start = path_element.find('[');
+		if(name_start == std::string::npos) element.element_ = path_element;
+		else
+		{
+			if(name_start == 0 || path_element.back() != ']' || name_start + 2 >= path_element.size()) return false;
+			element.element_ = path_element.substr(0, name_start);
+			element.name_ = path_element.substr(name_start + 1, path_element.size() - name_start - 2);
+		}
+		result.path_.emplace_back(std::move(element));
+		path_element_start = path_element_end + 1;
+	}
+}
+
+bool ParamOverrides::isWellFormed(const std::string &param_override)
+{
+	Override result;
+	return parse(param_override, result);
+}
+
+bool ParamOverrides::add(const std::string &param_override)
+{
+	Override result;
+	if(!parse(param_override, result)) return false;
+	overrides_.emplace_back(std::move(result));
+	return true;
+}
+
+bool ParamOverrides::matches(const Override &param_override, const std::vector<ParserState> &state_stack, const char *param_name)
+{
+	if(param_override.param_name_ != param_name) return false;
+	auto path_element = param_override.path_.begin();
+	for(const auto &state : state_stack)
+	{
+		if(state.element_ == "root" || state.element_ == "yafaray_container") continue;
+		if(path_element == param_override.path_.end() || (path_element->element_ != "*" && path_element->element_ != state.element_) || (!path_element->name_.empty() && path_element->name_ != state.element_name_)) return false;
+		++path_element;
+	}
+	return path_element == param_override.path_.end();
+}
+
+size_t ParamOverrides::find(const XmlParser &parser, const char *param_name)
+{
+	const std::vector<ParserState> &state_stack{parser.getStateStack()};
+	for(size_t index = overrides_.size(); index-- > 0;)
+	{
+		if(!matches(overrides_[index], state_stack, param_name)) continue;
+		std::unique_lock<std::mutex> lock(mutex_, std::defer_lock); //Only taken when an earlier override also matches, which is rare
+		for(size_t earlier_index = 0; earlier_index < index; ++earlier_index)
+		{
+			if(!matches(overrides_[earlier_index], state_stack, param_name)) continue;
+			if(!lock.owns_lock()) lock.lock();
+			++overrides_[earlier_index].overridden_count_;
+		}
+		return index;
+	}
+	return npos;
+}
+
+void ParamOverrides::countApplied(size_t index, bool applied)
+{
+	std::lock_guard<std::mutex> lock_guard(mutex_);
+	if(applied) ++overrides_[index].applied_count_;
+	else ++overrides_[index].rejected_count_;
+}
+
+void ParamOverrides::clearCounts()
+{
+	std::lock_guard<std::mutex> lock_guard(mutex_);
+	for(auto &param_override : overrides_)
+	{
+		param_override.applied_count_ = 0;
+		param_override.rejected_count_ = 0;
+		param_override.overridden_count_ = 0;
+	}
+}
+
+void ParamOverrides::printSummary(yafaray_Logger *yafaray_logger) const
+{
+	std::lock_guard<std::mutex> lock_guard(mutex_);
+	for(const auto &param_override : overrides_)
+	{
+		if(param_override.rejected_count_ > 0) yafaray_printError(yafaray_logger, ("XMLParser: Parameter override '" + param_override.text_ + "' could not be applied to " + std::to_string(param_override.rejected_count_) + " parameter(s), the value does not fit their type").c_str());
+		if(param_override.overridden_count_ > 0) yafaray_printWarning(yafaray_logger, ("XMLParser: Parameter override '" + param_override.text_ + "' was overridden by a later override on " + std::to_string(param_override.overridden_count_) + " parameter(s)").c_str());
+		if(param_override.applied_count_ > 0) yafaray_printVerbose(yafaray_logger, ("XMLParser: Parameter override '" + param_override.text_ + "' applied to " + std::to_string(param_override.applied_count_) + " parameter(s)").c_str());
+		else if(param_override.rejected_count_ == 0 && param_override.overridden_count_ == 0) yafaray_printWarning(yafaray_logger, ("XMLParser: Parameter override '" + param_override.text_ + "' did not match any parameter").c_str());
+	}
+}
+
+} //namespace yafaray_xml
@@ -0,0 +1,63 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/parse_arena.h"
+
+namespace yafaray_xml
+{
+
+void *CountingMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	++allocations_;
+	allocated_bytes_ += bytes;
+	return upstream_->allocate(bytes, alignment);
+}
+
+void CountingMemoryResource::do_deallocate(void *pointer, size_t bytes, size_t alignment)
+{
+	upstream_->deallocate(pointer, bytes, alignment);
+}
+
+static std::pmr::pool_options poolOptions(size_t largest_pooled_block)
+{
+	std::pmr::pool_options options;
+	options.largest_required_pool_block = largest_pooled_block;
+	return options;
+}
+
+ParseArena::ParseArena(bool enabled) :
+		pools_{enabled ? std::optional<std::pmr::unsynchronized_pool_resource>{std::in_place, poolOptions(largest_pooled_block_), &system_} : std::nullopt},
+		requested_{pools_ ? static_cast<std::pmr::memory_resource *>(&*pools_) : &system_}
+{
+}
+
+void ParseArena::release()
+{
+	if(pools_) pools_->release();
+}
+
+void ParseArena::clear()
+{
+	release();
+	requested_.clearCounts();
+	system_.clearCounts();
+}
+
+} //namespace yafaray_xml
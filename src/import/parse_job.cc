@@ -0,0 +1,98 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/parse_job.h"
+#include "import/import_xml.h"
+
+namespace yafaray_xml
+{
+
+ParseJob::ParseJob(yafaray_Logger *yafaray_logger, std::string xml_file_path, const char *xml_buffer, size_t xml_buffer_size, const char *input_color_space, float input_gamma, const ParseOptions &parse_options) :
+		xml_file_path_{std::move(xml_file_path)},
+		xml_buffer_{xml_buffer},
+		xml_buffer_size_{xml_buffer_size},
+		parse_options_{parse_options},
+		parse_control_{parse_options.parse_control_},
+		caller_progress_callback_{parse_options.progress_callback_},
+		caller_progress_callback_data_{parse_options.progress_callback_data_}
+{
+	parse_options_.parse_control_ = &parse_control_;
+	parse_options_.progress_callback_ = progressCallback;
+	parse_options_.progress_callback_data_ = this;
+	thread_ = std::thread(&ParseJob::run, this, yafaray_logger, std::string{input_color_space ? input_color_space : ""}, input_gamma);
+}
+
+ParseJob::~ParseJob()
+{
+	if(getStatus() == Status::Running) cancel();
+	if(thread_.joinable()) thread_.join();
+	if(yafaray_container_) yafaray_destroyContainerAndContainedPointers(yafaray_container_);
+}
+
+void ParseJob::run(yafaray_Logger *yafaray_logger, const std::string &input_color_space, float input_gamma)
+{
+	const auto [parse_ok, yafaray_container]{xml_buffer_ ?
+			XmlParser::parseXmlMemory(yafaray_logger, xml_buffer_, xml_buffer_size_, input_color_space.c_str(), input_gamma, parse_options_) :
+			XmlParser::parseXmlFile(yafaray_logger, xml_file_path_.c_str(), input_color_space.c_str(), input_gamma, parse_options_)};
+	{
+		std::lock_guard<std::mutex> lock_guard(mutex_);
+		yafaray_container_ = yafaray_container;
+		if(parse_ok && yafaray_container) status_.store(Status::Succeeded, std::memory_order_release);
+		else status_.store(parse_control_.isCancelled() ? Status::Cancelled : Status::Failed, std::memory_order_release);
+	}
+	finished_condition_.notify_all();
+}
+
+void ParseJob::progressCallback(size_t bytes_parsed, size_t bytes_total, const char *scene_name, const char *object_name, void *callback_data)
+{
+	auto &parse_job{*static_cast<ParseJob *>(callback_data)};
+	parse_job.bytes_parsed_.store(bytes_parsed, std::memory_order_relaxed);
+	parse_job.bytes_total_.store(bytes_total, std::memory_order_relaxed);
+	if(parse_job.caller_progress_callback_) parse_job.caller_progress_callback_(bytes_parsed, bytes_total, scene_name, object_name, parse_job.caller_progress_callback_data_);
+}
+
+bool ParseJob::wait(std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	const auto finished{[this] { return getStatus() != Status::Running; }};
+	if(timeout.count() < 0)
+	{
+		finished_condition_.wait(lock, finished);
+		return true;
+	}
+	return finished_condition_.wait_for(lock, timeout, finished);
+}
+
+void ParseJob::getProgress(size_t &bytes_parsed, size_t &bytes_total) const
+{
+	bytes_parsed = bytes_parsed_.load(std::memory_order_relaxed);
+	bytes_total = bytes_total_.load(std::memory_order_relaxed);
+}
+
+yafaray_Container *ParseJob::takeContainer()
+{
+	wait(std::chrono::milliseconds{-1});
+	std::lock_guard<std::mutex> lock_guard(mutex_);
+	yafaray_Container *yafaray_container = yafaray_container_;
+	yafaray_container_ = nullptr;
+	return yafaray_container;
+}
+
+} //namespace yafaray_xml
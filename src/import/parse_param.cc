@@ -19,77 +19,273 @@
  */
 
 #include "import/import_xml.h"
+#include "import/param_overrides.h"
 #include "common/vec3f.h"
 #include "common/rgba.h"
+#include "common/matrix4.h"
+#include "common/string_to_number.h"
+#include <algorithm>
+#include <array>
 #include <cstring>
 
 namespace yafaray_xml
 {
 
-void parseParam(yafaray_ParamMap *yafaray_param_map, const char **attrs, const char *param_name)
+//! Parameter decoders selected from the attribute names signature, so the attribute names of each parameter element are only checked once
+class ParamDecoder final
 {
-	if(!attrs || !attrs[0]) return;
-	if(!attrs[2]) // only one attribute => bool, integer or float value
-	{
-		if(!strcmp(attrs[0], "ival"))
+	public:
+		//! Attributes of a parameter element with the values replaced by those of a parameter override
+		struct OverrideAttributes
 		{
-			const int i = atoi(attrs[1]);
-			yafaray_setParamMapInt(yafaray_param_map, param_name, i);
-			return;
-		}
-		else if(!strcmp(attrs[0], "fval"))
+			std::array<std::string, 16> values_;
+			std::array<const char *, 16 * 2 + 1> attrs_;
+		};
+		static void decode(XmlParser &parser, const char **attrs, const char *param_name);
+		//! Builds the attributes of the parameter with the override values, separated by commas or blanks. Returns false if they do not fit the type of the parameter
+		[[nodiscard]] static bool overrideAttributes(const char **attrs, const std::string &override_value, OverrideAttributes &override_attributes);
+
+	private:
+		enum class Signature : unsigned char { Unknown, Int, Float, Bool, String, Vector, Color, Matrix, Size };
+		[[nodiscard]] static Signature signature(const char **attrs);
+		typedef void (*Decoder_t)(XmlParser &parser, const char **attrs, const char *param_name);
+		[[nodiscard]] static constexpr Signature singleAttributeSignature(const char *attribute_name);
+		[[nodiscard]] static constexpr Signature multipleAttributeSignature(const char *attribute_name);
+		[[nodiscard]] static constexpr bool isMatrixElementName(const char *attribute_name);
+		template <Signature signature> static void decodeAs(XmlParser &parser, const char **attrs, const char *param_name);
+		static const std::array<Decoder_t, static_cast<size_t>(Signature::Size)> decoders_;
+};
+
+constexpr ParamDecoder::Signature ParamDecoder::singleAttributeSignature(const char *attribute_name)
+{
+	//"ival", "fval", "bval" or "sval"
+	if(attribute_name[0] == '\0' || attribute_name[1] != 'v' || attribute_name[2] != 'a' || attribute_name[3] != 'l' || attribute_name[4] != '\0') return Signature::Unknown;
+	switch(attribute_name[0])
+	{
+		case 'i': return Signature::Int;
+		case 'f': return Signature::Float;
+		case 'b': return Signature::Bool;
+		case 's': return Signature::String;
+		default: return Signature::Unknown;
+	}
+}
+
+constexpr bool ParamDecoder::isMatrixElementName(const char *attribute_name)
+{
+	//"mij" where i and j are between 0 and 3 (inclusive)
+	return attribute_name[0] == 'm' && attribute_name[1] >= '0' && attribute_name[1] <= '3' && attribute_name[2] >= '0' && attribute_name[2] <= '3' && attribute_name[3] == '\0';
+}
+
+constexpr ParamDecoder::Signature ParamDecoder::multipleAttributeSignature(const char *attribute_name)
+{
+	if(attribute_name[0] != '\0' && attribute_name[1] == '\0')
+	{
+		switch(attribute_name[0])
 		{
-			const double f = atof(attrs[1]);
-			yafaray_setParamMapFloat(yafaray_param_map, param_name, f);
-			return;
+			case 'x':
+			case 'y':
+			case 'z': return Signature::Vector;
+			case 'r':
+			case 'g':
+			case 'b':
+			case 'a': return Signature::Color;
+			default: return Signature::Unknown;
 		}
-		else if(!strcmp(attrs[0], "bval"))
+	}
+	else if(isMatrixElementName(attribute_name)) return Signature::Matrix;
+	else return Signature::Unknown;
+}
+
+template <>
+void ParamDecoder::decodeAs<ParamDecoder::Signature::Int>(XmlParser &parser, const char **attrs, const char *param_name)
+{
+	yafaray_setParamMapInt(parser.getParamMap(), param_name, string_to_number::toInt(attrs[1]));
+}
+
+template <>
+void ParamDecoder::decodeAs<ParamDecoder::Signature::Float>(XmlParser &parser, const char **attrs, const char *param_name)
+{
+	yafaray_setParamMapFloat(parser.getParamMap(), param_name, string_to_number::toDouble(attrs[1]));
+}
+
+template <>
+void ParamDecoder::decodeAs<ParamDecoder::Signature::Bool>(XmlParser &parser, const char **attrs, const char *param_name)
+{
+	const bool b = (strcmp(attrs[1], "true") == 0 || strcmp(attrs[1], "1") == 0);
+	yafaray_setParamMapBool(parser.getParamMap(), param_name, static_cast<yafaray_Bool>(b));
+}
+
+template <>
+void ParamDecoder::decodeAs<ParamDecoder::Signature::String>(XmlParser &parser, const char **attrs, const char *param_name)
+{
+	yafaray_setParamMapString(parser.getParamMap(), param_name, XmlParser::isNameReference(param_name) ? parser.resolveNameAlias(attrs[1]) : attrs[1]);
+}
+
+template <>
+void ParamDecoder::decodeAs<ParamDecoder::Signature::Vector>(XmlParser &parser, const char **attrs, const char *param_name)
+{
+	Vec3f v(0.f, 0.f, 0.f);
+	for(; attrs[0]; attrs += 2)
+	{
+		if(attrs[0][0] == '\0' || attrs[0][1] != '\0') continue;
+		switch(attrs[0][0])
 		{
-			const bool b = (strcmp(attrs[1], "true") == 0 || strcmp(attrs[1], "1") == 0);
-			yafaray_setParamMapBool(yafaray_param_map, param_name, static_cast<yafaray_Bool>(b));
-			return;
+			case 'x': v.x_ = string_to_number::toFloat(attrs[1]); break;
+			case 'y': v.y_ = string_to_number::toFloat(attrs[1]); break;
+			case 'z': v.z_ = string_to_number::toFloat(attrs[1]); break;
+			default: break;
 		}
-		else if(!strcmp(attrs[0], "sval"))
+	}
+	yafaray_setParamMapVector(parser.getParamMap(), param_name, v.x_, v.y_, v.z_);
+}
+
+template <>
+void ParamDecoder::decodeAs<ParamDecoder::Signature::Color>(XmlParser &parser, const char **attrs, const char *param_name)
+{
+	Rgba c(0.f);
+	for(; attrs[0]; attrs += 2)
+	{
+		if(attrs[0][0] == '\0' || attrs[0][1] != '\0') continue;
+		switch(attrs[0][0])
 		{
-			yafaray_setParamMapString(yafaray_param_map, param_name, attrs[1]);
-			return;
+			case 'r': c.r_ = string_to_number::toFloat(attrs[1]); break;
+			case 'g': c.g_ = string_to_number::toFloat(attrs[1]); break;
+			case 'b': c.b_ = string_to_number::toFloat(attrs[1]); break;
+			case 'a': c.a_ = string_to_number::toFloat(attrs[1]); break;
+			default: break;
 		}
 	}
-	Rgba c(0.f);
-	Vec3f v(0, 0, 0);
-	double matrix[4][4];
-	enum class ParameterType : int { None, Vector, Color, Matrix } type = ParameterType::None;
-	for(int n = 0; attrs[n]; ++n)
+	yafaray_setParamMapColor(parser.getParamMap(), param_name, c.r_, c.g_, c.b_, c.a_);
+}
+
+template <>
+void ParamDecoder::decodeAs<ParamDecoder::Signature::Matrix>(XmlParser &parser, const char **attrs, const char *param_name)
+{
+	Matrix4 matrix;
+	for(; attrs[0]; attrs += 2)
+	{
+		if(!isMatrixElementName(attrs[0])) continue;
+		const int i = attrs[0][1] - '0';
+		const int j = attrs[0][2] - '0';
+		matrix.m_[i][j] = string_to_number::toDouble(attrs[1]);
+	}
+	yafaray_setParamMapMatrixArray(parser.getParamMap(), param_name, matrix.data(), static_cast<yafaray_Bool>(false));
+}
+
+const std::array<ParamDecoder::Decoder_t, static_cast<size_t>(ParamDecoder::Signature::Size)> ParamDecoder::decoders_{
+		nullptr,
+		decodeAs<Signature::Int>,
+		decodeAs<Signature::Float>,
+		decodeAs<Signature::Bool>,
+		decodeAs<Signature::String>,
+		decodeAs<Signature::Vector>,
+		decodeAs<Signature::Color>,
+		decodeAs<Signature::Matrix>,
+};
+
+ParamDecoder::Signature ParamDecoder::signature(const char **attrs)
+{
+	Signature signature = Signature::Unknown;
+	if(!attrs[2]) signature = singleAttributeSignature(attrs[0]);
+	if(signature == Signature::Unknown)
+	{
+		for(const char **attr = attrs; attr[0] && signature == Signature::Unknown; attr += 2) signature = multipleAttributeSignature(attr[0]);
+	}
+	return signature;
+}
+
+void ParamDecoder::decode(XmlParser &parser, const char **attrs, const char *param_name)
+{
+	const Signature signature{ParamDecoder::signature(attrs)};
+	if(signature != Signature::Unknown) decoders_[static_cast<size_t>(signature)](parser, attrs, param_name);
+}
+
+bool ParamDecoder::overrideAttributes(const char **attrs, const std::string &override_value, OverrideAttributes &override_attributes)
+{
+	static constexpr std::array<const char *, 16> matrix_element_names{"m00", "m01", "m02", "m03", "m10", "m11", "m12", "m13", "m20", "m21", "m22", "m23", "m30", "m31", "m32", "m33"};
+	const Signature signature{ParamDecoder::signature(attrs)};
+	std::array<const char *, 16> names{};
+	size_t values_required = 1;
+	size_t values_allowed = 1;
+	switch(signature)
+	{
+		case Signature::Int: names[0] = "ival"; break;
+		case Signature::Float: names[0] = "fval"; break;
+		case Signature::Bool: names[0] = "bval"; break;
+		case Signature::String: names[0] = "sval"; break;
+		case Signature::Vector: names = {"x", "y", "z"}; values_required = values_allowed = 3; break;
+		case Signature::Color: names = {"r", "g", "b", "a"}; values_required = 3; values_allowed = 4; break;
+		case Signature::Matrix: names = matrix_element_names; values_required = values_allowed = 16; break;
+		default: return false;
+	}
+	size_t values_count = 0;
+	if(signature == Signature::String) override_attributes.values_[values_count++] = override_value;
+	else
 	{
-		if(attrs[n][1] == '\0')
+		//Numbers separated by commas or blanks, each one validated for the type of the parameter
+		std::string numbers{override_value};
+		std::replace(numbers.begin(), numbers.end(), ',', ' ');
+		const char *number_end = numbers.data() + numbers.size();
+		const char *number = numbers.data();
+		while(number)
 		{
-			switch(attrs[n][0])
+			while(number < number_end && (*number == ' ' || *number == '\t')) ++number;
+			if(number == number_end) break;
+			if(values_count == values_allowed) return false;
+			const char *next_number;
+			if(signature == Signature::Bool)
 			{
-				case 'x': v.x_ = static_cast<float>(atof(attrs[n + 1])); type = ParameterType::Vector; break;
-				case 'y': v.y_ = static_cast<float>(atof(attrs[n + 1])); type = ParameterType::Vector; break;
-				case 'z': v.z_ = static_cast<float>(atof(attrs[n + 1])); type = ParameterType::Vector; break;
-
-				case 'r': c.r_ = static_cast<float>(atof(attrs[n + 1])); type = ParameterType::Color; break;
-				case 'g': c.g_ = static_cast<float>(atof(attrs[n + 1])); type = ParameterType::Color; break;
-				case 'b': c.b_ = static_cast<float>(atof(attrs[n + 1])); type = ParameterType::Color; break;
-				case 'a': c.a_ = static_cast<float>(atof(attrs[n + 1])); type = ParameterType::Color; break;
+				next_number = number;
+				while(next_number < number_end && *next_number != ' ' && *next_number != '\t') ++next_number;
+				const std::string value{number, next_number};
+				if(value != "true" && value != "false" && value != "1" && value != "0") return false;
 			}
+			else if(signature == Signature::Int)
+			{
+				int value;
+				next_number = string_to_number::readNext(number, number_end, value);
+			}
+			else
+			{
+				double value;
+				next_number = string_to_number::readNext(number, number_end, value);
+			}
+			if(!next_number || (next_number < number_end && *next_number != ' ' && *next_number != '\t')) return false;
+			override_attributes.values_[values_count++].assign(number, next_number);
+			number = next_number;
 		}
-		else if(attrs[n][3] == '\0' && attrs[n][0] == 'm' && attrs[n][1] >= '0' && attrs[n][1] <= '3' && attrs[n][2] >= '0' && attrs[n][2] <= '3') //"mij" where i and j are between 0 and 3 (inclusive)
-		{
-			type = ParameterType::Matrix;
-			const int i = attrs[n][1] - '0';
-			const int j = attrs[n][2] - '0';
-			matrix[i][j] = atof(attrs[n + 1]);
-		}
+		if(values_count < values_required) return false;
+		if(values_count == 3 && signature == Signature::Color) override_attributes.values_[values_count++] = "1";
+	}
+	for(size_t index = 0; index < values_count; ++index)
+	{
+		override_attributes.attrs_[2 * index] = names[index];
+		override_attributes.attrs_[2 * index + 1] = override_attributes.values_[index].c_str();
 	}
+	override_attributes.attrs_[2 * values_count] = nullptr;
+	return true;
+}
 
-	if(type == ParameterType::Vector) yafaray_setParamMapVector(yafaray_param_map, param_name, v.x_, v.y_, v.z_);
-	else if(type == ParameterType::Matrix) yafaray_setParamMapMatrixArray(yafaray_param_map, param_name, reinterpret_cast<const double *>(matrix), static_cast<yafaray_Bool>(false));
-	else if(type == ParameterType::Color)
+void parseParam(XmlParser &parser, const char **attrs, const char *param_name, bool apply_overrides)
+{
+	if(!attrs || !attrs[0]) return;
+	ParamOverrides *param_overrides{apply_overrides ? parser.getParamOverrides() : nullptr};
+	if(param_overrides)
 	{
-		yafaray_setParamMapColor(yafaray_param_map, param_name, c.r_, c.g_, c.b_, c.a_);
+		const size_t override_index{param_overrides->find(parser, param_name)};
+		if(override_index != ParamOverrides::npos)
+		{
+			ParamDecoder::OverrideAttributes override_attributes;
+			const bool applied{ParamDecoder::overrideAttributes(attrs, param_overrides->getValue(override_index), override_attributes)};
+			param_overrides->countApplied(override_index, applied);
+			if(applied) attrs = override_attributes.attrs_.data();
+			parser.appendParamMapFingerprint(param_name, attrs);
+			ParamDecoder::decode(parser, attrs, param_name);
+			return;
+		}
 	}
+	parser.appendParamMapFingerprint(param_name, attrs);
+	ParamDecoder::decode(parser, attrs, param_name);
 }
 
-} //namespace yafaray_xml
\ No newline at end of file
+} //namespace yafaray_xml
@@ -0,0 +1,137 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/polygon_triangulator.h"
+#include <cmath>
+
+namespace yafaray_xml
+{
+
+namespace
+{
+
+float cross2d(const float *origin, const float *a, const float *b)
+{
+	return (a[0] - origin[0]) * (b[1] - origin[1]) - (a[1] - origin[1]) * (b[0] - origin[0]);
+}
+
+bool isInsideTriangle(const float *point, const float *a, const float *b, const float *c)
+{
+	//Inclusive test for counter-clockwise triangles, so points on the edges also prevent clipping an ear
+	return cross2d(a, b, point) >= 0.f && cross2d(b, c, point) >= 0.f && cross2d(c, a, point) >= 0.f;
+}
+
+} //namespace
+
+const std::vector<PolygonTriangulator::Triangle_t> &PolygonTriangulator::triangulate(const int *vertices_indices, size_t number_of_vertices)
+{
+	if(!recording_points_)
+	{
+		recording_points_ = true;
+		first_recorded_point_ = number_of_points_;
+	}
+	triangles_.clear();
+	remaining_corners_.clear();
+	for(size_t corner = 0; corner < number_of_vertices; ++corner) remaining_corners_.push_back(corner);
+	if(number_of_vertices < 4 || !clipEars(vertices_indices)) addFan();
+	return triangles_;
+}
+
+bool PolygonTriangulator::clipEars(const int *vertices_indices)
+{
+	const size_t number_of_vertices = remaining_corners_.size();
+	for(size_t corner = 0; corner < number_of_vertices; ++corner)
+	{
+		if(!findPoint(vertices_indices[corner])) return false;
+	}
+	//Newell's method for the polygon normal, robust for non-planar and concave polygons
+	double normal[3] = {0.0, 0.0, 0.0};
+	for(size_t corner = 0; corner < number_of_vertices; ++corner)
+	{
+		const Vec3f &current = *findPoint(vertices_indices[corner]);
+		const Vec3f &next = *findPoint(vertices_indices[(corner + 1) % number_of_vertices]);
+		normal[0] += (static_cast<double>(current.y_) - next.y_) * (static_cast<double>(current.z_) + next.z_);
+		normal[1] += (static_cast<double>(current.z_) - next.z_) * (static_cast<double>(current.x_) + next.x_);
+		normal[2] += (static_cast<double>(current.x_) - next.x_) * (static_cast<double>(current.y_) + next.y_);
+	}
+	int dominant_axis = 0;
+	if(std::abs(normal[1]) > std::abs(normal[dominant_axis])) dominant_axis = 1;
+	if(std::abs(normal[2]) > std::abs(normal[dominant_axis])) dominant_axis = 2;
+	if(normal[dominant_axis] == 0.0) return false;
+	//Projection dropping the dominant axis, with the axes swapped if needed so the polygon is counter-clockwise in the plane
+	const bool swap_axes = normal[dominant_axis] < 0.0;
+	projected_coordinates_.resize(2 * number_of_vertices);
+	for(size_t corner = 0; corner < number_of_vertices; ++corner)
+	{
+		const Vec3f &point = *findPoint(vertices_indices[corner]);
+		float u, v;
+		if(dominant_axis == 0) { u = point.y_; v = point.z_; }
+		else if(dominant_axis == 1) { u = point.z_; v = point.x_; }
+		else { u = point.x_; v = point.y_; }
+		projected_coordinates_[2 * corner] = swap_axes ? v : u;
+		projected_coordinates_[2 * corner + 1] = swap_axes ? u : v;
+	}
+	size_t position = 0;
+	size_t corners_checked_without_ear = 0;
+	while(remaining_corners_.size() > 3)
+	{
+		const size_t remaining = remaining_corners_.size();
+		const size_t previous = remaining_corners_[(position + remaining - 1) % remaining];
+		const size_t current = remaining_corners_[position % remaining];
+		const size_t next = remaining_corners_[(position + 1) % remaining];
+		const float *a = &projected_coordinates_[2 * previous];
+		const float *b = &projected_coordinates_[2 * current];
+		const float *c = &projected_coordinates_[2 * next];
+		bool is_ear = cross2d(a, b, c) > 0.f;
+		for(size_t other = 0; is_ear && other < remaining; ++other)
+		{
+			const size_t other_corner = remaining_corners_[other];
+			if(other_corner == previous || other_corner == current || other_corner == next) continue;
+			is_ear = !isInsideTriangle(&projected_coordinates_[2 * other_corner], a, b, c);
+		}
+		if(is_ear)
+		{
+			triangles_.push_back({previous, current, next});
+			remaining_corners_.erase(remaining_corners_.begin() + static_cast<std::ptrdiff_t>(position % remaining));
+			corners_checked_without_ear = 0;
+		}
+		else if(++corners_checked_without_ear > remaining) return false; //No ears left, the rest of the polygon is degenerate or self-intersecting
+		else ++position;
+		position %= remaining_corners_.size();
+	}
+	triangles_.push_back({remaining_corners_[0], remaining_corners_[1], remaining_corners_[2]});
+	return true;
+}
+
+const Vec3f *PolygonTriangulator::findPoint(int vertex_index) const
+{
+	if(vertex_index < 0 || static_cast<size_t>(vertex_index) < first_recorded_point_ || static_cast<size_t>(vertex_index) - first_recorded_point_ >= points_.size()) return nullptr;
+	return &points_[static_cast<size_t>(vertex_index) - first_recorded_point_];
+}
+
+void PolygonTriangulator::addFan()
+{
+	for(size_t corner = 1; corner + 1 < remaining_corners_.size(); ++corner)
+	{
+		triangles_.push_back({remaining_corners_[0], remaining_corners_[corner], remaining_corners_[corner + 1]});
+	}
+}
+
+} //namespace yafaray_xml
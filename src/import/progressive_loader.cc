@@ -0,0 +1,79 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/progressive_loader.h"
+#include "import/import_xml.h"
+#include "import/trace_recorder.h"
+
+namespace yafaray_xml
+{
+
+ProgressiveLoader::ProgressiveLoader(ProgressiveLoadCallback_t callback, void *callback_data, size_t objects_per_step, int step_time_ms) :
+		callback_{callback},
+		callback_data_{callback_data},
+		objects_per_step_{objects_per_step},
+		step_time_budget_{step_time_ms > 0 ? step_time_ms : 0}
+{
+}
+
+void ProgressiveLoader::startObject(const std::string &scene_name)
+{
+	scene_name_ = scene_name;
+	object_first_events_.push_back(deferred_elements_.size());
+}
+
+void ProgressiveLoader::buildObjects(XmlParser &parser, bool report_steps)
+{
+	const size_t objects_total = object_first_events_.size();
+	if(report_steps) reportStep(parser, 0);
+	if(objects_total > 0)
+	{
+		building_objects_ = true;
+		parser.pushState(startElScene, endElScene, "scene", nullptr);
+		parser.setStateElementName(scene_name_);
+		auto step_start_time{std::chrono::steady_clock::now()};
+		size_t objects_in_step = 0;
+		for(size_t object = 0; object < objects_total && !parser.isParsingCancelled(); ++object)
+		{
+			const size_t end_event = object + 1 < objects_total ? object_first_events_[object + 1] : deferred_elements_.size();
+			deferred_elements_.replay(parser, object_first_events_[object], end_event);
+			++objects_in_step;
+			const bool step_finished = (objects_per_step_ > 0 && objects_in_step >= objects_per_step_) || (step_time_budget_.count() > 0 && std::chrono::steady_clock::now() - step_start_time >= step_time_budget_);
+			if(report_steps && step_finished && object + 1 < objects_total && !parser.isParsingCancelled())
+			{
+				reportStep(parser, object + 1);
+				step_start_time = std::chrono::steady_clock::now();
+				objects_in_step = 0;
+			}
+		}
+		parser.popState();
+		building_objects_ = false;
+		if(report_steps && !parser.isParsingCancelled()) reportStep(parser, objects_total);
+	}
+	clear();
+}
+
+void ProgressiveLoader::reportStep(XmlParser &parser, size_t objects_built) const
+{
+	const TraceScope trace_scope{parser.getTraceRecorder(), "xml", "progressive load callback", {}};
+	callback_(parser.getContainer(), objects_built, object_first_events_.size(), callback_data_);
+}
+
+} //namespace yafaray_xml
@@ -0,0 +1,104 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/scene_worker.h"
+#include "import/trace_recorder.h"
+
+namespace yafaray_xml
+{
+
+SceneWorker::SceneWorker(yafaray_Logger *yafaray_logger, const std::string &input_color_space, float input_gamma, const ParseOptions &parse_options, const std::string &document_directory) :
+		parser_{yafaray_logger, input_color_space.c_str(), input_gamma, parse_options}
+{
+	parser_.setDocumentDirectory(document_directory);
+	parser_.pushState(startElYafaRayContainer, endElYafaRayContainer, "yafaray_container", nullptr);
+	thread_ = std::thread(&SceneWorker::run, this);
+}
+
+SceneWorker::~SceneWorker()
+{
+	if(thread_.joinable())
+	{
+		finish();
+		thread_.join();
+	}
+}
+
+void SceneWorker::startElement(const char *element, const char **attrs)
+{
+	batch_.addStartElement(element, attrs);
+	if(batch_.size() >= max_batch_size_) pushBatch();
+}
+
+void SceneWorker::endElement(const char *element)
+{
+	batch_.addEndElement(element);
+	if(batch_.size() >= max_batch_size_) pushBatch();
+}
+
+void SceneWorker::pushBatch()
+{
+	{
+		std::lock_guard<std::mutex> lock_guard(mutex_);
+		batch_queue_.emplace_back(std::move(batch_));
+	}
+	batch_.clear();
+	condition_.notify_one();
+}
+
+void SceneWorker::finish()
+{
+	if(!batch_.empty()) pushBatch();
+	{
+		std::lock_guard<std::mutex> lock_guard(mutex_);
+		finished_ = true;
+	}
+	condition_.notify_one();
+}
+
+yafaray_Scene *SceneWorker::join()
+{
+	if(thread_.joinable())
+	{
+		finish();
+		thread_.join();
+		parser_.printDiagnosticsSummary();
+	}
+	return parser_.getScene();
+}
+
+void SceneWorker::run()
+{
+	if(parser_.getTraceRecorder()) parser_.getTraceRecorder()->setThreadName("Scene worker");
+	while(true)
+	{
+		ElementEventList batch;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this] { return finished_ || !batch_queue_.empty(); });
+			if(batch_queue_.empty()) return;
+			batch = std::move(batch_queue_.front());
+			batch_queue_.pop_front();
+		}
+		batch.replay(parser_);
+	}
+}
+
+} //namespace yafaray_xml
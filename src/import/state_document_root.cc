@@ -19,6 +19,7 @@
  */
 
 #include "import/import_xml.h"
+#include "import/progressive_loader.h"
 #include "common/version.h"
 #include "common/version_build_info.h"
 #include <cstring>
@@ -76,23 +77,30 @@ void startElYafaRayContainer(XmlParser &parser, const char *element, const char
 {
 	if(!strcmp(element, "scene"))
 	{
-		parser.pushState(startElScene, endElScene, element, attrs);
+		//Only the geometry of the last scene is loaded progressively, as the scene being built changes with each new scene
+		if(parser.getProgressiveLoader()) parser.getProgressiveLoader()->buildObjects(parser, false);
+		if(parser.getParseOptions().concurrent_scenes_ && !parser.getProgressiveLoader()) parser.startSceneWorker(element, attrs);
+		else parser.pushState(startElScene, endElScene, element, attrs);
 	}
 	else if(!strcmp(element, "surface_integrator"))
 	{
+		parser.joinSceneWorkers();
 		parser.pushState(startElSurfaceIntegrator, endElSurfaceIntegrator, element, attrs);
 	}
 	else if(!strcmp(element, "film"))
 	{
+		parser.joinSceneWorkers();
 		parser.pushState(startElFilm, endElFilm, element, attrs);
 	}
-	else yafaray_printWarning(parser.getLogger(), ("XMLParser: Skipping unrecognized YafaRayContainer element '" + std::string(element) + "'").c_str());
+	else parser.addWarning(Diagnostics::Kind::UnrecognizedElement, element, parser.stateElement().c_str());
 }
 
 void endElYafaRayContainer(XmlParser &parser, const char *element)
 {
 	if(strcmp(element, "yafaray_container") == 0)
 	{
+		parser.joinSceneWorkers();
+		if(parser.getProgressiveLoader()) parser.getProgressiveLoader()->buildObjects(parser, true);
 		parser.popState();
 	}
 }
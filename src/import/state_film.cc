@@ -19,6 +19,7 @@
  */
 
 #include "import/import_xml.h"
+#include "import/film_region.h"
 #include <cstring>
 
 namespace yafaray_xml
@@ -34,7 +35,7 @@ void startElFilm(XmlParser &parser, const char *element, const char **attrs)
 	{
 		parser.pushState(startElParamMap, endElParamMap, element, attrs);
 	}
-	else yafaray_printWarning(parser.getLogger(), ("XMLParser: Skipping unrecognized element '" + std::string(element) + "'").c_str());
+	else parser.addWarning(Diagnostics::Kind::UnrecognizedElement, element, parser.stateElement().c_str());
 }
 
 void endElFilm(XmlParser &parser, const char *element)
@@ -47,15 +48,19 @@ void endElFilm(XmlParser &parser, const char *element)
 
 void startElFilmParameters(XmlParser &parser, const char *element, const char **attrs)
 {
-	parseParam(parser.getParamMap(), attrs, element);
+	if(parser.getFilmRegion()) parser.getFilmRegion()->readFilmParameter(element, attrs);
+	parseParam(parser, attrs, element);
 }
 
 void endElFilmParameters(XmlParser &parser, const char *element)
 {
 	if(strcmp(element, "parameters") == 0)
 	{
-		parser.createFilm(parser.stateElementName().c_str());
+		const std::string element_name{parser.stateElementName()};
+		if(parser.getFilmRegion() && !parser.getFilmRegion()->applyToFilm(parser.getParamMap())) yafaray_printWarning(parser.getLogger(), ("XMLParser: The film '" + element_name + "' has no height parameter, rendering all of it instead of a region").c_str());
+		parser.createFilm(element_name.c_str());
 		parser.popState();
+		parser.setStateElementName(element_name); //So the film state is named too
 		parser.clearParamMap();
 		parser.clearParamMapList();
 	}
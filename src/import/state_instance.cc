@@ -19,6 +19,9 @@
  */
 
 #include "import/import_xml.h"
+#include "common/matrix4.h"
+#include "common/string_to_number.h"
+#include "common/compact_geometry.h"
 #include <cstring>
 
 namespace yafaray_xml
@@ -36,9 +39,7 @@ void startElInstance(XmlParser &parser, const char *element, const char **attrs)
 				object_name = attrs[n + 1];
 			}
 		}
-		size_t object_id;
-		yafaray_getObjectId(parser.getScene(), &object_id, object_name.c_str());
-		yafaray_addInstanceObject(parser.getScene(), parser.getInstanceIdCurrent(), object_id);
+		parser.addObjectToInstance(parser.getInstanceIdCurrent(), object_name.c_str());
 	}
 	else if(!strcmp(element, "instance_ref"))
 	{
@@ -47,7 +48,7 @@ void startElInstance(XmlParser &parser, const char *element, const char **attrs)
 		{
 			if(!strcmp(attrs[n], "id"))
 			{
-				base_instance_id = atoi(attrs[n + 1]);
+				base_instance_id = string_to_number::toInt(attrs[n + 1]);
 			}
 		}
 		yafaray_addInstanceOfInstance(parser.getScene(), parser.getInstanceIdCurrent(), base_instance_id);
@@ -55,21 +56,38 @@ void startElInstance(XmlParser &parser, const char *element, const char **attrs)
 	else if(!strcmp(element, "matrix"))
 	{
 		float time{0.f};
-		double m[4 * 4];
+		Matrix4 matrix;
 		for(int n = 0; attrs[n]; ++n)
 		{
 			if(attrs[n][0] == 't')
 			{
-				time = static_cast<float>(atof(attrs[n + 1]));
+				time = string_to_number::toFloat(attrs[n + 1]);
 			}
 			if(attrs[n][3] == '\0' && attrs[n][0] == 'm' && attrs[n][1] >= '0' && attrs[n][1] <= '3' && attrs[n][2] >= '0' && attrs[n][2] <= '3') //"mij" where i and j are between 0 and 3 (inclusive)
 			{
 				const int i = attrs[n][1] - '0';
 				const int j = attrs[n][2] - '0';
-				m[4 * i + j] = atof(attrs[n + 1]);
+				matrix.m_[i][j] = string_to_number::toDouble(attrs[n + 1]);
 			}
 		}
-		yafaray_addInstanceMatrixArray(parser.getScene(), parser.getInstanceIdCurrent(), m, time);
+		yafaray_addInstanceMatrixArray(parser.getScene(), parser.getInstanceIdCurrent(), matrix.data(), time);
+	}
+}
+
+void addInstancesBlock(XmlParser &parser, const char **attrs)
+{
+	const compact_geometry::Block block{compact_geometry::parseBlock(attrs)};
+	std::pmr::vector<double> values{parser.getMemoryResource()};
+	if(!block.object_ || !compact_geometry::decodeValues(block, parser.getDocumentDirectory(), values) || values.size() != block.count_ * compact_geometry::values_per_instance)
+	{
+		yafaray_printError(parser.getLogger(), "XMLParser: Skipping malformed or unreadable compact 'instances' block");
+		return;
+	}
+	for(size_t position = 0; position < values.size(); position += compact_geometry::values_per_instance)
+	{
+		const size_t instance_id = yafaray_createInstance(parser.getScene());
+		parser.addObjectToInstance(instance_id, block.object_);
+		yafaray_addInstanceMatrixArray(parser.getScene(), instance_id, &values[position], block.time_);
 	}
 }
 
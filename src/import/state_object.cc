@@ -19,14 +19,25 @@
  */
 
 #include "import/import_xml.h"
+#include "import/geometry_deduplicator.h"
+#include "import/trace_recorder.h"
+#include "common/matrix4.h"
 #include "common/vec3f.h"
+#include "common/string_to_number.h"
+#include "common/compact_geometry.h"
+#include <cstdint>
 #include <cstring>
 
 namespace yafaray_xml
 {
 
-static void parsePoint(yafaray_Logger *yafaray_logger, const char **attrs, Vec3f &p, Vec3f &op, int &time_step, bool &has_orco);
-static bool parseNormal(yafaray_Logger *yafaray_logger, const char **attrs, Vec3f &n, int &time_step);
+static void parsePoint(XmlParser &parser, const char **attrs, Vec3f &p, Vec3f &op, int &time_step, bool &has_orco);
+static bool parseNormal(XmlParser &parser, const char **attrs, Vec3f &n, int &time_step);
+static void parseFace(XmlParser &parser, const char **attrs);
+static void parseIndexedFace(XmlParser &parser, const char **attrs);
+static void addFace(XmlParser &parser, const int *vertices_indices, const int *uv_indices, size_t number_of_vertices);
+static void addStrip(XmlParser &parser, const char **attrs);
+static void addCompactGeometry(XmlParser &parser, const char *element, const char **attrs);
 
 void startElObject(XmlParser &parser, const char *element, const char **attrs)
 {
@@ -36,7 +47,8 @@ void startElObject(XmlParser &parser, const char *element, const char **attrs)
 		Vec3f op{0.f, 0.f, 0.f};
 		int time_step = 0;
 		bool has_orco = false;
-		parsePoint(parser.getLogger(), attrs, p, op, time_step, has_orco);
+		parsePoint(parser, attrs, p, op, time_step, has_orco);
+		if(time_step == 0) parser.getPolygonTriangulator().addPoint(p);
 		if(has_orco) yafaray_addVertexWithOrcoTimeStep(parser.getScene(), parser.getObjectIdCurrent(), p.x_, p.y_, p.z_, op.x_, op.y_, op.z_, time_step);
 		else yafaray_addVertexTimeStep(parser.getScene(), parser.getObjectIdCurrent(), p.x_, p.y_, p.z_, time_step);
 	}
@@ -44,40 +56,16 @@ void startElObject(XmlParser &parser, const char *element, const char **attrs)
 	{
 		Vec3f n(0.0, 0.0, 0.0);
 		int time_step = 0;
-		if(!parseNormal(parser.getLogger(), attrs, n, time_step)) return;
+		if(!parseNormal(parser, attrs, n, time_step)) return;
 		yafaray_addNormalTimeStep(parser.getScene(), parser.getObjectIdCurrent(), n.x_, n.y_, n.z_, time_step);
 	}
 	else if(!strcmp(element, "f"))
 	{
-		std::vector<int> vertices_indices, uv_indices;
-		vertices_indices.reserve(4);
-		uv_indices.reserve(4);
-		for(; attrs && attrs[0]; attrs += 2)
-		{
-			const std::string attribute = attrs[0];
-			if(attribute.size() == 1) switch(attribute[0])
-				{
-					case 'a' :
-					case 'b' :
-					case 'c' :
-					case 'd' : vertices_indices.push_back(atoi(attrs[1])); break;
-					default: yafaray_printWarning(parser.getLogger(), ("XMLParser: Ignored wrong attribute '" + attribute + "' in face").c_str());
-				}
-			else
-			{
-				if(attribute.substr(0, 3) == "uv_") uv_indices.push_back(atoi(attrs[1]));
-			}
-		}
-		if(vertices_indices.size() == 3)
-		{
-			if(uv_indices.empty()) yafaray_addTriangle(parser.getScene(), parser.getObjectIdCurrent(), vertices_indices[0], vertices_indices[1], vertices_indices[2], parser.getMaterialIdCurrent());
-			else yafaray_addTriangleWithUv(parser.getScene(), parser.getObjectIdCurrent(), vertices_indices[0], vertices_indices[1], vertices_indices[2], uv_indices[0], uv_indices[1], uv_indices[2], parser.getMaterialIdCurrent());
-		}
-		else if(vertices_indices.size() == 4)
-		{
-			if(uv_indices.empty()) yafaray_addQuad(parser.getScene(), parser.getObjectIdCurrent(), vertices_indices[0], vertices_indices[1], vertices_indices[2], vertices_indices[3], parser.getMaterialIdCurrent());
-			else yafaray_addQuadWithUv(parser.getScene(), parser.getObjectIdCurrent(), vertices_indices[0], vertices_indices[1], vertices_indices[2], vertices_indices[3], uv_indices[0], uv_indices[1], uv_indices[2], uv_indices[3], parser.getMaterialIdCurrent());
-		}
+		parseFace(parser, attrs);
+	}
+	else if(!strcmp(element, "strip"))
+	{
+		addStrip(parser, attrs);
 	}
 	else if(!strcmp(element, "uv"))
 	{
@@ -86,14 +74,14 @@ void startElObject(XmlParser &parser, const char *element, const char **attrs)
 		{
 			switch(attrs[0][0])
 			{
-				case 'u': u = static_cast<float>(atof(attrs[1]));
+				case 'u': u = string_to_number::toFloat(attrs[1]);
 					/*if(!(isValid(u)))
 					{
 						std::cout << std::scientific << std::setprecision(6) << "XMLParser: invalid value in \"" << element << "\" xml entry: " << attrs[0] << "=" << attrs[1] << ". Replacing with 0.0." << std::endl;
 						u = 0.f;
 					}*/
 					break;
-				case 'v': v = static_cast<float>(atof(attrs[1]));
+				case 'v': v = string_to_number::toFloat(attrs[1]);
 					/*	if(!(math::isValid(v)))
 						{
 							std::cout << std::scientific << std::setprecision(6) << "XMLParser: invalid value in \"" << element << "\" xml entry: " << attrs[0] << "=" << attrs[1] << ". Replacing with 0.0." << std::endl;
@@ -101,15 +89,19 @@ void startElObject(XmlParser &parser, const char *element, const char **attrs)
 						}*/
 					break;
 
-				default: yafaray_printWarning(parser.getLogger(), ("XMLParser: Ignored wrong attribute '" + std::string(attrs[0]) + "' in uv").c_str());
+				default: parser.addWarning(Diagnostics::Kind::WrongAttribute, "uv", attrs[0]);
 			}
 		}
 		yafaray_addUv(parser.getScene(), parser.getObjectIdCurrent(), u, v);
 	}
+	else if(!strcmp(element, "points") || !strcmp(element, "normals") || !strcmp(element, "uvs") || !strcmp(element, "faces"))
+	{
+		addCompactGeometry(parser, element, attrs);
+	}
 	else if(!strcmp(element, "material_ref"))
 	{
 		size_t material_id;
-		yafaray_getMaterialId(parser.getScene(), &material_id, attrs[1]);
+		yafaray_getMaterialId(parser.getScene(), &material_id, parser.resolveNameAlias(attrs[1]));
 		parser.setMaterialIdCurrent(material_id);
 	}
 	else if(!strcmp(element, "smooth"))
@@ -117,8 +109,9 @@ void startElObject(XmlParser &parser, const char *element, const char **attrs)
 		double angle = 181.0;
 		for(int n = 0; attrs[n]; ++n)
 		{
-			if(!strcmp(attrs[n], "angle")) angle = atof(attrs[n + 1]);
+			if(!strcmp(attrs[n], "angle")) angle = string_to_number::toDouble(attrs[n + 1]);
 		}
+		const TraceScope trace_scope{parser.getTraceRecorder(), "libyafaray", "yafaray_smoothObjectMesh", parser.stateElementName()};
 		bool success = yafaray_smoothObjectMesh(parser.getScene(), parser.getObjectIdCurrent(), angle);
 		if(!success) yafaray_printWarning(parser.getLogger(), ("XMLParser: Couldn't smooth object with angle = " + std::to_string(angle)).c_str());
 	}
@@ -132,30 +125,74 @@ void endElObject(XmlParser &parser, const char *element)
 {
 	if(!strcmp(element, "object"))
 	{
-		yafaray_initObject(parser.getScene(), parser.getObjectIdCurrent(), parser.getMaterialIdCurrent());
+		{
+			const TraceScope trace_scope{parser.getTraceRecorder(), "libyafaray", "yafaray_initObject", parser.stateElementName()};
+			yafaray_initObject(parser.getScene(), parser.getObjectIdCurrent(), parser.getMaterialIdCurrent());
+		}
 		parser.popState();
 	}
 }
 
+void startElObjectRecording(XmlParser &parser, const char *element, const char **attrs)
+{
+	parser.getGeometryDeduplicator()->recordStartElement(element, attrs, parser.getDocumentDirectory());
+}
+
+void endElObjectRecording(XmlParser &parser, const char *element)
+{
+	GeometryDeduplicator *geometry_deduplicator = parser.getGeometryDeduplicator();
+	if(parser.currLevel() != parser.stateLevel())
+	{
+		geometry_deduplicator->recordEndElement(element);
+		return;
+	}
+	parser.setStateElementName(geometry_deduplicator->getRecordedObjectName());
+	parser.popState();
+	GeometryDeduplicator::Duplicate duplicate;
+	if(geometry_deduplicator->findDuplicate(duplicate))
+	{
+		size_t object_id;
+		yafaray_getObjectId(parser.getScene(), &object_id, duplicate.object_name_.c_str());
+		const size_t instance_id = yafaray_createInstance(parser.getScene());
+		yafaray_addInstanceObject(parser.getScene(), instance_id, object_id);
+		Matrix4 matrix;
+		for(int axis = 0; axis < 3; ++axis) matrix.m_[axis][3] = duplicate.translation_[axis];
+		yafaray_addInstanceMatrixArray(parser.getScene(), instance_id, matrix.data(), 0.f);
+		geometry_deduplicator->setObjectInstance(geometry_deduplicator->getRecordedObjectName(), instance_id);
+		yafaray_printVerbose(parser.getLogger(), ("XMLParser: Object '" + geometry_deduplicator->getRecordedObjectName() + "' has the same geometry as object '" + duplicate.object_name_ + "', adding it as an instance").c_str());
+		return;
+	}
+	//A new geometry: the recorded elements are created as an ordinary object
+	parser.pushState(startElObject, endElObject, element, nullptr);
+	geometry_deduplicator->getRecordedElements().replay(parser);
+	endElObject(parser, element);
+}
+
 void startElObjectParameters(XmlParser &parser, const char *element, const char **attrs)
 {
-	parseParam(parser.getParamMap(), attrs, element);
+	parseParam(parser, attrs, element);
 }
 
 void endElObjectParameters(XmlParser &parser, const char *element)
 {
 	if(strcmp(element, "parameters") == 0)
 	{
+		const std::string element_name{parser.stateElementName()};
 		size_t object_id;
-		yafaray_createObject(parser.getScene(), &object_id, parser.stateElementName().c_str(), parser.getParamMap());
+		{
+			const TraceScope trace_scope{parser.getTraceRecorder(), "libyafaray", "yafaray_createObject", element_name};
+			yafaray_createObject(parser.getScene(), &object_id, element_name.c_str(), parser.getParamMap());
+		}
 		parser.setObjectIdCurrent(object_id);
+		parser.getPolygonTriangulator().clearPoints();
 		parser.popState();
+		parser.setStateElementName(element_name); //So the object state is named too
 		parser.clearParamMap();
 		parser.clearParamMapList();
 	}
 }
 
-static void parsePoint(yafaray_Logger *yafaray_logger, const char **attrs, Vec3f &p, Vec3f &op, int &time_step, bool &has_orco)
+static void parsePoint(XmlParser &parser, const char **attrs, Vec3f &p, Vec3f &op, int &time_step, bool &has_orco)
 {
 	for(; attrs && attrs[0]; attrs += 2)
 	{
@@ -164,54 +201,245 @@ static void parsePoint(yafaray_Logger *yafaray_logger, const char **attrs, Vec3f
 			has_orco = true;
 			if(attrs[0][1] == 0 || attrs[0][2] != 0)
 			{
-				yafaray_printWarning(yafaray_logger, ("XMLParser: Ignored wrong attribute " + std::string(attrs[0]) + " in orco point (1)").c_str());
+				parser.addWarning(Diagnostics::Kind::WrongAttribute, "orco point", attrs[0]);
 				continue; //it is not a single character
 			}
 			switch(attrs[0][1])
 			{
-				case 'x' : op.x_ = static_cast<float>(atof(attrs[1])); break;
-				case 'y' : op.y_ = static_cast<float>(atof(attrs[1])); break;
-				case 'z' : op.z_ = static_cast<float>(atof(attrs[1])); break;
-				default: yafaray_printWarning(yafaray_logger, ("XMLParser: Ignored wrong attribute " + std::string(attrs[0]) + " in orco point (2)").c_str());
+				case 'x' : op.x_ = string_to_number::toFloat(attrs[1]); break;
+				case 'y' : op.y_ = string_to_number::toFloat(attrs[1]); break;
+				case 'z' : op.z_ = string_to_number::toFloat(attrs[1]); break;
+				default: parser.addWarning(Diagnostics::Kind::WrongAttribute, "orco point", attrs[0]);
 			}
 			continue;
 		}
 		else if(attrs[0][1] != 0)
 		{
-			yafaray_printWarning(yafaray_logger, ("XMLParser: Ignored wrong attribute " + std::string(attrs[0]) + " in point").c_str());
+			parser.addWarning(Diagnostics::Kind::WrongAttribute, "point", attrs[0]);
 			continue; //it is not a single character
 		}
 		switch(attrs[0][0])
 		{
-			case 'x' : p.x_ = static_cast<float>(atof(attrs[1])); break;
-			case 'y' : p.y_ = static_cast<float>(atof(attrs[1])); break;
-			case 'z' : p.z_ = static_cast<float>(atof(attrs[1])); break;
-			case 's' : time_step = atoi(attrs[1]); break;
-			default: yafaray_printWarning(yafaray_logger, ("XMLParser: Ignored wrong attribute " + std::string(attrs[0]) + " in point").c_str());
+			case 'x' : p.x_ = string_to_number::toFloat(attrs[1]); break;
+			case 'y' : p.y_ = string_to_number::toFloat(attrs[1]); break;
+			case 'z' : p.z_ = string_to_number::toFloat(attrs[1]); break;
+			case 's' : time_step = string_to_number::toInt(attrs[1]); break;
+			default: parser.addWarning(Diagnostics::Kind::WrongAttribute, "point", attrs[0]);
 		}
 	}
 }
 
-static bool parseNormal(yafaray_Logger *yafaray_logger, const char **attrs, Vec3f &n, int &time_step)
+static bool parseNormal(XmlParser &parser, const char **attrs, Vec3f &n, int &time_step)
 {
 	int number_of_components_read = 0;
 	for(; attrs && attrs[0]; attrs += 2)
 	{
 		if(attrs[0][1] != 0)
 		{
-			yafaray_printWarning(yafaray_logger, ("XMLParser: Ignored wrong attribute " + std::string(attrs[0]) + " in normal").c_str());
+			parser.addWarning(Diagnostics::Kind::WrongAttribute, "normal", attrs[0]);
 			continue; //it is not a single character
 		}
 		switch(attrs[0][0])
 		{
-			case 'x' : n.x_ = static_cast<float>(atof(attrs[1])); ++number_of_components_read; break;
-			case 'y' : n.y_ = static_cast<float>(atof(attrs[1])); ++number_of_components_read; break;
-			case 'z' : n.z_ = static_cast<float>(atof(attrs[1])); ++number_of_components_read; break;
-			case 's' : time_step = atoi(attrs[1]); ++number_of_components_read; break;
-			default: yafaray_printWarning(yafaray_logger, ("XMLParser: Ignored wrong attribute " + std::string(attrs[0]) + " in normal").c_str());
+			case 'x' : n.x_ = string_to_number::toFloat(attrs[1]); ++number_of_components_read; break;
+			case 'y' : n.y_ = string_to_number::toFloat(attrs[1]); ++number_of_components_read; break;
+			case 'z' : n.z_ = string_to_number::toFloat(attrs[1]); ++number_of_components_read; break;
+			case 's' : time_step = string_to_number::toInt(attrs[1]); ++number_of_components_read; break;
+			default: parser.addWarning(Diagnostics::Kind::WrongAttribute, "normal", attrs[0]);
 		}
 	}
 	return (number_of_components_read == 3 || number_of_components_read == 4);
 }
 
+static void parseFace(XmlParser &parser, const char **attrs)
+{
+	//Corners are named with letters from 'a' to 'z', with uv indices in the "uv_" attributes named with the same letters, so these faces have at most 26 corners. Larger faces list their corners in the "indices" attribute instead
+	for(const char **attribute = attrs; attribute && attribute[0]; attribute += 2)
+	{
+		if(!strcmp(attribute[0], "indices")) return parseIndexedFace(parser, attrs);
+	}
+	constexpr size_t max_face_vertices = 'z' - 'a' + 1;
+	int vertices_indices[max_face_vertices];
+	int uv_indices[max_face_vertices];
+	uint32_t vertices_read = 0, uvs_read = 0; //One bit per corner letter
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		const bool is_uv = !strncmp(attrs[0], "uv_", 3);
+		const char *corner_name = is_uv ? attrs[0] + 3 : attrs[0];
+		if(corner_name[0] < 'a' || corner_name[0] > 'z' || corner_name[1] != 0)
+		{
+			parser.addWarning(Diagnostics::Kind::WrongAttribute, "face", attrs[0]);
+			continue;
+		}
+		const int corner = corner_name[0] - 'a';
+		if(is_uv)
+		{
+			uv_indices[corner] = string_to_number::toInt(attrs[1]);
+			uvs_read |= 1u << corner;
+		}
+		else
+		{
+			vertices_indices[corner] = string_to_number::toInt(attrs[1]);
+			vertices_read |= 1u << corner;
+		}
+	}
+	if(uvs_read != 0 && uvs_read != vertices_read)
+	{
+		parser.addWarning(Diagnostics::Kind::WrongAttribute, "face", "uv_");
+		uvs_read = 0;
+	}
+	//Corners in letter order, skipping the letters not used
+	size_t number_of_vertices = 0;
+	for(size_t corner = 0; corner < max_face_vertices; ++corner)
+	{
+		if(!(vertices_read & (1u << corner))) continue;
+		vertices_indices[number_of_vertices] = vertices_indices[corner];
+		uv_indices[number_of_vertices] = uv_indices[corner];
+		++number_of_vertices;
+	}
+	addFace(parser, vertices_indices, uvs_read ? uv_indices : nullptr, number_of_vertices);
+}
+
+static void parseIndexedFace(XmlParser &parser, const char **attrs)
+{
+	//<f indices="i0 i1 i2 ..." [uv_indices="..."]/> for faces with any number of corners
+	const char *indices = nullptr;
+	const char *uv_indices = nullptr;
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		if(!strcmp(attrs[0], "indices")) indices = attrs[1];
+		else if(!strcmp(attrs[0], "uv_indices")) uv_indices = attrs[1];
+		else parser.addWarning(Diagnostics::Kind::WrongAttribute, "face", attrs[0]);
+	}
+	std::vector<int> &vertices_indices{parser.getPolygonTriangulator().getFaceVerticesIndices()};
+	std::vector<int> &uvs_indices{parser.getPolygonTriangulator().getFaceUvIndices()};
+	if(!string_to_number::readAll(indices, vertices_indices) || (uv_indices && (!string_to_number::readAll(uv_indices, uvs_indices) || uvs_indices.size() != vertices_indices.size())))
+	{
+		yafaray_printError(parser.getLogger(), "XMLParser: Skipping malformed 'f' element, its indices or uv_indices are not valid integers or their numbers do not match");
+		return;
+	}
+	addFace(parser, vertices_indices.data(), uv_indices ? uvs_indices.data() : nullptr, vertices_indices.size());
+}
+
+static void addFace(XmlParser &parser, const int *vertices_indices, const int *uv_indices, size_t number_of_vertices)
+{
+	if(number_of_vertices == 3)
+	{
+		if(!uv_indices) yafaray_addTriangle(parser.getScene(), parser.getObjectIdCurrent(), vertices_indices[0], vertices_indices[1], vertices_indices[2], parser.getMaterialIdCurrent());
+		else yafaray_addTriangleWithUv(parser.getScene(), parser.getObjectIdCurrent(), vertices_indices[0], vertices_indices[1], vertices_indices[2], uv_indices[0], uv_indices[1], uv_indices[2], parser.getMaterialIdCurrent());
+	}
+	else if(number_of_vertices == 4)
+	{
+		if(!uv_indices) yafaray_addQuad(parser.getScene(), parser.getObjectIdCurrent(), vertices_indices[0], vertices_indices[1], vertices_indices[2], vertices_indices[3], parser.getMaterialIdCurrent());
+		else yafaray_addQuadWithUv(parser.getScene(), parser.getObjectIdCurrent(), vertices_indices[0], vertices_indices[1], vertices_indices[2], vertices_indices[3], uv_indices[0], uv_indices[1], uv_indices[2], uv_indices[3], parser.getMaterialIdCurrent());
+	}
+	else if(number_of_vertices > 4)
+	{
+		for(const auto &triangle : parser.getPolygonTriangulator().triangulate(vertices_indices, number_of_vertices))
+		{
+			const int triangle_vertices[3] = {vertices_indices[triangle[0]], vertices_indices[triangle[1]], vertices_indices[triangle[2]]};
+			if(!uv_indices) addFace(parser, triangle_vertices, nullptr, 3);
+			else
+			{
+				const int triangle_uvs[3] = {uv_indices[triangle[0]], uv_indices[triangle[1]], uv_indices[triangle[2]]};
+				addFace(parser, triangle_vertices, triangle_uvs, 3);
+			}
+		}
+	}
+}
+
+static void addStrip(XmlParser &parser, const char **attrs)
+{
+	//Triangle strip: every vertex after the first two makes a triangle with the previous two, alternating the winding so all the triangles keep the orientation of the first one
+	const char *vertices = nullptr;
+	const char *uvs = nullptr;
+	for(; attrs && attrs[0]; attrs += 2)
+	{
+		if(!strcmp(attrs[0], "v")) vertices = attrs[1];
+		else if(!strcmp(attrs[0], "uv")) uvs = attrs[1];
+		else parser.addWarning(Diagnostics::Kind::WrongAttribute, "strip", attrs[0]);
+	}
+	if(!vertices) return;
+	const char *vertices_end = vertices + std::strlen(vertices);
+	const char *uvs_end = uvs ? uvs + std::strlen(uvs) : nullptr;
+	int strip_vertices[3] = {}, strip_uvs[3] = {};
+	size_t number_of_vertices = 0;
+	int vertex_index, uv_index = 0;
+	while(const char *vertex_end = string_to_number::readNext(vertices, vertices_end, vertex_index))
+	{
+		if(uvs)
+		{
+			const char *uv_end = string_to_number::readNext(uvs, uvs_end, uv_index);
+			if(!uv_end) break;
+			uvs = uv_end;
+		}
+		vertices = vertex_end;
+		strip_vertices[0] = strip_vertices[1]; strip_vertices[1] = strip_vertices[2]; strip_vertices[2] = vertex_index;
+		strip_uvs[0] = strip_uvs[1]; strip_uvs[1] = strip_uvs[2]; strip_uvs[2] = uv_index;
+		if(++number_of_vertices < 3) continue;
+		if(strip_vertices[0] == strip_vertices[1] || strip_vertices[1] == strip_vertices[2] || strip_vertices[0] == strip_vertices[2]) continue; //Degenerate triangles join separate strips
+		const bool swap_winding = (number_of_vertices % 2) == 0;
+		const int triangle_vertices[3] = {strip_vertices[swap_winding ? 1 : 0], strip_vertices[swap_winding ? 0 : 1], strip_vertices[2]};
+		const int triangle_uvs[3] = {strip_uvs[swap_winding ? 1 : 0], strip_uvs[swap_winding ? 0 : 1], strip_uvs[2]};
+		addFace(parser, triangle_vertices, uvs ? triangle_uvs : nullptr, 3);
+	}
+	const auto is_blank = [](const char *string, const char *string_end) {
+		while(string < string_end && (*string == ' ' || *string == '\t' || *string == '\n' || *string == '\r')) ++string;
+		return string == string_end;
+	};
+	if(!is_blank(vertices, vertices_end) || (uvs && !is_blank(uvs, uvs_end))) yafaray_printError(parser.getLogger(), "XMLParser: Skipping the rest of malformed 'strip' element, its vertices or uvs are not valid integers or their numbers do not match");
+}
+
+static void addCompactGeometry(XmlParser &parser, const char *element, const char **attrs)
+{
+	const compact_geometry::Block block{compact_geometry::parseBlock(attrs)};
+	bool values_ok;
+	if(!strcmp(element, "faces"))
+	{
+		std::pmr::vector<int> values{parser.getMemoryResource()};
+		values_ok = compact_geometry::decodeValues(block, parser.getDocumentDirectory(), values) && compact_geometry::checkFaces(block, values);
+		for(size_t position = 0; values_ok && position < values.size();)
+		{
+			const auto number_of_vertices = static_cast<size_t>(values[position]);
+			const int *vertices_indices = &values[position + 1];
+			addFace(parser, vertices_indices, block.uv_ ? vertices_indices + number_of_vertices : nullptr, number_of_vertices);
+			position += 1 + number_of_vertices * (block.uv_ ? 2 : 1);
+		}
+	}
+	else
+	{
+		size_t values_per_item;
+		if(!strcmp(element, "points")) values_per_item = compact_geometry::valuesPerPoint(block);
+		else if(!strcmp(element, "normals")) values_per_item = 3;
+		else values_per_item = 2;
+		std::pmr::vector<float> values{parser.getMemoryResource()};
+		values_ok = compact_geometry::decodeFloatValues(block, parser.getDocumentDirectory(), values_per_item, values) && values.size() == block.count_ * values_per_item;
+		if(!strcmp(element, "points"))
+		{
+			for(size_t position = 0; values_ok && position < values.size(); position += values_per_item)
+			{
+				const float *p = &values[position];
+				if(block.time_step_ == 0) parser.getPolygonTriangulator().addPoint(Vec3f{p[0], p[1], p[2]});
+				if(block.orco_) yafaray_addVertexWithOrcoTimeStep(parser.getScene(), parser.getObjectIdCurrent(), p[0], p[1], p[2], p[3], p[4], p[5], block.time_step_);
+				else yafaray_addVertexTimeStep(parser.getScene(), parser.getObjectIdCurrent(), p[0], p[1], p[2], block.time_step_);
+			}
+		}
+		else if(!strcmp(element, "normals"))
+		{
+			for(size_t position = 0; values_ok && position < values.size(); position += 3)
+			{
+				yafaray_addNormalTimeStep(parser.getScene(), parser.getObjectIdCurrent(), values[position], values[position + 1], values[position + 2], block.time_step_);
+			}
+		}
+		else
+		{
+			for(size_t position = 0; values_ok && position < values.size(); position += 2)
+			{
+				yafaray_addUv(parser.getScene(), parser.getObjectIdCurrent(), values[position], values[position + 1]);
+			}
+		}
+	}
+	if(!values_ok) yafaray_printError(parser.getLogger(), ("XMLParser: Skipping malformed or unreadable compact '" + std::string(element) + "' block").c_str());
+}
+
 } //namespace yafaray_xml
\ No newline at end of file
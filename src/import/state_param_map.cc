@@ -19,6 +19,9 @@
  */
 
 #include "import/import_xml.h"
+#include "import/trace_recorder.h"
+#include "import/film_region.h"
+#include "import/param_overrides.h"
 #include <cstring>
 
 namespace yafaray_xml
@@ -28,10 +31,78 @@ void startElParamMap(XmlParser &parser, const char *element, const char **attrs)
 {
 	if(!strcmp(element, "shader_node"))
 	{
+		parser.appendParamMapFingerprint(element, attrs);
 		parser.pushState(startElShaderNode, endElShaderNode, element, attrs);
 		return;
 	}
-	parseParam(parser.getParamMap(), attrs, element);
+	else if(!strcmp(element, "filename") && parser.stateElement() == "image") parser.prefetchImageFile(attrs);
+	else if(!strcmp(element, "object_name") && parser.stateElement() == "light") parser.addLightObject(attrs);
+	else if(parser.getFilmRegion() && parser.stateElement() == "output")
+	{
+		if(!strcmp(element, "image_path") && attrs && attrs[0] && !strcmp(attrs[0], "sval"))
+		{
+			//The outputs of a film region write partial TGA images to be merged afterwards, named after the image path once overridden
+			const char *image_path{attrs[1]};
+			ParamOverrides *param_overrides{parser.getParamOverrides()};
+			const size_t override_index{param_overrides ? param_overrides->find(parser, element) : ParamOverrides::npos};
+			if(override_index != ParamOverrides::npos)
+			{
+				image_path = param_overrides->getValue(override_index).c_str();
+				param_overrides->countApplied(override_index, true);
+			}
+			const std::string partial_image_path{parser.getFilmRegion()->addOutput(image_path)};
+			if(partial_image_path.empty()) yafaray_printError(parser.getLogger(), ("XMLParser: The output image '" + std::string{image_path} + "' is not a TGA image, only TGA outputs can be rendered by regions and merged").c_str());
+			else
+			{
+				const char *partial_image_path_attrs[]{"sval", partial_image_path.c_str(), nullptr};
+				parseParam(parser, partial_image_path_attrs, element, false);
+			}
+			return;
+		}
+		//A badge or denoising applied to each strip would not match the whole image
+		else if(!strcmp(element, "badge_position"))
+		{
+			const char *no_badge_attrs[]{"sval", "none", nullptr};
+			parseParam(parser, no_badge_attrs, element, false);
+			return;
+		}
+		else if(!strcmp(element, "denoise_enabled"))
+		{
+			const char *no_denoise_attrs[]{"bval", "false", nullptr};
+			parseParam(parser, no_denoise_attrs, element, false);
+			return;
+		}
+	}
+	parseParam(parser, attrs, element);
+}
+
+static const char *creationFunctionName(const char *element)
+{
+	if(!strcmp(element, "material")) return "yafaray_createMaterial";
+	else if(!strcmp(element, "volume_integrator")) return "yafaray_defineVolumeIntegrator";
+	else if(!strcmp(element, "light")) return "yafaray_createLight";
+	else if(!strcmp(element, "image")) return "yafaray_createImage";
+	else if(!strcmp(element, "texture")) return "yafaray_createTexture";
+	else if(!strcmp(element, "camera")) return "yafaray_defineCamera";
+	else if(!strcmp(element, "accelerator")) return "yafaray_setSceneAcceleratorParams";
+	else if(!strcmp(element, "background")) return "yafaray_defineBackground";
+	else if(!strcmp(element, "volume_region")) return "yafaray_createVolumeRegion";
+	else if(!strcmp(element, "layer")) return "yafaray_defineLayer";
+	else if(!strcmp(element, "output")) return "yafaray_createOutput";
+	else return element;
+}
+
+static bool deduplicateElement(XmlParser &parser, const char *element, const std::string &element_name)
+{
+	const std::string duplicated_element_name{parser.findDuplicateElement(element)};
+	if(duplicated_element_name.empty())
+	{
+		parser.registerElementFingerprint(element, element_name);
+		return false;
+	}
+	yafaray_printVerbose(parser.getLogger(), ("XMLParser: " + std::string(element) + " '" + element_name + "' has the same parameters as '" + duplicated_element_name + "', reusing it instead of creating a new one").c_str());
+	parser.addNameAlias(element_name, duplicated_element_name);
+	return true;
 }
 
 void endElParamMap(XmlParser &parser, const char *element)
@@ -40,13 +111,23 @@ void endElParamMap(XmlParser &parser, const char *element)
 	const bool exit_state = (parser.currLevel() == parser.stateLevel());
 	if(exit_state)
 	{
-		const std::string element_name = parser.stateElementName();
+		const std::string &element_name = parser.stateElementName();
 		if(element_name.empty() && strcmp(element, "background") != 0 && strcmp(element, "volume_integrator") != 0 && strcmp(element, "layer") != 0 && strcmp(element, "accelerator") != 0 && strcmp(element, "camera") != 0)
 		{
 			yafaray_printWarning(parser.getLogger(), ("XMLParser: No name for element '" + std::string(element) + "' available!").c_str());
 		}
+		else if(parser.isFingerprintingElement() && deduplicateElement(parser, element, element_name))
+		{
+			if(!strcmp(element, "material"))
+			{
+				size_t material_id;
+				yafaray_getMaterialId(parser.getScene(), &material_id, parser.resolveNameAlias(element_name.c_str()));
+				parser.setMaterialIdCurrent(material_id);
+			}
+		}
 		else
 		{
+			const TraceScope trace_scope{parser.getTraceRecorder(), "libyafaray", parser.getTraceRecorder() ? creationFunctionName(element) : element, element_name};
 			if(!strcmp(element, "material"))
 			{
 				size_t material_id;
@@ -58,7 +139,11 @@ void endElParamMap(XmlParser &parser, const char *element)
 			else if(!strcmp(element, "image"))
 				yafaray_createImage(parser.getScene(), element_name.c_str(), nullptr, parser.getParamMap());
 			else if(!strcmp(element, "texture")) yafaray_createTexture(parser.getScene(), element_name.c_str(), parser.getParamMap());
-			else if(!strcmp(element, "camera")) yafaray_defineCamera(parser.getFilm(), parser.getParamMap());
+			else if(!strcmp(element, "camera"))
+			{
+				yafaray_defineCamera(parser.getFilm(), parser.getParamMap());
+				if(parser.getPreviewFilm()) yafaray_defineCamera(parser.getPreviewFilm(), parser.getParamMap());
+			}
 			else if(!strcmp(element, "accelerator")) yafaray_setSceneAcceleratorParams(parser.getScene(), parser.getParamMap());
 			else if(!strcmp(element, "background")) yafaray_defineBackground(parser.getScene(), parser.getParamMap());
 			else if(!strcmp(element, "volume_region")) yafaray_createVolumeRegion(parser.getScene(), element_name.c_str(), parser.getParamMap());
@@ -19,6 +19,8 @@
  */
 
 #include "import/import_xml.h"
+#include "import/geometry_deduplicator.h"
+#include "import/progressive_loader.h"
 #include <cstring>
 
 namespace yafaray_xml
@@ -32,18 +34,39 @@ void startElScene(XmlParser &parser, const char *element, const char **attrs)
 	}
 	else if(!strcmp(element, "accelerator") || !strcmp(element, "material") || !strcmp(element, "light") || !strcmp(element, "texture") || !strcmp(element, "volume_region") || !strcmp(element, "image") || !strcmp(element, "light") || !strcmp(element, "background"))
 	{
+		parser.startElementFingerprint(element);
 		parser.pushState(startElParamMap, endElParamMap, element, attrs);
 	}
+	else if((!strcmp(element, "object") || !strcmp(element, "instance") || !strcmp(element, "instances")) && parser.getProgressiveLoader() && parser.getProgressiveLoader()->isDeferringObjects())
+	{
+		ProgressiveLoader *progressive_loader = parser.getProgressiveLoader();
+		progressive_loader->startObject(parser.stateElementName());
+		progressive_loader->recordStartElement(element, attrs);
+		parser.pushState(startElDeferredObject, endElDeferredObject, element, attrs);
+	}
 	else if(!strcmp(element, "object"))
 	{
-		parser.pushState(startElObject, endElObject, element, attrs);
+		if(GeometryDeduplicator *geometry_deduplicator = parser.getGeometryDeduplicator())
+		{
+			geometry_deduplicator->startObject();
+			parser.pushState(startElObjectRecording, endElObjectRecording, element, attrs);
+		}
+		else parser.pushState(startElObject, endElObject, element, attrs);
 	}
 	else if(!strcmp(element, "instance"))
 	{
 		parser.setInstanceIdCurrent(yafaray_createInstance(parser.getScene()));
 		parser.pushState(startElInstance, endElInstance, element, attrs);
 	}
-	else yafaray_printWarning(parser.getLogger(), ("XMLParser: Skipping unrecognized element '" + std::string(element) + "'").c_str());
+	else if(!strcmp(element, "instances"))
+	{
+		addInstancesBlock(parser, attrs);
+	}
+	else if(!strcmp(element, "include"))
+	{
+		parser.includeFile(attrs);
+	}
+	else parser.addWarning(Diagnostics::Kind::UnrecognizedElement, element, parser.stateElement().c_str());
 }
 
 void endElScene(XmlParser &parser, const char *element)
@@ -54,17 +77,31 @@ void endElScene(XmlParser &parser, const char *element)
 	}
 }
 
+void startElDeferredObject(XmlParser &parser, const char *element, const char **attrs)
+{
+	parser.getProgressiveLoader()->recordStartElement(element, attrs);
+}
+
+void endElDeferredObject(XmlParser &parser, const char *element)
+{
+	parser.getProgressiveLoader()->recordEndElement(element);
+	if(parser.currLevel() == parser.stateLevel()) parser.popState();
+}
+
 void startElSceneParameters(XmlParser &parser, const char *element, const char **attrs)
 {
-	parseParam(parser.getParamMap(), attrs, element);
+	parseParam(parser, attrs, element);
 }
 
 void endElSceneParameters(XmlParser &parser, const char *element)
 {
 	if(strcmp(element, "parameters") == 0)
 	{
-		parser.createScene(parser.stateElementName().c_str());
+		const std::string element_name{parser.stateElementName()};
+		if(parser.isMergingScenes() && parser.getScene()) yafaray_printVerbose(parser.getLogger(), ("XMLParser: Merging scene '" + element_name + "' into the scene of the previous files, ignoring its parameters").c_str());
+		else parser.createScene(element_name.c_str());
 		parser.popState();
+		parser.setStateElementName(element_name); //So the scene state is named too
 		parser.clearParamMap();
 		parser.clearParamMapList();
 	}
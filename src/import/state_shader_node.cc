@@ -26,7 +26,7 @@ namespace yafaray_xml
 
 void startElShaderNode(XmlParser &parser, const char *element, const char **attrs)
 {
-	parseParam(parser.getParamMap(), attrs, element);
+	parseParam(parser, attrs, element);
 }
 
 void endElShaderNode(XmlParser &parser, const char *element)
@@ -34,7 +34,7 @@ void startElSurfaceIntegrator(XmlParser &parser, const char *element, const char
 	{
 		parser.pushState(startElParamMap, endElParamMap, element, attrs);
 	}
-	else yafaray_printWarning(parser.getLogger(), ("XMLParser: Skipping unrecognized element '" + std::string(element) + "'").c_str());
+	else parser.addWarning(Diagnostics::Kind::UnrecognizedElement, element, parser.stateElement().c_str());
 }
 
 void endElSurfaceIntegrator(XmlParser &parser, const char *element)
@@ -47,15 +47,17 @@ void endElSurfaceIntegrator(XmlParser &parser, const char *element)
 
 void startElSurfaceIntegratorParameters(XmlParser &parser, const char *element, const char **attrs)
 {
-	parseParam(parser.getParamMap(), attrs, element);
+	parseParam(parser, attrs, element);
 }
 
 void endElSurfaceIntegratorParameters(XmlParser &parser, const char *element)
 {
 	if(strcmp(element, "parameters") == 0)
 	{
-		parser.createSurfaceIntegrator(parser.stateElementName().c_str());
+		const std::string element_name{parser.stateElementName()};
+		parser.createSurfaceIntegrator(element_name.c_str());
 		parser.popState();
+		parser.setStateElementName(element_name); //So the surface integrator state is named too
 		parser.clearParamMap();
 		parser.clearParamMapList();
 	}
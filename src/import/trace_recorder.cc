@@ -0,0 +1,73 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/trace_recorder.h"
+#include "common/json_string.h"
+#include <fstream>
+
+namespace yafaray_xml
+{
+
+size_t TraceRecorder::getThreadIndex()
+{
+	return thread_indices_.emplace(std::this_thread::get_id(), thread_indices_.size() + 1).first->second;
+}
+
+void TraceRecorder::addEvent(const char *category, const char *name, const std::string &detail, int64_t start_time)
+{
+	const int64_t end_time = getTimeMicroseconds();
+	std::string event_name{name};
+	if(!detail.empty()) event_name += " '" + detail + "'";
+	std::lock_guard<std::mutex> lock_guard{mutex_};
+	events_.push_back({category, std::move(event_name), start_time, end_time - start_time, getThreadIndex()});
+}
+
+void TraceRecorder::setThreadName(const std::string &thread_name)
+{
+	std::lock_guard<std::mutex> lock_guard{mutex_};
+	thread_names_[getThreadIndex()] = thread_name;
+}
+
+bool TraceRecorder::writeFile(const std::string &file_path) const
+{
+	std::ofstream file{file_path};
+	if(!file) return false;
+	std::lock_guard<std::mutex> lock_guard{mutex_};
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first_event = true;
+	for(const auto &[thread, thread_name] : thread_names_)
+	{
+		file << (first_event ? "" : ",\n") << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << thread << R"(,"args":{"name":)";
+		writeJsonString(file, thread_name);
+		file << "}}";
+		first_event = false;
+	}
+	for(const auto &event : events_)
+	{
+		file << (first_event ? "" : ",\n") << R"({"name":)";
+		writeJsonString(file, event.name_);
+		file << R"(,"cat":")" << event.category_ << R"(","ph":"X","ts":)" << event.start_time_ << R"(,"dur":)" << event.duration_ << R"(,"pid":1,"tid":)" << event.thread_ << '}';
+		first_event = false;
+	}
+	file << "\n]}\n";
+	return static_cast<bool>(file);
+}
+
+} //namespace yafaray_xml
@@ -0,0 +1,404 @@
+/****************************************************************************
+ *
+ *      This is part of the libYafaRay-Xml package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include "import/xml_tokenizer.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+namespace yafaray_xml
+{
+
+namespace
+{
+
+enum CharacterClass : uint8_t
+{
+	WhiteSpace = 1 << 0,
+	NameEnd = 1 << 1, //Characters ending element and attribute names, including the sentinel
+	ValueSpecial = 1 << 2, //Characters inside attribute values that need to be looked at, including the sentinel
+};
+
+constexpr std::array<uint8_t, 256> makeCharacterClasses()
+{
+	std::array<uint8_t, 256> character_classes{};
+	for(const unsigned char character : {' ', '\t', '\n', '\r'}) character_classes[character] |= WhiteSpace | NameEnd;
+	for(const unsigned char character : {'/', '>', '=', '<', '\0'}) character_classes[character] |= NameEnd;
+	for(const unsigned char character : {'\0', '"', '\'', '&', '<', '\t', '\n', '\r'}) character_classes[character] |= ValueSpecial;
+	return character_classes;
+}
+
+constexpr std::array<uint8_t, 256> character_classes{makeCharacterClasses()};
+
+inline bool isClass(char character, CharacterClass character_class)
+{
+	return (character_classes[static_cast<unsigned char>(character)] & character_class) != 0;
+}
+
+char *encodeUtf8(uint32_t code_point, char *destination)
+{
+	if(code_point < 0x80) *destination++ = static_cast<char>(code_point);
+	else if(code_point < 0x800)
+	{
+		*destination++ = static_cast<char>(0xC0 | (code_point >> 6));
+		*destination++ = static_cast<char>(0x80 | (code_point & 0x3F));
+	}
+	else if(code_point < 0x10000)
+	{
+		*destination++ = static_cast<char>(0xE0 | (code_point >> 12));
+		*destination++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+		*destination++ = static_cast<char>(0x80 | (code_point & 0x3F));
+	}
+	else
+	{
+		*destination++ = static_cast<char>(0xF0 | (code_point >> 18));
+		*destination++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+		*destination++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+		*destination++ = static_cast<char>(0x80 | (code_point & 0x3F));
+	}
+	return destination;
+}
+
+//! Writes the character of a predefined entity or character reference, given without its '&' and ';'
+bool decodeEntity(std::string_view entity, char *&destination)
+{
+	if(entity == "lt") *destination++ = '<';
+	else if(entity == "gt") *destination++ = '>';
+	else if(entity == "amp") *destination++ = '&';
+	else if(entity == "apos") *destination++ = '\'';
+	else if(entity == "quot") *destination++ = '"';
+	else if(entity.size() > 1 && entity[0] == '#')
+	{
+		const bool is_hexadecimal = entity[1] == 'x';
+		const char *const number = entity.data() + (is_hexadecimal ? 2 : 1);
+		const char *const number_end = entity.data() + entity.size();
+		uint32_t code_point = 0;
+		const std::from_chars_result result{std::from_chars(number, number_end, code_point, is_hexadecimal ? 16 : 10)};
+		if(result.ec != std::errc{} || result.ptr != number_end || code_point == 0 || code_point > 0x10FFFF) return false;
+		destination = encodeUtf8(code_point, destination);
+	}
+	else return false;
+	return true;
+}
+
+bool startsWith(const char *position, const char *data_end, std::string_view prefix)
+{
+	return static_cast<size_t>(data_end - position) >= prefix.size() && std::string_view{position, prefix.size()} == prefix;
+}
+
+} //namespace
+
+XmlTokenizer::XmlTokenizer(StartElementCb_t start_element, EndElementCb_t end_element, void *user_data) : start_element_{start_element}, end_element_{end_element}, user_data_{user_data}
+{
+}
+
+XmlTokenizer::Result XmlTokenizer::tokenize(char *data, size_t data_size, bool is_last_data, size_t &bytes_tokenized)
+{
+	const char *const data_end = data + data_size;
+	data[data_size] = '\0'; //Sentinel, so the scanning loops do not need to check for the end of the data
+	char *position = data;
+	if(data_offset_ == 0 && startsWith(data, data_end, "\xEF\xBB\xBF")) position += 3; //UTF-8 byte order mark
+	Result result = Result::NeedMoreData;
+	while(result == Result::NeedMoreData)
+	{
+		auto *markup = static_cast<char *>(std::memchr(position, '<', static_cast<size_t>(data_end - position)));
+		char *const text_end = markup ? markup : data + data_size;
+		if(!checkText(position, text_end))
+		{
+			result = Result::Error;
+			break;
+		}
+		position = text_end;
+		if(!markup) break;
+		bytes_consumed_ = data_offset_ + static_cast<size_t>(position - data);
+		Markup markup_result;
+		if(data_end - position < 2) markup_result = Markup::Incomplete;
+		else if(position[1] == '/') markup_result = tokenizeEndTag(position, data_end);
+		else if(position[1] == '?') markup_result = skipUntil(position, data_end, "?>");
+		else if(position[1] == '!')
+		{
+			if(startsWith(position, data_end, "<!--")) markup_result = skipUntil(position, data_end, "-->");
+			else if(startsWith(position, data_end, "<![CDATA[")) markup_result = skipUntil(position, data_end, "]]>");
+			else if(startsWith(position, data_end, "<!DOCTYPE")) markup_result = skipDoctype(position, data_end);
+			else if(data_end - position < 9) markup_result = Markup::Incomplete;
+			else
+			{
+				setError("Unsupported markup declaration");
+				markup_result = Markup::Invalid;
+			}
+		}
+		else markup_result = tokenizeStartTag(position, data_end);
+		if(markup_result == Markup::Invalid) result = Result::Error;
+		else if(markup_result == Markup::Incomplete) break;
+		else if(stopped_) result = Result::Stopped;
+	}
+	bytes_tokenized = static_cast<size_t>(position - data);
+	data_offset_ += bytes_tokenized;
+	bytes_consumed_ = data_offset_;
+	if(result == Result::NeedMoreData && is_last_data)
+	{
+		result = Result::Error;
+		if(position != data_end) setError("Premature end of data, the last tag is not complete");
+		else if(!root_element_found_) setError("Document is empty");
+		else if(!open_element_offsets_.empty()) setError("Premature end of data, element <" + open_elements_.substr(open_element_offsets_.back()) + "> not closed");
+		else result = Result::Finished;
+	}
+	return result;
+}
+
+bool XmlTokenizer::checkText(const char *text, const char *text_end)
+{
+	//Text is not used by the scenes, so it is only checked for the line numbers and for not being outside the root element
+	const bool is_outside_root = open_element_offsets_.empty();
+	for(; text < text_end; ++text)
+	{
+		if(*text == '\n') ++line_number_;
+		else if(is_outside_root && !isClass(*text, WhiteSpace))
+		{
+			setError(root_element_found_ ? "Extra content at the end of the document" : "Start tag expected, '<' not found");
+			return false;
+		}
+	}
+	return true;
+}
+
+XmlTokenizer::Markup XmlTokenizer::tokenizeStartTag(char *&position, const char *data_end)
+{
+	//The tag is only scanned until it is known to be complete, so an incomplete tag is left untouched for the next call
+	char *cursor = position + 1;
+	char *const name = cursor;
+	while(!isClass(*cursor, NameEnd)) ++cursor;
+	if(cursor == data_end) return Markup::Incomplete;
+	char *const name_end = cursor;
+	if(name_end == name)
+	{
+		setError("Invalid element name");
+		return Markup::Invalid;
+	}
+	if(root_element_found_ && open_element_offsets_.empty())
+	{
+		setError("Extra content at the end of the document");
+		return Markup::Invalid;
+	}
+	attributes_.clear();
+	int lines = 0;
+	bool is_empty_element = false;
+	while(true)
+	{
+		const char *const white_space_start = cursor;
+		for(; isClass(*cursor, WhiteSpace); ++cursor) lines += (*cursor == '\n');
+		if(cursor == data_end) return Markup::Incomplete;
+		if(*cursor == '>')
+		{
+			++cursor;
+			break;
+		}
+		if(*cursor == '/')
+		{
+			if(cursor + 1 == data_end) return Markup::Incomplete;
+			if(cursor[1] != '>')
+			{
+				setError("Expected '>' after '/' in the tag <" + std::string(name, name_end) + ">");
+				return Markup::Invalid;
+			}
+			cursor += 2;
+			is_empty_element = true;
+			break;
+		}
+		Attribute attribute;
+		attribute.name_ = cursor;
+		while(!isClass(*cursor, NameEnd)) ++cursor;
+		if(cursor == data_end) return Markup::Incomplete;
+		attribute.name_end_ = cursor;
+		if(attribute.name_ == attribute.name_end_ || attribute.name_ == white_space_start)
+		{
+			setError("Unexpected character '" + std::string(1, *attribute.name_) + "' in the tag <" + std::string(name, name_end) + ">");
+			return Markup::Invalid;
+		}
+		for(; isClass(*cursor, WhiteSpace); ++cursor) lines += (*cursor == '\n');
+		if(cursor == data_end) return Markup::Incomplete;
+		if(*cursor != '=')
+		{
+			setError("Expected '=' after the attribute '" + std::string(attribute.name_, attribute.name_end_) + "' of the tag <" + std::string(name, name_end) + ">");
+			return Markup::Invalid;
+		}
+		for(++cursor; isClass(*cursor, WhiteSpace); ++cursor) lines += (*cursor == '\n');
+		if(cursor == data_end) return Markup::Incomplete;
+		const char quote = *cursor;
+		if(quote != '"' && quote != '\'')
+		{
+			setError("Expected a quoted value for the attribute '" + std::string(attribute.name_, attribute.name_end_) + "' of the tag <" + std::string(name, name_end) + ">");
+			return Markup::Invalid;
+		}
+		attribute.value_ = ++cursor;
+		attribute.value_needs_decoding_ = false;
+		while(true)
+		{
+			while(!isClass(*cursor, ValueSpecial)) ++cursor;
+			if(*cursor == quote) break;
+			if(cursor == data_end) return Markup::Incomplete;
+			switch(*cursor)
+			{
+				case '<':
+				case '\0':
+					setError("Invalid character in the value of the attribute '" + std::string(attribute.name_, attribute.name_end_) + "' of the tag <" + std::string(name, name_end) + ">");
+					return Markup::Invalid;
+				case '\n': ++lines; [[fallthrough]];
+				case '\t':
+				case '\r':
+				case '&': attribute.value_needs_decoding_ = true; break;
+				default: break; //The other quote character
+			}
+			++cursor;
+		}
+		attribute.value_end_ = cursor++;
+		attributes_.push_back(attribute);
+	}
+	//The tag is complete, so its names and values can be terminated and decoded in place now
+	line_number_ += lines;
+	*name_end = '\0';
+	attrs_.clear();
+	for(Attribute &attribute : attributes_)
+	{
+		*attribute.name_end_ = '\0';
+		if(attribute.value_needs_decoding_ && !decodeValue(attribute)) return Markup::Invalid;
+		*attribute.value_end_ = '\0';
+		attrs_.push_back(attribute.name_);
+		attrs_.push_back(attribute.value_);
+	}
+	attrs_.push_back(nullptr);
+	position = cursor;
+	root_element_found_ = true;
+	start_element_(user_data_, name, attributes_.empty() ? nullptr : attrs_.data());
+	if(is_empty_element) end_element_(user_data_, name);
+	else
+	{
+		open_element_offsets_.push_back(open_elements_.size());
+		open_elements_.append(name, name_end);
+	}
+	return Markup::Complete;
+}
+
+XmlTokenizer::Markup XmlTokenizer::tokenizeEndTag(char *&position, const char *data_end)
+{
+	char *cursor = position + 2;
+	char *const name = cursor;
+	while(!isClass(*cursor, NameEnd)) ++cursor;
+	char *const name_end = cursor;
+	int lines = 0;
+	for(; isClass(*cursor, WhiteSpace); ++cursor) lines += (*cursor == '\n');
+	if(cursor == data_end) return Markup::Incomplete;
+	if(*cursor != '>')
+	{
+		setError("Expected '>' at the end of the tag </" + std::string(name, name_end) + ">");
+		return Markup::Invalid;
+	}
+	if(open_element_offsets_.empty() || open_elements_.compare(open_element_offsets_.back(), std::string::npos, name, static_cast<size_t>(name_end - name)) != 0)
+	{
+		setError("Opening and ending tag mismatch: <" + (open_element_offsets_.empty() ? std::string{} : open_elements_.substr(open_element_offsets_.back())) + "> and </" + std::string(name, name_end) + ">");
+		return Markup::Invalid;
+	}
+	line_number_ += lines;
+	*name_end = '\0';
+	open_elements_.resize(open_element_offsets_.back());
+	open_element_offsets_.pop_back();
+	position = cursor + 1;
+	end_element_(user_data_, name);
+	return Markup::Complete;
+}
+
+XmlTokenizer::Markup XmlTokenizer::skipUntil(char *&position, const char *data_end, const char *terminator)
+{
+	const std::string_view markup{position, static_cast<size_t>(data_end - position)};
+	const size_t terminator_position = markup.find(terminator, 2);
+	if(terminator_position == std::string_view::npos) return Markup::Incomplete;
+	const size_t markup_size = terminator_position + std::strlen(terminator);
+	line_number_ += static_cast<int>(std::count(position, position + markup_size, '\n'));
+	position += markup_size;
+	return Markup::Complete;
+}
+
+XmlTokenizer::Markup XmlTokenizer::skipDoctype(char *&position, const char *data_end)
+{
+	char *cursor = position;
+	while(cursor < data_end && *cursor != '>' && *cursor != '[') ++cursor;
+	if(cursor == data_end) return Markup::Incomplete;
+	if(*cursor == '[')
+	{
+		setError("DOCTYPE internal subsets are not supported by the built-in tokenizer");
+		return Markup::Invalid;
+	}
+	line_number_ += static_cast<int>(std::count(position, cursor, '\n'));
+	position = cursor + 1;
+	return Markup::Complete;
+}
+
+bool XmlTokenizer::decodeValue(Attribute &attribute)
+{
+	//Decoded values are never longer than the encoded ones, so they are written over them
+	const char *read = attribute.value_;
+	char *write = attribute.value_;
+	const char *const value_end = attribute.value_end_;
+	while(read < value_end)
+	{
+		const char character = *read;
+		if(character == '&')
+		{
+			const auto *entity_end = static_cast<const char *>(std::memchr(read, ';', static_cast<size_t>(value_end - read)));
+			if(!entity_end || !decodeEntity(std::string_view{read + 1, static_cast<size_t>(entity_end - read - 1)}, write))
+			{
+				setError("Invalid entity or character reference in the value of the attribute '" + std::string(attribute.name_) + "'");
+				return false;
+			}
+			read = entity_end + 1;
+		}
+		else if(character == '\r' && read + 1 < value_end && read[1] == '\n') ++read; //Line ends are normalized to a single '\n' before the attribute value normalization
+		else
+		{
+			*write++ = (character == '\t' || character == '\n' || character == '\r') ? ' ' : character;
+			++read;
+		}
+	}
+	attribute.value_end_ = write;
+	return true;
+}
+
+bool XmlTokenizer::isSupportedEncoding(const char *data, size_t data_size)
+{
+	if(data_size >= 2 && ((data[0] == '\xFE' && data[1] == '\xFF') || (data[0] == '\xFF' && data[1] == '\xFE'))) return false; //UTF-16 byte order marks
+	if(data_size >= 1 && data[0] == '\0') return false; //UTF-16 or UTF-32 without byte order mark
+	std::string_view document{data, data_size};
+	if(startsWith(data, data + data_size, "\xEF\xBB\xBF")) document.remove_prefix(3);
+	if(document.compare(0, 5, "<?xml") != 0) return true;
+	const std::string_view declaration{document.substr(0, document.find("?>"))};
+	const size_t encoding_position = declaration.find("encoding");
+	if(encoding_position == std::string_view::npos) return true;
+	const size_t quote_position = declaration.find_first_of("\"'", encoding_position);
+	if(quote_position == std::string_view::npos) return true; //Malformed declaration, left for the tokenizer to skip
+	const size_t encoding_end = declaration.find(declaration[quote_position], quote_position + 1);
+	std::string encoding{declaration.substr(quote_position + 1, encoding_end == std::string_view::npos ? std::string_view::npos : encoding_end - quote_position - 1)};
+	std::transform(encoding.begin(), encoding.end(), encoding.begin(), [](unsigned char character) { return static_cast<char>(std::toupper(character)); });
+	return encoding == "UTF-8" || encoding == "UTF8" || encoding == "US-ASCII" || encoding == "ASCII";
+}
+
+} //namespace yafaray_xml
@@ -18,21 +18,282 @@
 
 #include "public_api/yafaray_xml_c_api.h"
 #include "import/import_xml.h"
+#include "import/parse_control.h"
+#include "import/include_cache.h"
+#include "import/param_overrides.h"
+#include "import/parse_job.h"
 #include "common/version_build_info.h"
 #include <cstring>
 
 yafaray_Container *yafaray_xml_ParseFile(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma)
 {
-	auto [result, container]{yafaray_xml::XmlParser::parseXmlFile(yafaray_logger, xml_file_path, input_color_space, input_gamma)};
+	auto [result, container]{yafaray_xml::XmlParser::parseXmlFile(yafaray_logger, xml_file_path, input_color_space, input_gamma, yafaray_xml::ParseOptions{})};
+	return container;
+}
+
+yafaray_Container *yafaray_xml_ParseFileWithOptions(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options)
+{
+	const yafaray_xml::ParseOptions default_parse_options;
+	auto [result, container]{yafaray_xml::XmlParser::parseXmlFile(yafaray_logger, xml_file_path, input_color_space, input_gamma, parse_options ? *reinterpret_cast<const yafaray_xml::ParseOptions *>(parse_options) : default_parse_options)};
 	return container;
 }
 
 yafaray_Container *yafaray_xml_ParseMemory(yafaray_Logger *yafaray_logger, const char *xml_buffer, int xml_buffer_size, const char *input_color_space, float input_gamma)
 {
-	auto [result, container]{yafaray_xml::XmlParser::parseXmlMemory(yafaray_logger, xml_buffer, xml_buffer_size, input_color_space, input_gamma)};
+	if(xml_buffer_size <= 0)
+	{
+		yafaray_printError(yafaray_logger, "XMLParser: Error parsing a memory buffer, invalid buffer size");
+		return nullptr;
+	}
+	auto [result, container]{yafaray_xml::XmlParser::parseXmlMemory(yafaray_logger, xml_buffer, static_cast<size_t>(xml_buffer_size), input_color_space, input_gamma, yafaray_xml::ParseOptions{})};
+	return container;
+}
+
+yafaray_Container *yafaray_xml_ParseMemoryWithOptions(yafaray_Logger *yafaray_logger, const char *xml_buffer, size_t xml_buffer_size, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options)
+{
+	const yafaray_xml::ParseOptions default_parse_options;
+	auto [result, container]{yafaray_xml::XmlParser::parseXmlMemory(yafaray_logger, xml_buffer, xml_buffer_size, input_color_space, input_gamma, parse_options ? *reinterpret_cast<const yafaray_xml::ParseOptions *>(parse_options) : default_parse_options)};
+	return container;
+}
+
+yafaray_Container *yafaray_xml_ParseFiles(yafaray_Logger *yafaray_logger, const char *const *xml_file_paths, size_t number_of_files, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options)
+{
+	if(!xml_file_paths) return nullptr;
+	std::vector<std::string> file_paths;
+	for(size_t file_index = 0; file_index < number_of_files; ++file_index)
+	{
+		if(xml_file_paths[file_index]) file_paths.emplace_back(xml_file_paths[file_index]);
+	}
+	const yafaray_xml::ParseOptions default_parse_options;
+	auto [result, container]{yafaray_xml::XmlParser::parseXmlFiles(yafaray_logger, file_paths, input_color_space, input_gamma, parse_options ? *reinterpret_cast<const yafaray_xml::ParseOptions *>(parse_options) : default_parse_options)};
+	return container;
+}
+
+yafaray_xml_Parser *yafaray_xml_createParser(yafaray_Logger *yafaray_logger, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options)
+{
+	const yafaray_xml::ParseOptions default_parse_options;
+	return reinterpret_cast<yafaray_xml_Parser *>(new yafaray_xml::XmlParser(yafaray_logger, input_color_space, input_gamma, parse_options ? *reinterpret_cast<const yafaray_xml::ParseOptions *>(parse_options) : default_parse_options));
+}
+
+void yafaray_xml_destroyParser(yafaray_xml_Parser *parser)
+{
+	delete reinterpret_cast<yafaray_xml::XmlParser *>(parser);
+}
+
+yafaray_Container *yafaray_xml_ParseFileWithParser(yafaray_xml_Parser *parser, const char *xml_file_path)
+{
+	if(!parser) return nullptr;
+	auto [result, container]{reinterpret_cast<yafaray_xml::XmlParser *>(parser)->parseDocumentFile(xml_file_path)};
 	return container;
 }
 
+yafaray_Container *yafaray_xml_ParseMemoryWithParser(yafaray_xml_Parser *parser, const char *xml_buffer, size_t xml_buffer_size)
+{
+	if(!parser) return nullptr;
+	auto [result, container]{reinterpret_cast<yafaray_xml::XmlParser *>(parser)->parseDocumentMemory(xml_buffer, xml_buffer_size)};
+	return container;
+}
+
+yafaray_xml_ParseOptions *yafaray_xml_createParseOptions()
+{
+	return reinterpret_cast<yafaray_xml_ParseOptions *>(new yafaray_xml::ParseOptions());
+}
+
+void yafaray_xml_destroyParseOptions(yafaray_xml_ParseOptions *parse_options)
+{
+	delete reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options);
+}
+
+void yafaray_xml_setParseOptionConcurrentScenes(yafaray_xml_ParseOptions *parse_options, yafaray_Bool concurrent_scenes)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->concurrent_scenes_ = (concurrent_scenes == YAFARAY_BOOL_TRUE);
+}
+
+void yafaray_xml_setParseOptionPrefetchImageFiles(yafaray_xml_ParseOptions *parse_options, yafaray_Bool prefetch_image_files)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->prefetch_image_files_ = (prefetch_image_files == YAFARAY_BOOL_TRUE);
+}
+
+void yafaray_xml_setParseOptionProgressCallback(yafaray_xml_ParseOptions *parse_options, yafaray_xml_ParseProgressCallback progress_callback, void *callback_data)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->progress_callback_ = progress_callback;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->progress_callback_data_ = callback_data;
+}
+
+void yafaray_xml_setParseOptionParseControl(yafaray_xml_ParseOptions *parse_options, yafaray_xml_ParseControl *parse_control)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->parse_control_ = reinterpret_cast<yafaray_xml::ParseControl *>(parse_control);
+}
+
+yafaray_xml_ParseControl *yafaray_xml_createParseControl()
+{
+	return reinterpret_cast<yafaray_xml_ParseControl *>(new yafaray_xml::ParseControl());
+}
+
+void yafaray_xml_destroyParseControl(yafaray_xml_ParseControl *parse_control)
+{
+	delete reinterpret_cast<yafaray_xml::ParseControl *>(parse_control);
+}
+
+void yafaray_xml_cancelParsing(yafaray_xml_ParseControl *parse_control)
+{
+	if(!parse_control) return;
+	reinterpret_cast<yafaray_xml::ParseControl *>(parse_control)->cancel();
+}
+
+void yafaray_xml_resetParseControl(yafaray_xml_ParseControl *parse_control)
+{
+	if(!parse_control) return;
+	reinterpret_cast<yafaray_xml::ParseControl *>(parse_control)->reset();
+}
+
+void yafaray_xml_setParseOptionIncludeCache(yafaray_xml_ParseOptions *parse_options, yafaray_xml_IncludeCache *include_cache)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->include_cache_ = reinterpret_cast<yafaray_xml::IncludeCache *>(include_cache);
+}
+
+yafaray_xml_IncludeCache *yafaray_xml_createIncludeCache()
+{
+	return reinterpret_cast<yafaray_xml_IncludeCache *>(new yafaray_xml::IncludeCache());
+}
+
+void yafaray_xml_destroyIncludeCache(yafaray_xml_IncludeCache *include_cache)
+{
+	delete reinterpret_cast<yafaray_xml::IncludeCache *>(include_cache);
+}
+
+void yafaray_xml_clearIncludeCache(yafaray_xml_IncludeCache *include_cache)
+{
+	if(!include_cache) return;
+	reinterpret_cast<yafaray_xml::IncludeCache *>(include_cache)->clear();
+}
+
+void yafaray_xml_setParseOptionDeduplicateGeometry(yafaray_xml_ParseOptions *parse_options, yafaray_Bool deduplicate_geometry)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->deduplicate_geometry_ = (deduplicate_geometry == YAFARAY_BOOL_TRUE);
+}
+
+void yafaray_xml_setParseOptionDeduplicateResources(yafaray_xml_ParseOptions *parse_options, yafaray_Bool deduplicate_resources)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->deduplicate_resources_ = (deduplicate_resources == YAFARAY_BOOL_TRUE);
+}
+
+void yafaray_xml_setParseOptionTraceFile(yafaray_xml_ParseOptions *parse_options, const char *trace_file_path)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->trace_file_path_ = trace_file_path ? trace_file_path : "";
+}
+
+yafaray_Bool yafaray_xml_setParseOptionParamOverride(yafaray_xml_ParseOptions *parse_options, const char *param_override)
+{
+	if(!parse_options || !param_override || !yafaray_xml::ParamOverrides::isWellFormed(param_override)) return YAFARAY_BOOL_FALSE;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->param_overrides_.emplace_back(param_override);
+	return YAFARAY_BOOL_TRUE;
+}
+
+void yafaray_xml_setParseOptionFilmRegion(yafaray_xml_ParseOptions *parse_options, size_t region_index, size_t regions, const char *manifest_path)
+{
+	if(!parse_options) return;
+	auto &options{*reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)};
+	options.film_region_index_ = region_index;
+	options.film_regions_ = regions;
+	options.film_region_manifest_path_ = manifest_path ? manifest_path : "";
+}
+
+void yafaray_xml_setParseOptionProgressiveLoading(yafaray_xml_ParseOptions *parse_options, yafaray_xml_ProgressiveLoadCallback progressive_load_callback, void *callback_data, size_t objects_per_step, int step_time_ms)
+{
+	if(!parse_options) return;
+	auto &options{*reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)};
+	options.progressive_load_callback_ = progressive_load_callback;
+	options.progressive_load_callback_data_ = callback_data;
+	options.progressive_load_objects_per_step_ = objects_per_step;
+	options.progressive_load_step_time_ms_ = step_time_ms;
+}
+
+void yafaray_xml_setParseOptionFilmCallback(yafaray_xml_ParseOptions *parse_options, yafaray_xml_FilmCallback film_callback, void *callback_data)
+{
+	if(!parse_options) return;
+	auto &options{*reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)};
+	options.film_callback_ = film_callback;
+	options.film_callback_data_ = callback_data;
+}
+
+void yafaray_xml_setParseOptionBuiltinTokenizer(yafaray_xml_ParseOptions *parse_options, yafaray_Bool builtin_tokenizer)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->builtin_tokenizer_ = (builtin_tokenizer == YAFARAY_BOOL_TRUE);
+}
+
+void yafaray_xml_setParseOptionArenaAllocation(yafaray_xml_ParseOptions *parse_options, yafaray_Bool arena_allocation)
+{
+	if(!parse_options) return;
+	reinterpret_cast<yafaray_xml::ParseOptions *>(parse_options)->arena_allocation_ = (arena_allocation == YAFARAY_BOOL_TRUE);
+}
+
+yafaray_xml_ParseJob *yafaray_xml_startParseFile(yafaray_Logger *yafaray_logger, const char *xml_file_path, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options)
+{
+	if(!xml_file_path) return nullptr;
+	const yafaray_xml::ParseOptions default_parse_options;
+	return reinterpret_cast<yafaray_xml_ParseJob *>(new yafaray_xml::ParseJob(yafaray_logger, xml_file_path, nullptr, 0, input_color_space, input_gamma, parse_options ? *reinterpret_cast<const yafaray_xml::ParseOptions *>(parse_options) : default_parse_options));
+}
+
+yafaray_xml_ParseJob *yafaray_xml_startParseMemory(yafaray_Logger *yafaray_logger, const char *xml_buffer, size_t xml_buffer_size, const char *input_color_space, float input_gamma, const yafaray_xml_ParseOptions *parse_options)
+{
+	if(!xml_buffer) return nullptr;
+	const yafaray_xml::ParseOptions default_parse_options;
+	return reinterpret_cast<yafaray_xml_ParseJob *>(new yafaray_xml::ParseJob(yafaray_logger, "", xml_buffer, xml_buffer_size, input_color_space, input_gamma, parse_options ? *reinterpret_cast<const yafaray_xml::ParseOptions *>(parse_options) : default_parse_options));
+}
+
+yafaray_xml_ParseJobStatus yafaray_xml_getParseJobStatus(const yafaray_xml_ParseJob *parse_job)
+{
+	if(!parse_job) return YAFARAY_XML_PARSE_JOB_FAILED;
+	switch(reinterpret_cast<const yafaray_xml::ParseJob *>(parse_job)->getStatus())
+	{
+		case yafaray_xml::ParseJob::Status::Running: return YAFARAY_XML_PARSE_JOB_RUNNING;
+		case yafaray_xml::ParseJob::Status::Succeeded: return YAFARAY_XML_PARSE_JOB_SUCCEEDED;
+		case yafaray_xml::ParseJob::Status::Cancelled: return YAFARAY_XML_PARSE_JOB_CANCELLED;
+		default: return YAFARAY_XML_PARSE_JOB_FAILED;
+	}
+}
+
+yafaray_Bool yafaray_xml_waitParseJob(yafaray_xml_ParseJob *parse_job, int timeout_ms)
+{
+	if(!parse_job) return YAFARAY_BOOL_TRUE;
+	return reinterpret_cast<yafaray_xml::ParseJob *>(parse_job)->wait(std::chrono::milliseconds{timeout_ms}) ? YAFARAY_BOOL_TRUE : YAFARAY_BOOL_FALSE;
+}
+
+void yafaray_xml_getParseJobProgress(const yafaray_xml_ParseJob *parse_job, size_t *bytes_parsed, size_t *bytes_total)
+{
+	size_t parsed = 0, total = 0;
+	if(parse_job) reinterpret_cast<const yafaray_xml::ParseJob *>(parse_job)->getProgress(parsed, total);
+	if(bytes_parsed) *bytes_parsed = parsed;
+	if(bytes_total) *bytes_total = total;
+}
+
+void yafaray_xml_cancelParseJob(yafaray_xml_ParseJob *parse_job)
+{
+	if(!parse_job) return;
+	reinterpret_cast<yafaray_xml::ParseJob *>(parse_job)->cancel();
+}
+
+yafaray_Container *yafaray_xml_takeParseJobContainer(yafaray_xml_ParseJob *parse_job)
+{
+	if(!parse_job) return nullptr;
+	return reinterpret_cast<yafaray_xml::ParseJob *>(parse_job)->takeContainer();
+}
+
+void yafaray_xml_destroyParseJob(yafaray_xml_ParseJob *parse_job)
+{
+	delete reinterpret_cast<yafaray_xml::ParseJob *>(parse_job);
+}
+
 char *createCString(const std::string &std_string)
 {
 	const size_t string_size = std_string.size();